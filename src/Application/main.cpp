@@ -1,9 +1,46 @@
 #include "window/MainWindow.h"
+#include "PixelDepth.h"
+#include "ProcessingGraph.h"
 
 #include <QFile>
 #include <QApplication>
+#include <opencv2/imgcodecs.hpp>
+#include <iostream>
+
+/**
+ * @brief Applies a processing graph to an image file, without opening a window.
+ * @details 16-bit and float images are processed and written at their own depth.
+ * @return The exit code of the application.
+ */
+static int runHeadless(const std::string& graphPath, const std::string& inputPath, const std::string& outputPath) {
+	try {
+		ProcessingGraph graph;
+		graph.deserialize(graphPath);
+
+		cv::Mat image = cv::imread(inputPath, cv::IMREAD_UNCHANGED);
+		if (image.empty() || !PixelDepth::supported(image.depth())) {
+			std::cerr << "Couldn't read an 8-bit, 16-bit or float image from " << inputPath << std::endl;
+			return 1;
+		}
+
+		graph.run(image);
+		if (!cv::imwrite(outputPath, image)) {
+			std::cerr << "Couldn't write " << outputPath << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+}
 
 int main(int argc, char* argv[]) {
+	// Detection App --graph <graph.yaml> <input image> <output image>
+	if (argc == 5 && std::string(argv[1]) == "--graph")
+		return runHeadless(argv[2], argv[3], argv[4]);
+
 	QApplication app(argc, argv);
 
 	MainWindow window;
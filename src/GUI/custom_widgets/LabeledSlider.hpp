@@ -5,6 +5,7 @@
 #include <QSlider>
 #include <QGridLayout>
 #include <QGraphicsScene>
+#include <QTimer>
 
 class LabeledSlider : public QWidget {
 	Q_OBJECT
@@ -13,11 +14,24 @@ private:
 	QSlider* slider;
 	QLabel* label;
 	bool isPercent;
+	QTimer* idleTimer;
+	bool settlePending = false;
 
 public:
-	enum SignalMode { OnRelease, OnChange };
+	/**
+	 * @brief When valueChanged() is emitted.
+	 * @details OnRelease emits it once the slider is released, OnChange for every intermediate value.
+	 Progressive emits it for every intermediate value, like OnChange, and also emits settled() once the value stops changing,
+	 so that a cheap preview can follow the slider and the full work is only done for the value the user stops at.
+	 */
+	enum SignalMode { OnRelease, OnChange, Progressive };
 	SignalMode signalMode;
 
+	/**
+	 * @brief How long the value of a Progressive slider has to stay still before it settles, in milliseconds.
+	 */
+	static const int SETTLE_DELAY = 150;
+
 	/**
 	 * @brief Constructs a LabeledSlider object.
 	 * @details This constructor initializes a LabeledSlider object with the provided parameters.
@@ -55,7 +69,11 @@ public:
 		vbox->addWidget(slider);
 		this->setLayout(vbox);
 
-		connect(slider, QOverload<int>::of(&QSlider::valueChanged), this, &LabeledSlider::valueChanged);
+		idleTimer = new QTimer(this);
+		idleTimer->setSingleShot(true);
+		idleTimer->setInterval(SETTLE_DELAY);
+		connect(idleTimer, &QTimer::timeout, this, &LabeledSlider::settle);
+
 		connect(slider, &QSlider::valueChanged, this, [&] {
 			switch (signalMode) {
 			case OnChange:
@@ -68,6 +86,25 @@ public:
 					emit valueChanged(value());
 				}
 				break;
+			case Progressive:
+				changeLabelValue();
+				emit valueChanged(value());
+				settlePending = true;
+				idleTimer->start();
+				break;
+			}
+			});
+		connect(slider, &QSlider::sliderReleased, this, [&] {
+			switch (signalMode) {
+			case OnRelease:
+				changeLabelValue();
+				emit valueChanged(value());
+				break;
+			case Progressive:
+				settle();
+				break;
+			default:
+				break;
 			}
 			});
 
@@ -106,6 +143,22 @@ protected:
 		label->setText(text);
 	}
 
+	/**
+	 * @brief Emits settled() for the last value of a Progressive slider, once per run of changes.
+	 */
+	void settle() {
+		if (!settlePending)
+			return;
+		settlePending = false;
+		idleTimer->stop();
+		emit settled(value());
+	}
+
 signals:
 	void valueChanged(int x);
+
+	/**
+	 * @brief Emitted in Progressive mode when the slider is released or its value has not changed for SETTLE_DELAY.
+	 */
+	void settled(int x);
 };
@@ -16,9 +16,28 @@ Menu::Menu(QWidget* parent)
 	screenshot = new QPushButton("Save screenshot");
 	showConfidence = new QCheckBox("Show confidences");
 	confControl = new LabeledSlider("Min confidence", 1, 99, 5, true);
+	detectionIntervalControl = new LabeledSlider("Video detection interval (0 = every frame)", 0, 30, 1);
 	thresholdControl = new LabeledSlider("Threshold", 1, 250, 10);
 	cannyThresholdControl = new LabeledSlider("Threshold", 1, 250, 5);
 	kernelSizeControl = new LabeledSlider("Kernel", 1, 10, 2);
+	adaptiveBlockSizeControl = new LabeledSlider("Block size", 3, 101, 2);
+	adaptiveBlockSizeControl->setInitialValue(11);
+	adaptiveCControl = new LabeledSlider("C", -20, 20, 1);
+	adaptiveCControl->setInitialValue(2);
+	claheTilesControl = new LabeledSlider("Tiles", 1, 16, 1);
+	claheTilesControl->setInitialValue(8);
+	claheClipLimitControl = new LabeledSlider("Clip limit (tenths)", 0, 100, 5);
+	claheClipLimitControl->setInitialValue(20);
+	autoThresholdMethodControl = new LabeledSlider("Method", 0, 4, 1);
+	autoThresholdMethodControl->setInitialValue(1);
+	autoThresholdPercentileControl = new LabeledSlider("Percentile", 0, 100, 5);
+	autoThresholdPercentileControl->setInitialValue(50);
+	autoThresholdSmoothingControl = new LabeledSlider("Video smoothing (%)", 0, 95, 5);
+	autoThresholdSmoothingControl->setInitialValue(50);
+	equalizationStrideControl = new LabeledSlider("Video sampling stride", 1, 16, 1);
+	equalizationStrideControl->setInitialValue(4);
+	equalizationDriftControl = new LabeledSlider("Video table drift (tenths of %)", 0, 100, 5);
+	equalizationDriftControl->setInitialValue(10);
 	uploadButton = new QPushButton("Upload image");
 
 	classButtons = new CollapsibleWidget("Classes");
@@ -35,10 +54,14 @@ Menu::Menu(QWidget* parent)
 	grayscaleHistogramEqualizationButton->setCheckable(true);
 	colorHistogramEqualizationButton = new QPushButton("Color Histogram Equalization", imageAlgorithms);
 	colorHistogramEqualizationButton->setCheckable(true);
+	claheButton = new QPushButton("CLAHE", imageAlgorithms);
+	claheButton->setCheckable(true);
 	sobelButton = new QPushButton("Sobel", imageAlgorithms);
 	sobelButton->setCheckable(true);
 	triangleThresholdingButton = new QPushButton("Triangle Thresholding", imageAlgorithms);
 	triangleThresholdingButton->setCheckable(true);
+	autoThresholdingButton = new QPushButton("Auto Thresholding", imageAlgorithms);
+	autoThresholdingButton->setCheckable(true);
 	binomialButton = new QPushButton("Binomial", imageAlgorithms);
 	binomialButton->setCheckable(true);
 	cannyButton = new QPushButton("Canny", imageAlgorithms);
@@ -55,8 +78,10 @@ Menu::Menu(QWidget* parent)
 	algVbox->addWidget(adaptiveThresholdingButton);
 	algVbox->addWidget(grayscaleHistogramEqualizationButton);
 	algVbox->addWidget(colorHistogramEqualizationButton);
+	algVbox->addWidget(claheButton);
 	algVbox->addWidget(sobelButton);
 	algVbox->addWidget(triangleThresholdingButton);
+	algVbox->addWidget(autoThresholdingButton);
 	algVbox->addWidget(binomialButton);
 	algVbox->addWidget(cannyButton);
 	algVbox->addWidget(openingButton);
@@ -151,9 +176,19 @@ Menu::Menu(QWidget* parent)
 
 	vbox->addWidget(showConfidence);
 	vbox->addWidget(confControl);
+	vbox->addWidget(detectionIntervalControl);
 	vbox->addWidget(thresholdControl);
 	vbox->addWidget(cannyThresholdControl);
 	vbox->addWidget(kernelSizeControl);
+	vbox->addWidget(adaptiveBlockSizeControl);
+	vbox->addWidget(adaptiveCControl);
+	vbox->addWidget(claheTilesControl);
+	vbox->addWidget(claheClipLimitControl);
+	vbox->addWidget(autoThresholdMethodControl);
+	vbox->addWidget(autoThresholdPercentileControl);
+	vbox->addWidget(autoThresholdSmoothingControl);
+	vbox->addWidget(equalizationStrideControl);
+	vbox->addWidget(equalizationDriftControl);
 
 	vbox->addStretch(1); // add spacing so the next controls will appear at the bottom of the menu
 	vbox->addWidget(uploadButton);
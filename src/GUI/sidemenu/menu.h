@@ -15,9 +15,19 @@ public:
 	QComboBox* detectorsList;
 	QPushButton* screenshot;
 	LabeledSlider* confControl;
+	LabeledSlider* detectionIntervalControl;
 	LabeledSlider* thresholdControl;
 	LabeledSlider* kernelSizeControl;
 	LabeledSlider* cannyThresholdControl;
+	LabeledSlider* adaptiveBlockSizeControl;
+	LabeledSlider* adaptiveCControl;
+	LabeledSlider* claheTilesControl;
+	LabeledSlider* claheClipLimitControl;
+	LabeledSlider* autoThresholdMethodControl;
+	LabeledSlider* autoThresholdPercentileControl;
+	LabeledSlider* autoThresholdSmoothingControl;
+	LabeledSlider* equalizationStrideControl;
+	LabeledSlider* equalizationDriftControl;
 	QPushButton* uploadButton;
 
 	QPushButton* magnifier;
@@ -45,8 +55,10 @@ public:
 	QPushButton* adaptiveThresholdingButton;
 	QPushButton* grayscaleHistogramEqualizationButton;
 	QPushButton* colorHistogramEqualizationButton;
+	QPushButton* claheButton;
 	QPushButton* sobelButton;
 	QPushButton* triangleThresholdingButton;
+	QPushButton* autoThresholdingButton;
 	QPushButton* binomialButton;
 	QPushButton* cannyButton;
 	QPushButton* openingButton;
@@ -7,18 +7,50 @@
 #include "NeuralNetworkDetector.h"
 #include "CascadeClassifierDetector.h"
 #include "CascadeClassifierGroup.h"
+#include "CaptureThread.h"
+#include "FramePipeline.h"
+#include "SpscRing.h"
+#include "AsyncDetector.h"
+#include "ToneMap.h"
 
+#include <algorithm>
 #include <iostream>
 
+// the live pipeline may still be detecting with a detector the window lets go of, so the last one to hold it saves and deletes it
+static std::shared_ptr<Detector> ownDetector(Detector* detector) {
+	return std::shared_ptr<Detector>(detector, [](Detector* det) {
+		try {
+			if (!det->getSerializationFile().empty())
+				det->serialize(det->getSerializationFile());
+		}
+		catch (const std::exception& e) {
+			std::cerr << e.what() << std::endl;
+		}
+		delete det;
+		});
+}
+
 void MainWindow::closeEvent(QCloseEvent* event) {
+	// the close comes through the events the camera loop processes: the loop stops its threads first, then closes the window again
+	if (videoRunning) {
+		cameraIsOn = false;
+		closeRequested = true;
+		event->ignore();
+		return;
+	}
 	if (currDet != nullptr && !currDet->getSerializationFile().empty())
 		currDet->serialize(currDet->getSerializationFile());
+	stopRefinements();
 	// close the entire application
 	qApp->closeAllWindows();
 	qApp->exit(0);
 	exit(0);
 }
 
+MainWindow::~MainWindow() {
+	stopRefinements();
+}
+
 MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
 	// instantiate the list of detectors
 	this->currDet = nullptr;
@@ -47,6 +79,72 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
 	connect(menu->thresholdControl, &LabeledSlider::valueChanged, this, &MainWindow::changeThresholdEvent);
 	connect(menu->kernelSizeControl, &LabeledSlider::valueChanged, this, &MainWindow::changeKernelSizeEvent);
 	connect(menu->cannyThresholdControl, &LabeledSlider::valueChanged, this, &MainWindow::changeThresholdEvent);
+	connect(menu->adaptiveBlockSizeControl, &LabeledSlider::valueChanged, this, [&] {
+		history.add(ADAPTIVE_BLOCK_SIZE, menu->adaptiveBlockSizeControl->value());
+		statusBar->showMessage(QString("Applied adaptive block size: %1").arg(menu->adaptiveBlockSizeControl->value()));
+		if (imageIsUpload)
+			previewImage();
+		});
+	connect(menu->adaptiveCControl, &LabeledSlider::valueChanged, this, [&] {
+		history.add(ADAPTIVE_C, menu->adaptiveCControl->value());
+		statusBar->showMessage(QString("Applied adaptive constant: %1").arg(menu->adaptiveCControl->value()));
+		if (imageIsUpload)
+			previewImage();
+		});
+	connect(menu->claheTilesControl, &LabeledSlider::valueChanged, this, [&] {
+		history.add(CLAHE_TILES, menu->claheTilesControl->value());
+		statusBar->showMessage(QString("Applied CLAHE tiles: %1").arg(menu->claheTilesControl->value()));
+		if (imageIsUpload)
+			previewImage();
+		});
+	connect(menu->claheClipLimitControl, &LabeledSlider::valueChanged, this, [&] {
+		history.add(CLAHE_CLIP_LIMIT, menu->claheClipLimitControl->value());
+		statusBar->showMessage(QString("Applied CLAHE clip limit: %1").arg(menu->claheClipLimitControl->value() / 10.0));
+		if (imageIsUpload)
+			previewImage();
+		});
+	connect(menu->autoThresholdMethodControl, &LabeledSlider::valueChanged, this, [&] {
+		history.add(AUTO_THRESHOLD_METHOD, menu->autoThresholdMethodControl->value());
+		statusBar->showMessage(QString("Applied auto thresholding method: %1")
+			.arg(AutoThreshold::methodName(static_cast<AutoThreshold::Method>(menu->autoThresholdMethodControl->value()))));
+		{
+			// the preprocessing stage of the camera may be using the state of the stream
+			std::lock_guard<std::mutex> guard(videoLock);
+			video.threshold.reset();
+		}
+		if (imageIsUpload)
+			previewImage();
+		});
+	connect(menu->autoThresholdPercentileControl, &LabeledSlider::valueChanged, this, [&] {
+		history.add(AUTO_THRESHOLD_PERCENTILE, menu->autoThresholdPercentileControl->value());
+		statusBar->showMessage(QString("Applied auto thresholding percentile: %1").arg(menu->autoThresholdPercentileControl->value()));
+		if (imageIsUpload)
+			previewImage();
+		});
+	connect(menu->autoThresholdSmoothingControl, &LabeledSlider::valueChanged, this, [&] {
+		history.add(AUTO_THRESHOLD_SMOOTHING, menu->autoThresholdSmoothingControl->value());
+		statusBar->showMessage(QString("Applied auto thresholding smoothing: %1%").arg(menu->autoThresholdSmoothingControl->value()));
+		});
+	connect(menu->equalizationStrideControl, &LabeledSlider::valueChanged, this, [&] {
+		history.add(EQUALIZATION_STRIDE, menu->equalizationStrideControl->value());
+		statusBar->showMessage(QString("Applied equalization sampling stride: %1").arg(menu->equalizationStrideControl->value()));
+		});
+	connect(menu->equalizationDriftControl, &LabeledSlider::valueChanged, this, [&] {
+		history.add(EQUALIZATION_DRIFT, menu->equalizationDriftControl->value());
+		statusBar->showMessage(QString("Applied equalization table drift: %1%").arg(menu->equalizationDriftControl->value() / 10.0));
+		});
+	connect(menu->detectionIntervalControl, &LabeledSlider::valueChanged, this, [&] {
+		history.add(DETECTION_INTERVAL, menu->detectionIntervalControl->value());
+		statusBar->showMessage(menu->detectionIntervalControl->value() == 0 ? QString("Detecting every frame")
+			: QString("Detecting in the background, at most every %1 frames").arg(menu->detectionIntervalControl->value()));
+		});
+
+	// the processing sliders show a downscaled preview while they move and the full resolution once they settle
+	for (LabeledSlider* slider : { menu->thresholdControl, menu->kernelSizeControl, menu->cannyThresholdControl, menu->adaptiveBlockSizeControl, menu->adaptiveCControl,
+		menu->claheTilesControl, menu->claheClipLimitControl, menu->autoThresholdMethodControl, menu->autoThresholdPercentileControl }) {
+		slider->signalMode = LabeledSlider::Progressive;
+		connect(slider, &LabeledSlider::settled, this, &MainWindow::refineImage);
+	}
 	connect(menu->showConfidence, &QCheckBox::clicked, this, [&] {
 		history.add(SHOW_CONFIDENCE, menu->showConfidence->isChecked());
 		statusBar->showMessage(QString("Toggled show confidences %1").arg(menu->showConfidence->isChecked() ? "on" : "off"));
@@ -55,11 +153,24 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
 
 	connect(menu->grayscaleHistogramEqualizationButton, &QPushButton::clicked, this, [&] {
 		history.add(GRAYSCALE_HISTOGRAM_EQUALIZATION, menu->grayscaleHistogramEqualizationButton->isChecked());
+		{
+			std::lock_guard<std::mutex> guard(videoLock);
+			video.grayEqualizer.reset();
+		}
 		processImage();
 		});
 
 	connect(menu->colorHistogramEqualizationButton, &QPushButton::clicked, this, [&] {
 		history.add(COLOR_HISTOGRAM_EQUALIZATION, menu->colorHistogramEqualizationButton->isChecked());
+		{
+			std::lock_guard<std::mutex> guard(videoLock);
+			video.colorEqualizer.reset();
+		}
+		processImage();
+		});
+
+	connect(menu->claheButton, &QPushButton::clicked, this, [&] {
+		history.add(CLAHE, menu->claheButton->isChecked());
 		processImage();
 		});
 
@@ -103,6 +214,15 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
 		processImage();
 		});
 
+	connect(menu->autoThresholdingButton, &QPushButton::clicked, this, [&] {
+		history.add(AUTO_THRESHOLDING, menu->autoThresholdingButton->isChecked());
+		{
+			std::lock_guard<std::mutex> guard(videoLock);
+			video.threshold.reset();
+		}
+		processImage();
+		});
+
 	connect(menu->triangleThresholdingButton, &QPushButton::clicked, this, [&] {
 		history.add(TRIANGLE_THRESHOLDING, menu->triangleThresholdingButton->isChecked());
 		processImage();
@@ -228,12 +348,24 @@ void MainWindow::setOptions()
 	menu->toggleCamera->setText("   Turn Camera " + QString(cameraIsOn ? "Off" : "On"));
 	menu->showConfidence->setVisible((cameraIsOn || imageIsUpload) && currDet != nullptr && currDet->toThresholdAdjuster());
 	menu->confControl->setVisible((cameraIsOn || imageIsUpload) && currDet != nullptr && currDet->toThresholdAdjuster());
+	menu->detectionIntervalControl->setVisible(cameraIsOn && currDet != nullptr);
 	menu->flipHorizontal->setEnabled(cameraIsOn || imageIsUpload);
 	menu->flipVertical->setEnabled(cameraIsOn || imageIsUpload);
 	menu->screenshot->setVisible(cameraIsOn || imageIsUpload);
 	menu->thresholdControl->setVisible((cameraIsOn || imageIsUpload) && thresholdActive());
 	menu->kernelSizeControl->setVisible((cameraIsOn || imageIsUpload) && kernelActive());
 	menu->cannyThresholdControl->setVisible((cameraIsOn || imageIsUpload) && menu->cannyButton->isChecked());
+	menu->adaptiveBlockSizeControl->setVisible((cameraIsOn || imageIsUpload) && menu->adaptiveThresholdingButton->isChecked());
+	menu->adaptiveCControl->setVisible((cameraIsOn || imageIsUpload) && menu->adaptiveThresholdingButton->isChecked());
+	menu->claheTilesControl->setVisible((cameraIsOn || imageIsUpload) && menu->claheButton->isChecked());
+	menu->claheClipLimitControl->setVisible((cameraIsOn || imageIsUpload) && menu->claheButton->isChecked());
+	menu->autoThresholdMethodControl->setVisible((cameraIsOn || imageIsUpload) && menu->autoThresholdingButton->isChecked());
+	menu->autoThresholdPercentileControl->setVisible((cameraIsOn || imageIsUpload) && menu->autoThresholdingButton->isChecked());
+	menu->autoThresholdSmoothingControl->setVisible(cameraIsOn && menu->autoThresholdingButton->isChecked());
+	menu->equalizationStrideControl->setVisible(cameraIsOn
+		&& (menu->grayscaleHistogramEqualizationButton->isChecked() || menu->colorHistogramEqualizationButton->isChecked()));
+	menu->equalizationDriftControl->setVisible(cameraIsOn
+		&& (menu->grayscaleHistogramEqualizationButton->isChecked() || menu->colorHistogramEqualizationButton->isChecked()));
 	menu->magnifier->setVisible(cameraIsOn || imageIsUpload);
 	menu->zoomIn->setEnabled(imageIsUpload);
 	menu->zoomOut->setEnabled(imageIsUpload && (imageContainer->getZoomCount() > 0));
@@ -251,12 +383,38 @@ void MainWindow::setOptions()
 	menu->adaptiveThresholdingButton->setChecked(history.get()->getAdaptiveThresholdingValue());
 	menu->grayscaleHistogramEqualizationButton->setChecked(history.get()->getGrayscaleHistogramEqualization());
 	menu->colorHistogramEqualizationButton->setChecked(history.get()->getColorHistogramEqualization());
+	menu->claheButton->setChecked(history.get()->getClahe());
 	menu->sobelButton->setChecked(history.get()->getSobel());
 	menu->triangleThresholdingButton->setChecked(history.get()->getTriangleThresholding());
+	menu->autoThresholdingButton->setChecked(history.get()->getAutoThresholding());
 	menu->binomialButton->setChecked(history.get()->getBinomial());
 	menu->cannyButton->setChecked(history.get()->getCanny());
 	menu->openingButton->setChecked(history.get()->getOpening());
 
+	// follow undo/redo without recording the slider moves as new changes
+	{
+		QSignalBlocker blockSizeBlocker(menu->adaptiveBlockSizeControl);
+		QSignalBlocker cBlocker(menu->adaptiveCControl);
+		QSignalBlocker tilesBlocker(menu->claheTilesControl);
+		QSignalBlocker clipLimitBlocker(menu->claheClipLimitControl);
+		QSignalBlocker methodBlocker(menu->autoThresholdMethodControl);
+		QSignalBlocker percentileBlocker(menu->autoThresholdPercentileControl);
+		QSignalBlocker smoothingBlocker(menu->autoThresholdSmoothingControl);
+		QSignalBlocker strideBlocker(menu->equalizationStrideControl);
+		QSignalBlocker driftBlocker(menu->equalizationDriftControl);
+		QSignalBlocker intervalBlocker(menu->detectionIntervalControl);
+		menu->adaptiveBlockSizeControl->setInitialValue(history.get()->getAdaptiveBlockSize());
+		menu->adaptiveCControl->setInitialValue(history.get()->getAdaptiveC());
+		menu->claheTilesControl->setInitialValue(history.get()->getClaheTiles());
+		menu->claheClipLimitControl->setInitialValue(history.get()->getClaheClipLimit());
+		menu->autoThresholdMethodControl->setInitialValue(history.get()->getAutoThresholdMethod());
+		menu->autoThresholdPercentileControl->setInitialValue(history.get()->getAutoThresholdPercentile());
+		menu->autoThresholdSmoothingControl->setInitialValue(history.get()->getAutoThresholdSmoothing());
+		menu->equalizationStrideControl->setInitialValue(history.get()->getEqualizationStride());
+		menu->equalizationDriftControl->setInitialValue(history.get()->getEqualizationDrift());
+		menu->detectionIntervalControl->setInitialValue(history.get()->getDetectionInterval());
+	}
+
 	menu->binaryThresholdingButton->setEnabled(
 		!menu->zeroThresholdingButton->isChecked() &&
 		!menu->adaptiveThresholdingButton->isChecked()
@@ -275,8 +433,8 @@ void MainWindow::setOptions()
 
 	menu->classButtons->setVisible((cameraIsOn || imageIsUpload) && currDet != nullptr && currDet->toObjectToggler());
 
-	menu->detectedLabel->setVisible(!dynamic_cast<CascadeClassifierGroup*>(currDet));
-	menu->undetectedLabel->setVisible(!dynamic_cast<CascadeClassifierGroup*>(currDet));
+	menu->detectedLabel->setVisible(!dynamic_cast<CascadeClassifierGroup*>(currDet.get()));
+	menu->undetectedLabel->setVisible(!dynamic_cast<CascadeClassifierGroup*>(currDet.get()));
 }
 
 void MainWindow::toggleCameraEvent() {
@@ -297,20 +455,21 @@ void MainWindow::toggleCameraEvent() {
 		menu->flipVertical->setChecked(false);
 		history.get()->setFlipV(menu->flipVertical->isChecked());
 
+		video.reset();
 		startVideoCapture();
-		selectDetectorEvent();
+		if (!closeRequested)
+			selectDetectorEvent();
 
 	}
 	else {
-		frame = putLogo(imageContainer->size().width(), imageContainer->size().height());
+		frame = SharedFrame(putLogo(imageContainer->size().width(), imageContainer->size().height()));
 		displayImage();
-		delete currDet;
 		currDet = nullptr;
 	}
 }
 
 QString MainWindow::getImageFileName() {
-	return QFileDialog::getOpenFileName(this, tr("Open Image"), QStandardPaths::standardLocations(QStandardPaths::PicturesLocation).first(), tr("Image Files (*.png *.jpg *.jpeg *.bmp)"));
+	return QFileDialog::getOpenFileName(this, tr("Open Image"), QStandardPaths::standardLocations(QStandardPaths::PicturesLocation).first(), tr("Image Files (*.png *.jpg *.jpeg *.bmp *.tif *.tiff)"));
 }
 
 void MainWindow::uploadImageEvent() {
@@ -319,14 +478,19 @@ void MainWindow::uploadImageEvent() {
 	if (temp.isEmpty())
 		return;
 
-	QImage backup_frame = frame;
-	frame = QImage(temp);
-	if (frame.isNull()) {
+	const QImage image(temp);
+	if (image.isNull()) {
 		QMessageBox::critical(this, "Error", QString("Couldn't read image from %1. The file may be corrupted or not a valid image file.").arg(fileName));
-		frame = backup_frame;
 		return;
 	}
 	fileName = temp;
+	uploadedFrame = image;
+	proxyFrame = QImage();
+
+	// the stage results of the previous upload can never be used again
+	cancelRefinement();
+	stageCache->clear();
+	uploadedKey = StageCache::combine(std::hash<std::string>()(fileName.toStdString()), QFileInfo(fileName).lastModified().toMSecsSinceEpoch());
 
 	statusBar->showMessage(QString("Uploaded file: %1").arg(fileName));
 
@@ -351,10 +515,7 @@ void MainWindow::uploadImageEvent() {
 
 void MainWindow::selectDetectorEvent() {
 	menu->classButtons->toggle(false);
-	if (currDet != nullptr && !currDet->getSerializationFile().empty()) {
-		currDet->serialize(currDet->getSerializationFile());
-	}
-	delete currDet;
+	// the detector is saved once the live pipeline is done with it as well
 	currDet = nullptr;
 	if (menu->detectorsList->currentIndex() == 0) {
 		setOptions();
@@ -365,8 +526,9 @@ void MainWindow::selectDetectorEvent() {
 
 	QString currText = QString("../detector_paths/") + menu->detectorsList->currentText() + QString(".yaml");
 
-	if (QFileInfo(currText).exists())
-		currDet = DetectorFactory::createDetectorFromFile(currText.toStdString());
+	if (QFileInfo(currText).exists()) {
+		currDet = ownDetector(DetectorFactory::createDetectorFromFile(currText.toStdString()));
+	}
 	else {
 		QMessageBox::critical(this, "Error", QString("The file \"%1\" was deleted.").arg(currText));
 		return;
@@ -407,7 +569,7 @@ void MainWindow::selectDetectorEvent() {
 			if (primaryFound)
 				continue;
 
-			if (auto det = dynamic_cast<CascadeClassifierGroup*>(currDet)) {
+			if (auto det = dynamic_cast<CascadeClassifierGroup*>(currDet.get())) {
 				if (c == det->getPrimary()) {
 					b->setChecked(true);
 					b->setEnabled(false);
@@ -427,7 +589,9 @@ void MainWindow::selectDetectorEvent() {
 }
 
 void MainWindow::changeMinConfEvent() {
-	if (auto* det = currDet->toThresholdAdjuster())
+	// while the camera is on, the detect stage sets the threshold from its LiveSettings, since it may be detecting with the detector
+	auto* det = currDet->toThresholdAdjuster();
+	if (det && !cameraIsOn)
 		det->adjustThreshold(menu->confControl->value() / static_cast<float>(100));
 	if (imageIsUpload)
 		processImage();
@@ -457,40 +621,16 @@ void MainWindow::setDetector() {
 	if (currDet == nullptr)
 		return;
 	try {
-		cv::Mat mat;
-		ConvertQImage2Mat(frame, mat);
-		if (dynamic_cast<NeuralNetworkDetector*>(currDet) && mat.type() == CV_8UC1) {
+		if (dynamic_cast<NeuralNetworkDetector*>(currDet.get()) && frame.mat().type() == CV_8UC1) {
 			QMessageBox::critical(this, "Error", "This detector does not work on 1-channel images");
 			menu->detectorsList->setCurrentIndex(0);
 			return;
 		}
 
-		if (auto det = currDet->toObjectToggler()) {
-			for (QPushButton* btn : menu->classButtons->findChildren<QPushButton*>()) {
-				det->enableObject(btn->text().toStdString(), btn->isChecked());
-			}
-		}
-
-		detMat = currDet->detect(mat);
-		detMat.setShowConfidence(menu->showConfidence->isChecked());
-		for (auto& det : detMat) {
-			det.setColor(generateColorFromString(det.getLabel()));
-		}
-		detMat.render(mat);
-		ConvertMat2QImage(mat, frame);
-
-		std::vector<Detection> dets = detMat.getAll();
-		if (!dets.empty()) {
-			cv::Rect rect = dets.back().getRect();
-			statusBar->showMessage(QString("Detected %5 at: <%1 %2> - <%3 %4>")
-				.arg(QString::number(rect.x))
-				.arg(QString::number(rect.y))
-				.arg(QString::number(rect.x + rect.width))
-				.arg(QString::number(rect.y + rect.height))
-				.arg(QString::fromStdString(dets.back().getLabel())));
-		}
-		else statusBar->clearMessage();
-
+		enableObjects();
+		detMat = currDet->detect(frame.mat());
+		renderDetections(detMat, frame, menu->showConfidence->isChecked());
+		showDetections();
 	}
 	catch (const std::exception& e) {
 		QMessageBox::critical(this, "Error", e.what());
@@ -498,19 +638,63 @@ void MainWindow::setDetector() {
 	}
 }
 
+void MainWindow::enableObjects() {
+	if (currDet == nullptr)
+		return;
+	if (auto det = currDet->toObjectToggler()) {
+		for (QPushButton* btn : menu->classButtons->findChildren<QPushButton*>()) {
+			det->enableObject(btn->text().toStdString(), btn->isChecked());
+		}
+	}
+}
+
+void MainWindow::renderDetections(DetectionMat& detections, SharedFrame& image, bool showConfidence) {
+	detections.setShowConfidence(showConfidence);
+	for (auto& det : detections) {
+		det.setColor(generateColorFromString(det.getLabel()));
+	}
+	detections.render(image.writable());
+}
+
+void MainWindow::showDetections() {
+	std::vector<Detection> dets = detMat.getAll();
+	if (!dets.empty()) {
+		cv::Rect rect = dets.back().getRect();
+		statusBar->showMessage(QString("Detected %5 at: <%1 %2> - <%3 %4>")
+			.arg(QString::number(rect.x))
+			.arg(QString::number(rect.y))
+			.arg(QString::number(rect.x + rect.width))
+			.arg(QString::number(rect.y + rect.height))
+			.arg(QString::fromStdString(dets.back().getLabel())));
+	}
+	else statusBar->clearMessage();
+}
+
 void MainWindow::flipImage() {
-	frame = frame.mirrored(menu->flipHorizontal->isChecked(), menu->flipVertical->isChecked());
+	flipFrame(frame, menu->flipHorizontal->isChecked(), menu->flipVertical->isChecked());
+}
+
+void MainWindow::flipFrame(SharedFrame& image, bool horizontal, bool vertical) {
+	if (!horizontal && !vertical)
+		return;
+
+	// the flip swaps the pixels in place, so a frame nothing else shares is not copied
+	cv::Mat& mat = image.writable();
+	cv::flip(mat, mat, horizontal && vertical ? -1 : horizontal ? 1 : 0);
 }
 
 void MainWindow::displayImage() {
-	pixmap.setPixmap(QPixmap::fromImage(frame));
+	// a preview is stretched over the scene area of the full resolution image, so the view does not move when it is replaced
+	pixmap.setScale(imageIsUpload && !frame.empty() ? uploadedFrame.width() / static_cast<qreal>(frame.width()) : 1);
+	pixmap.setPixmap(QPixmap::fromImage(frame.image()));
 	imageContainer->scene()->setSceneRect(imageContainer->scene()->itemsBoundingRect());
 
 	preventReset();
 
+	const QSize size = imageIsUpload ? uploadedFrame.size() : frame.size();
 	QString res = QString("Resolution: %1 x %2  ")
-		.arg(QString::number(frame.size().width()))
-		.arg(QString::number(frame.size().height()));
+		.arg(QString::number(size.width()))
+		.arg(QString::number(size.height()));
 	if (!cameraIsOn && !imageIsUpload) {
 		resLabel->setText("");
 		fpsLabel->setText("");
@@ -524,13 +708,100 @@ void MainWindow::displayImage() {
 void MainWindow::startVideoCapture() {
 	int fps = 0, avgFps = 0;
 	std::deque<int> fpsArray;
-	cv::VideoCapture cap(0);
+	// the camera is read on its own thread, so a frame that takes long to process only makes the window skip the ones captured meanwhile
+	CaptureThread capture;
 
-	if (!cap.isOpened()) {
+	if (!capture.start(0)) {
 		qDebug() << "Could not open video camera.";
 		return;
 	}
-	cv::Mat mat;
+	videoRunning = true;
+
+	// the stages read the controls through a snapshot the loop refreshes, and the frames the window is done with go back to the camera
+	std::mutex settingsLock;
+	std::shared_ptr<const LiveSettings> settings = liveSettings();
+	auto current = [&] {
+		std::lock_guard<std::mutex> guard(settingsLock);
+		return settings;
+	};
+	// the window is the only thread that hands frames back and the source the only one that takes them, so no lock is needed
+	SpscRing<SharedFrame> recycled(FrameRing::DEFAULT_CAPACITY);
+
+	// the detection of a frame, on the detect stage or in the background. The detector and its controls come with the settings,
+	// so the window never waits for a detection: the lock only keeps the detect stage and the AsyncDetector off the same detector
+	std::mutex detectorLock;
+	auto detectFrame = [&](const cv::Mat& image) {
+		const std::shared_ptr<const LiveSettings> live = current();
+		Detector* detector = live->detector.get();
+		if (detector == nullptr)
+			return DetectionMat();
+		if (dynamic_cast<NeuralNetworkDetector*>(detector) && image.type() == CV_8UC1)
+			throw std::runtime_error("This detector does not work on 1-channel images");
+
+		std::lock_guard<std::mutex> guard(detectorLock);
+		if (auto* adjuster = detector->toThresholdAdjuster())
+			adjuster->adjustThreshold(live->confidence);
+		if (auto* toggler = detector->toObjectToggler())
+			for (const auto& object : live->enabledObjects)
+				toggler->enableObject(object.first, object.second);
+		return detector->detect(image);
+	};
+	AsyncDetector tracking(detectFrame);
+	// whether the last frame of the detect stage was tracked, so the tracks start over when the tracking is turned back on
+	bool tracked = false;
+	const Detector* trackedDetector = currDet.get();
+
+	// capture -> preprocess -> detect -> render, each on its own thread, while the window displays the frames that come out.
+	// The preprocessing takes the newest frame and drops the older ones, the later stages hold the one before them back instead.
+	// The stages sleep on their queues until a frame or room comes, which the lock-free queues could only do by spinning,
+	// and a few dozen lock operations a second cost nothing next to the work of a stage, so the queues keep their mutex
+	FramePipeline<LiveFrame> pipeline;
+	pipeline.setSource([&](LiveFrame& item) {
+		recycled.tryPop(item.frame.image);
+		return capture.ring().waitLatest(item.frame, std::chrono::milliseconds(20));
+		});
+	pipeline.addStage("preprocess", [&](LiveFrame& item) {
+		const std::shared_ptr<const LiveSettings> live = current();
+		if (live->algorithms) {
+			FrameOptions options = live->options;
+			std::lock_guard<std::mutex> guard(videoLock);
+			ProcessingAlgorithms::applyingAlgorithms(item.frame.image.writable(), &options, live->value1, live->value2, live->kernel,
+				nullptr, 0, nullptr, &video, &videoGraph);
+		}
+		toDisplayDepth(item.frame.image);
+		flipFrame(item.frame.image, live->flipHorizontal, live->flipVertical);
+		return true;
+		}, 1, 1, Backpressure::DropOldest);
+	pipeline.addStage("detect", [&](LiveFrame& item) {
+		const short interval = current()->detectionInterval;
+		if (interval > 0) {
+			// the detector runs in the background on some of the frames, and the tracker carries its detections over to the others
+			if (!tracked)
+				tracking.reset();
+			tracked = true;
+			tracking.setInterval(interval);
+			item.detections = tracking.process(item.frame.image.mat(), item.frame.sequence);
+			tracking.takeError(item.error);
+			return true;
+		}
+
+		tracked = false;
+		try {
+			item.detections = detectFrame(item.frame.image.mat());
+		}
+		catch (const std::exception& e) {
+			item.error = e.what();
+		}
+		return true;
+		}, 1, 2, Backpressure::Block);
+	pipeline.addStage("render", [&](LiveFrame& item) {
+		renderDetections(item.detections, item.frame.image, current()->showConfidence);
+		return true;
+		}, 1, 2, Backpressure::Block);
+	pipeline.setOutput(1, Backpressure::DropOldest);
+	pipeline.start();
+
+	LiveFrame shown;
 	while (cameraIsOn && imageContainer->isVisible()) {
 		// measure live fps, create a queue of 60 measurements and find the average value
 		Timer timer(fps);
@@ -541,25 +812,92 @@ void MainWindow::startVideoCapture() {
 			avgFps += f;
 		avgFps /= fpsArray.size();
 
-		if (!cap.read(mat))
-			break;
-		ConvertMat2QImage(mat, frame);
-		processImage();
-		fpsLabel->setText(QString("FPS: %1   (avg: %2)  ").arg(QString::number(fps)).arg(QString::number(avgFps)));
+		setOptions();
+		// the tracks of another detector do not continue
+		if (currDet.get() != trackedDetector) {
+			tracking.reset();
+			trackedDetector = currDet.get();
+		}
+		{
+			std::shared_ptr<const LiveSettings> latest = liveSettings();
+			std::lock_guard<std::mutex> guard(settingsLock);
+			settings = latest;
+		}
+
+		if (!pipeline.take(shown, std::chrono::milliseconds(100))) {
+			if (!capture.running())
+				break;
+			QCoreApplication::processEvents();
+			continue;
+		}
+
+		// the frame the window is done with goes back to the camera, to write into, unless enough of them already wait
+		recycled.tryPush(std::move(frame));
+		frame = std::move(shown.frame.image);
+		detMat = shown.detections;
+		// the frames still in flight carry the error as well, until the detector is reset
+		if (!shown.error.empty() && currDet != nullptr) {
+			QMessageBox::critical(this, "Error", QString::fromStdString(shown.error));
+			menu->detectorsList->setCurrentIndex(0);
+		}
+		else if (currDet != nullptr)
+			showDetections();
+
+		uint64_t dropped = capture.ring().dropped();
+		QString queues;
+		for (const auto& stage : pipeline.metrics()) {
+			dropped += stage.queue.dropped;
+			queues += QString("%1 %2/%3  ").arg(QString::fromStdString(stage.name)).arg(stage.queue.depth).arg(stage.queue.capacity);
+		}
+		fpsLabel->setText(QString("FPS: %1   (avg: %2)   Dropped: %3   Queues: %4").arg(QString::number(fps)).arg(QString::number(avgFps))
+			.arg(QString::number(dropped)).arg(queues));
 		displayImage();
 	}
-	cap.release();
+	// the stages use the camera and the settings of this function, so they stop before them
+	pipeline.stop();
+	capture.stop();
+	videoRunning = false;
+	// the async detector joins its thread when this function returns, before the queued close runs
+	if (closeRequested)
+		QMetaObject::invokeMethod(this, [this] { close(); }, Qt::QueuedConnection);
+}
+
+std::shared_ptr<const MainWindow::LiveSettings> MainWindow::liveSettings() {
+	std::shared_ptr<LiveSettings> settings = std::make_shared<LiveSettings>();
+	settings->options = *history.get();
+	settings->value1 = menu->thresholdControl->value();
+	settings->value2 = menu->cannyThresholdControl->value();
+	settings->kernel = menu->kernelSizeControl->value();
+	settings->algorithms = algorithmsActive();
+	settings->flipHorizontal = menu->flipHorizontal->isChecked();
+	settings->flipVertical = menu->flipVertical->isChecked();
+	settings->showConfidence = menu->showConfidence->isChecked();
+	settings->detectionInterval = history.get()->getDetectionInterval();
+	settings->detector = currDet;
+	settings->confidence = menu->confControl->value() / static_cast<float>(100);
+	for (QPushButton* btn : menu->classButtons->findChildren<QPushButton*>())
+		settings->enabledObjects.emplace_back(btn->text().toStdString(), btn->isChecked());
+	return settings;
 }
 
 void MainWindow::processImage() {
+	// the live pipeline applies the controls to the next camera frame
+	if (cameraIsOn)
+		return;
+
+	// a full resolution result computed in the background would now be stale
+	cancelRefinement();
+
+	// the frame shares the pixels of the upload until a stage writes into it
+	frameKey = uploadedKey;
 	if (imageIsUpload)
-		frame = QImage(fileName);
+		frame = SharedFrame(uploadedFrame);
 
 	selectAlgorithmsEvent();
 	flipImage();
 	setDetector();
 
-	if (frame.isNull())
+	if (frame.empty())
 		return;
 
 	if (imageIsUpload)
@@ -568,14 +906,14 @@ void MainWindow::processImage() {
 
 void MainWindow::changeThresholdEvent() {
 	if (imageIsUpload)
-		processImage();
+		previewImage();
 	statusBar->showMessage(QString("Applied binary thresholding: %1").arg(menu->thresholdControl->value()));
 }
 
 void MainWindow::changeKernelSizeEvent()
 {
 	if (imageIsUpload)
-		processImage();
+		previewImage();
 	statusBar->showMessage(QString("Applied kernel size: %1").arg(menu->kernelSizeControl->value()));
 }
 
@@ -592,19 +930,125 @@ void MainWindow::preventReset() {
 void MainWindow::selectAlgorithmsEvent() {
 	setOptions();
 
-	bool algActive = false;
+	if (!algorithmsActive())
+		return;
+
+	// the camera frames are processed by the live pipeline, with the state of the stream (see startVideoCapture())
+	ProcessingAlgorithms::applyingAlgorithms(frame.writable(), history.get(), menu->thresholdControl->value(), menu->cannyThresholdControl->value(), menu->kernelSizeControl->value(),
+		stageCache.get(), frameKey);
+	toDisplayDepth(frame);
+}
+
+bool MainWindow::algorithmsActive() {
 	for (QPushButton* btn : menu->imageAlgorithms->findChildren<QPushButton*>())
-		if (btn->isChecked()) {
-			algActive = true;
-			break;
-		}
-	if (!algActive)
+		if (btn->isChecked())
+			return true;
+	return false;
+}
+
+void MainWindow::toDisplayDepth(SharedFrame& image) {
+	// the detectors and the display take the 8-bit frame
+	cv::Mat display;
+	ToneMap::apply(image.mat(), display);
+	image = SharedFrame(display);
+}
+
+QSize MainWindow::proxySize() {
+	// the pixels the viewport shows the image with, zoom included
+	const qreal zoom = std::pow(1.1, imageContainer->getZoomCount()) * imageContainer->devicePixelRatioF();
+	return uploadedFrame.size().scaled(imageContainer->viewport()->size() * zoom, Qt::KeepAspectRatio);
+}
+
+void MainWindow::previewImage() {
+	const QSize size = proxySize();
+
+	// an image no larger than the viewport is processed in full
+	if (size.width() >= uploadedFrame.width() || size.isEmpty()) {
+		processImage();
+		return;
+	}
+
+	cancelRefinement();
+
+	if (proxyFrame.size() != size)
+		proxyFrame = uploadedFrame.scaled(size, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+
+	// the proxy has its own results in the cache; its detections would only be replaced a moment later, so it is shown without them
+	frameKey = StageCache::combine(StageCache::combine(uploadedKey, size.width()), size.height());
+	frame = SharedFrame(proxyFrame);
+	selectAlgorithmsEvent();
+	flipImage();
+	displayImage();
+}
+
+void MainWindow::refineImage() {
+	if (!imageIsUpload)
+		return;
+
+	// the preview was the full image already
+	if (proxySize().width() >= uploadedFrame.width()) {
+		if (frame.width() != uploadedFrame.width())
+			processImage();
 		return;
+	}
+
+	cancelRefinement();
+	auto cancelled = std::make_shared<std::atomic<bool>>(false);
+	refineCancelled = cancelled;
+	const unsigned generation = refineGeneration;
+
+	// the worker gets copies of everything it reads, since the controls may change while it runs
+	const QImage source = uploadedFrame;
+	const FrameOptions options = *history.get();
+	const short value1 = menu->thresholdControl->value();
+	const short value2 = menu->cannyThresholdControl->value();
+	const short kernel = menu->kernelSizeControl->value();
+	const StageCache::Key key = uploadedKey;
+	std::shared_ptr<StageCache> cache = stageCache;
+
+	// the runs that returned are forgotten; the window waits for the others before it goes away, since they post to it
+	refinements.erase(std::remove_if(refinements.begin(), refinements.end(), [](const std::future<void>& run) {
+		return run.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+		}), refinements.end());
+	refinements.push_back(std::async(std::launch::async, [this, source, options, value1, value2, kernel, key, cache, cancelled, generation] {
+		SharedFrame result(source);
+
+		FrameOptions frameOptions = options;
+		if (!ProcessingAlgorithms::applyingAlgorithms(result.writable(), &frameOptions, value1, value2, kernel, cache.get(), key, cancelled.get()))
+			return;
 
-	cv::Mat mat;
-	ConvertQImage2Mat(frame, mat);
-	ProcessingAlgorithms::applyingAlgorithms(mat, history.get(), menu->thresholdControl->value(), menu->cannyThresholdControl->value(), menu->kernelSizeControl->value());
-	ConvertMat2QImage(mat, frame);
+		toDisplayDepth(result);
+
+		QMetaObject::invokeMethod(this, [this, result, generation] {
+			finishRefinement(result, generation);
+			}, Qt::QueuedConnection);
+		}));
+}
+
+void MainWindow::cancelRefinement() {
+	if (refineCancelled)
+		*refineCancelled = true;
+	refineCancelled.reset();
+	refineGeneration++;
+}
+
+void MainWindow::stopRefinements() {
+	cancelRefinement();
+	for (std::future<void>& run : refinements)
+		run.wait();
+	refinements.clear();
+}
+
+void MainWindow::finishRefinement(const SharedFrame& result, unsigned generation) {
+	// a newer value, or a synchronous run, has superseded this result
+	if (generation != refineGeneration || !imageIsUpload)
+		return;
+
+	refineCancelled.reset();
+	frame = result;
+	flipImage();
+	setDetector();
+	displayImage();
 }
 
 void MainWindow::detectorEditEvent() {
@@ -724,6 +1168,7 @@ void MainWindow::showMagnifierWindow(QPoint imagePoint)
 	magnifierWindow->show();
 
 	int center = 4;
+	const QImage image = frame.image();
 
 	for (int i = 0; i < 9; i++)
 	{
@@ -737,7 +1182,7 @@ void MainWindow::showMagnifierWindow(QPoint imagePoint)
 
 			if (x >= 0 && x < frame.width() && y >= 0 && y < frame.height())
 			{
-				QRgb pixel = frame.pixel(x, y);
+				QRgb pixel = image.pixel(x, y);
 
 				int red = qRed(pixel);
 				int green = qGreen(pixel);
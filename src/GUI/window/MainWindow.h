@@ -2,6 +2,8 @@
 #include "sidemenu/menu.h"
 #include "ModelLoader_window.h"
 #include "ImageProcessingUtils.h"
+#include "FrameRing.h"
+#include "ProcessingGraph.h"
 #include "custom_widgets/SceneImageViewer.hpp"
 
 #include <DetectorFactory.h>
@@ -16,10 +18,46 @@
 #include <QMouseEvent>
 #include <QTableWidget>
 
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 
 class MainWindow : public QMainWindow {
 	Q_OBJECT
 
+public:
+	// a camera frame on its way through the live pipeline
+	struct LiveFrame
+	{
+		FrameRing::Frame frame;
+		DetectionMat detections;
+		// the error of the detector, which the window reports
+		std::string error;
+	};
+
+	// the controls the live pipeline applies to the camera frames
+	struct LiveSettings
+	{
+		FrameOptions options;
+		short value1 = 0;
+		short value2 = 0;
+		short kernel = 0;
+		bool algorithms = false;
+		bool flipHorizontal = false;
+		bool flipVertical = false;
+		bool showConfidence = false;
+		// 0 to detect every frame, otherwise the interval of the AsyncDetector
+		short detectionInterval = 0;
+		// the detector and the controls the detect stage sets on it before a detection, so the window never waits for one
+		std::shared_ptr<Detector> detector;
+		float confidence = 0;
+		std::vector<std::pair<std::string, bool>> enabledObjects;
+	};
+
 public:
 	// three main sections
 	Menu* menu; // controls
@@ -49,13 +87,18 @@ public:
 	/**
 	 * @brief Starts video capture from the camera.
 	 * @details This function is called when the camera is turned on.
-	 It opens a video capture object and reads frames from the camera.
-	 It processes each frame using the selected detector and displays it in the image container.
-	 It also updates the FPS label with the current FPS value.
+	 It starts a CaptureThread, which reads the camera on its own thread, and a FramePipeline whose stages preprocess,
+	 detect and render the frames on threads of their own, so one frame is detected while the next is preprocessed.
+	 The preprocessing takes the newest frame the camera captured and drops the others; the detection and the rendering
+	 make the stage before them wait. The window displays the newest frame that comes out, and the frames it is done with
+	 go back to the camera. The controls reach the stages through a LiveSettings snapshot refreshed every iteration.
+	 With a detection interval, the detect stage hands frames to an AsyncDetector instead of waiting for the detector,
+	 so the frames come out at the rate of the camera with the tracked detections of the last frame detected.
+	 It also updates the FPS label with the current FPS value, the number of frames dropped and the depth of every queue.
 	 */
 	void startVideoCapture();
 
-	~MainWindow() {};
+	~MainWindow();
 
 private slots:
 	/**
@@ -125,6 +168,14 @@ private slots:
 
 	void changeKernelSizeEvent();
 
+	/**
+	 * @brief Processes the full resolution upload in the background, once a slider has settled.
+	 * @details The algorithms run on a worker thread, resuming from the stage results in stageCache,
+	 and the result replaces the preview on the GUI thread, where the detector and the display run.
+	 Any run still in flight is cancelled first.
+	 */
+	void refineImage();
+
 	/**
 	 * @brief Applies selected image processing algorithms to the current frame.
 	 * @details This function is called when an image processing algorithm is selected from the list of available algorithms.
@@ -146,12 +197,41 @@ private slots:
 
 public:
 	QGraphicsPixmapItem pixmap;
-	QImage frame;
+	// the frame being processed and displayed, whose pixels cross between Qt and OpenCV without copies
+	SharedFrame frame;
 	QString fileName;
-	Detector* currDet;
+	// the decoded upload, which processImage() starts from instead of reading the file again
+	QImage uploadedFrame;
+	// the identity of the upload in stageCache
+	StageCache::Key uploadedKey = 0;
+	// the identity in stageCache of the frame being processed: the upload or its proxy
+	StageCache::Key frameKey = 0;
+	// the stage results of the upload, so a slider move only recomputes the stages it affects.
+	// It is shared with the background run of refineImage()
+	std::shared_ptr<StageCache> stageCache = std::make_shared<StageCache>();
+	// what the stages keep from one camera frame to the next: the smoothed thresholds and the running equalization histograms
+	VideoState video;
+	// the stages of the camera frames, rebuilt only when the options change so their buffers serve every frame
+	ProcessingGraph videoGraph;
+	// held by the live pipeline while it uses video and videoGraph, and by the window to reset video
+	std::mutex videoLock;
+	// the upload downscaled to the viewport, which previewImage() processes while a slider moves
+	QImage proxyFrame;
+	// set to stop the background run of refineImage() that is in flight
+	std::shared_ptr<std::atomic<bool>> refineCancelled;
+	// incremented whenever the result of the run in flight becomes stale
+	unsigned refineGeneration = 0;
+	// the background runs of refineImage(), including the cancelled ones that have not returned yet
+	std::vector<std::future<void>> refinements;
+	// shared with the live pipeline, which may still be detecting with a detector the window let go of
+	std::shared_ptr<Detector> currDet;
 	OptionsHistory history;
 	bool cameraIsOn = false;
 	bool imageIsUpload = false;
+	// set while startVideoCapture() runs its threads
+	bool videoRunning = false;
+	// set when the window was asked to close while the camera loop ran
+	bool closeRequested = false;
 
 public:
 	/**
@@ -177,6 +257,42 @@ public:
 	 */
 	void flipImage();
 
+	/**
+	 * @brief Flips a frame in place, horizontally, vertically or both.
+	 */
+	static void flipFrame(SharedFrame& image, bool horizontal, bool vertical);
+
+	/**
+	 * @brief Brings a processed frame to the 8 bits the detectors and the display take, with ToneMap.
+	 */
+	static void toDisplayDepth(SharedFrame& image);
+
+	/**
+	 * @brief Colours the detections by label and draws them into a frame.
+	 */
+	static void renderDetections(DetectionMat& detections, SharedFrame& image, bool showConfidence);
+
+	/**
+	 * @brief Enables in the current detector the classes whose buttons are checked, before an upload is detected.
+	 * @details The live pipeline gets them in its LiveSettings instead, since it may be detecting with the detector.
+	 */
+	void enableObjects();
+
+	/**
+	 * @brief Shows the last of the detections of detMat in the status bar.
+	 */
+	void showDetections();
+
+	/**
+	 * @brief Gets whether any image processing algorithm is selected in the menu.
+	 */
+	bool algorithmsActive();
+
+	/**
+	 * @brief Takes a snapshot of the controls the stages of the live pipeline read, since they cannot read the widgets.
+	 */
+	std::shared_ptr<const LiveSettings> liveSettings();
+
 	/**
 	 * @brief Displays the current image in the image container.
 	 * @details This function converts the current frame to a QImage and sets the pixmap of the image item in the scene to the QImage.
@@ -184,6 +300,37 @@ public:
 	 */
 	void displayImage();
 
+	/**
+	 * @brief Processes and displays a downscaled proxy of the upload while a slider moves.
+	 * @details The proxy has the resolution the viewport shows the image at, so its cost does not depend on the size of the upload.
+	 It is displayed without detections, stretched over the area of the full image, until refineImage() replaces it.
+	 The stages measure their kernels in pixels, so the preview of a neighbourhood stage is only an approximation.
+	 Any full resolution run in flight is cancelled, since its parameters are stale.
+	 */
+	void previewImage();
+
+	/**
+	 * @brief Gets the size of the proxy previewImage() processes: the upload scaled to the pixels of the viewport.
+	 */
+	QSize proxySize();
+
+	/**
+	 * @brief Cancels the full resolution run of refineImage() in flight, if any, and discards its result.
+	 */
+	void cancelRefinement();
+
+	/**
+	 * @brief Cancels the run of refineImage() in flight and waits for every background run to return, before the window goes away.
+	 */
+	void stopRefinements();
+
+	/**
+	 * @brief Flips, detects and displays the result of refineImage(), unless it has become stale.
+	 * @param[in] result The processed full resolution image.
+	 * @param[in] generation The value of refineGeneration when the run started.
+	 */
+	void finishRefinement(const SharedFrame& result, unsigned generation);
+
 	/**
 	 * @brief Returns the file name of an image selected by the user.
 	 * @details This function opens a file dialog and allows the user to select an image file.
@@ -0,0 +1,237 @@
+#include "AutoThreshold.h"
+#include "Thresholding.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	// the number of pixels and the sum of their bins, exact in 64 bits for any image OpenCV can hold
+	template<typename Counts>
+	void moments(const Counts& histogram, uint64_t& pixels, uint64_t& sum)
+	{
+		pixels = 0;
+		sum = 0;
+		for (size_t i = 0; i < histogram.size(); i++)
+		{
+			pixels += histogram[i];
+			sum += static_cast<uint64_t>(i) * histogram[i];
+		}
+	}
+
+	/**
+	 * @brief Otsu's threshold: the split with the largest variance between the classes.
+	 * @details w0 w1 (m0 - m1)^2 is (N s0 - S w0)^2 / (w0 w1), with w the sizes of the classes, s0 the sum of the dark one,
+	 N the number of pixels and S the sum of all of them. The running sums are exact, so the search is a single pass.
+	 */
+	template<typename Counts>
+	int otsu(const Counts& histogram)
+	{
+		uint64_t pixels, sum;
+		moments(histogram, pixels, sum);
+
+		const int bins = static_cast<int>(histogram.size());
+		uint64_t w0 = 0, s0 = 0;
+		double best = 0;
+		int threshold = 0;
+
+		for (int t = 0; t < bins - 1; t++)
+		{
+			w0 += histogram[t];
+			s0 += static_cast<uint64_t>(t) * histogram[t];
+			const uint64_t w1 = pixels - w0;
+			if (w0 == 0)
+				continue;
+			if (w1 == 0)
+				break;
+
+			const double spread = static_cast<double>(pixels) * s0 - static_cast<double>(sum) * w0;
+			const double between = spread * spread / (static_cast<double>(w0) * w1);
+			if (between > best)
+			{
+				best = between;
+				threshold = t;
+			}
+		}
+
+		return threshold + 1;
+	}
+
+	/**
+	 * @brief Li's minimum cross entropy threshold.
+	 * @details Up to a constant, the cross entropy of a split is -(s0 log(s0 / w0) + s1 log(s1 / w1)), with w the sizes
+	 of the classes and s their sums, so every split is evaluated from the running sums.
+	 */
+	template<typename Counts>
+	int li(const Counts& histogram)
+	{
+		uint64_t pixels, sum;
+		moments(histogram, pixels, sum);
+
+		const int bins = static_cast<int>(histogram.size());
+		uint64_t w0 = 0, s0 = 0;
+		double best = std::numeric_limits<double>::max();
+		int threshold = 0;
+
+		for (int t = 0; t < bins - 1; t++)
+		{
+			w0 += histogram[t];
+			s0 += static_cast<uint64_t>(t) * histogram[t];
+			const uint64_t w1 = pixels - w0;
+			const uint64_t s1 = sum - s0;
+			if (w0 == 0)
+				continue;
+			if (w1 == 0)
+				break;
+
+			const double dark = s0 == 0 ? 0 : s0 * std::log(static_cast<double>(s0) / w0);
+			const double bright = s1 == 0 ? 0 : s1 * std::log(static_cast<double>(s1) / w1);
+			const double entropy = -(dark + bright);
+			if (entropy < best)
+			{
+				best = entropy;
+				threshold = t;
+			}
+		}
+
+		return threshold + 1;
+	}
+
+	// the pixels above the integer part of the mean are white
+	template<typename Counts>
+	int mean(const Counts& histogram)
+	{
+		uint64_t pixels, sum;
+		moments(histogram, pixels, sum);
+		return pixels == 0 ? 0 : static_cast<int>(sum / pixels) + 1;
+	}
+
+	// the first bin with at least percentile percent of the pixels below it
+	template<typename Counts>
+	int percentileOf(const Counts& histogram, short percentile)
+	{
+		CV_Assert(percentile >= 0 && percentile <= 100);
+
+		uint64_t pixels = 0;
+		for (uint32_t count : histogram)
+			pixels += count;
+
+		const uint64_t target = (static_cast<uint64_t>(percentile) * pixels + 99) / 100;
+		const int bins = static_cast<int>(histogram.size());
+		uint64_t below = 0;
+		int t = 0;
+
+		while (below < target && t < bins)
+			below += histogram[t++];
+
+		return t;
+	}
+
+	template<typename Counts>
+	int findIn(const Counts& histogram, AutoThreshold::Method method, short percentile)
+	{
+		switch (method)
+		{
+		case AutoThreshold::Triangle:
+			return Histogram::triangleThreshold(histogram);
+		case AutoThreshold::Otsu:
+			return otsu(histogram);
+		case AutoThreshold::Li:
+			return li(histogram);
+		case AutoThreshold::Mean:
+			return mean(histogram);
+		case AutoThreshold::Percentile:
+			return percentileOf(histogram, percentile);
+		default:
+			CV_Error(cv::Error::StsBadArg, "unknown thresholding method");
+		}
+	}
+}
+
+int AutoThreshold::find(const Histogram::Bins& histogram, Method method, short percentile)
+{
+	return findIn(histogram, method, percentile);
+}
+
+int AutoThreshold::find(const Histogram::WideBins& histogram, Method method, short percentile)
+{
+	CV_Assert(histogram.size() == Histogram::WIDE_BINS);
+	return findIn(histogram, method, percentile);
+}
+
+double AutoThreshold::compute(const cv::Mat& gray, Method method, short percentile, AutoThreshold* temporal, short smoothing)
+{
+	if (gray.depth() == CV_8U)
+	{
+		const Histogram::Bins histogram = Histogram::compute(gray);
+		return find(temporal != nullptr ? temporal->smooth(histogram, smoothing) : histogram, method, percentile);
+	}
+
+	const Histogram::WideBins histogram = Histogram::computeWide(gray);
+	return Histogram::wideBinValue(find(temporal != nullptr ? temporal->smooth(histogram, smoothing) : histogram, method, percentile), gray.depth());
+}
+
+void AutoThreshold::apply(const cv::Mat& src, cv::Mat& dst, Method method, short percentile, AutoThreshold* temporal, short smoothing)
+{
+	ThresholdingEngine::apply(src, dst, ThresholdingEngine::Binary, compute(src, method, percentile, temporal, smoothing));
+}
+
+const char* AutoThreshold::methodName(Method method)
+{
+	switch (method)
+	{
+	case Triangle:
+		return "triangle";
+	case Otsu:
+		return "Otsu";
+	case Li:
+		return "Li";
+	case Mean:
+		return "mean";
+	case Percentile:
+		return "percentile";
+	default:
+		return "unknown";
+	}
+}
+
+template<typename Counts>
+Counts AutoThreshold::blend(const Counts& histogram, short smoothing)
+{
+	CV_Assert(smoothing >= 0 && smoothing <= 100);
+
+	uint64_t frame = 0;
+	for (uint32_t count : histogram)
+		frame += count;
+
+	Counts result = histogram;
+
+	// a frame of another size or depth has nothing in common with the previous ones
+	if (previous.size() == histogram.size() && pixels == frame)
+	{
+		const uint64_t weight = static_cast<uint64_t>(smoothing);
+		for (size_t i = 0; i < histogram.size(); i++)
+			result[i] = static_cast<uint32_t>((weight * previous[i] + (100 - weight) * histogram[i] + 50) / 100);
+	}
+
+	previous.assign(result.begin(), result.end());
+	pixels = frame;
+	return result;
+}
+
+Histogram::Bins AutoThreshold::smooth(const Histogram::Bins& histogram, short smoothing)
+{
+	return blend(histogram, smoothing);
+}
+
+Histogram::WideBins AutoThreshold::smooth(const Histogram::WideBins& histogram, short smoothing)
+{
+	return blend(histogram, smoothing);
+}
+
+void AutoThreshold::reset()
+{
+	previous.clear();
+	pixels = 0;
+}
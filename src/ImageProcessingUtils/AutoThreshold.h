@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Histogram.h"
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <vector>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief Automatic binarization thresholds derived from the histogram of an image.
+ * @details The histogram is counted once, and every method finds its threshold in a single pass over its bins
+ (256 for an 8-bit image, Histogram::WIDE_BINS for a 16-bit or float one), whatever the size of the image.
+ The image is then binarized by ThresholdingEngine in one vectorized pass. A threshold is always the first bin that turns white:
+ the pixels below it are set to 0 and the others to the white of the depth.
+
+ An AutoThreshold object smooths the threshold of a video over time: the histogram of every frame is blended with the smoothed
+ histogram of the frames before it, so the threshold follows slow changes of the lighting without flickering from frame to frame.
+ */
+class IMAGEPROCESSINGUTILS_API AutoThreshold
+{
+public:
+	enum Method { Triangle, Otsu, Li, Mean, Percentile };
+	static const int METHODS = 5;
+
+	/**
+	 * @brief Finds the threshold of a histogram.
+	 * @details Triangle is Histogram::triangleThreshold().
+	 Otsu maximizes the variance between the two classes, as cv::threshold() with cv::THRESH_OTSU.
+	 Li minimizes the cross entropy between the image and its binarization (Li and Lee), over every threshold rather than
+	 by the usual iterations, so it finds the global minimum.
+	 Mean turns white the pixels brighter than the mean.
+	 Percentile keeps the given percentage of the pixels black.
+	 * @param[in] histogram The histogram.
+	 * @param[in] method The method.
+	 * @param[in] percentile The percentage of black pixels of Percentile, from 0 to 100. The other methods ignore it.
+	 * @return The first white bin, from 0 to the number of bins: the number of bins itself leaves no pixel white.
+	 */
+	static int find(const Histogram::Bins& histogram, Method method, short percentile = 50);
+	static int find(const Histogram::WideBins& histogram, Method method, short percentile = 50);
+
+	/**
+	 * @brief Finds the threshold of a single-channel image.
+	 * @param[in] gray The CV_8UC1, CV_16UC1 or CV_32FC1 image.
+	 * @param[in] method The method.
+	 * @param[in] percentile The percentage of black pixels of Percentile.
+	 * @param[in,out] temporal If not null, the histograms of the previous frames, which the histogram of this one is blended with.
+	 * @param[in] smoothing The weight of the previous frames in the blend, in percent.
+	 * @return The threshold, on the scale of the depth of the image, as ThresholdingEngine::apply() takes it.
+	 */
+	static double compute(const cv::Mat& gray, Method method, short percentile, AutoThreshold* temporal = nullptr, short smoothing = 0);
+
+	/**
+	 * @brief Binarizes a single-channel image at its automatic threshold.
+	 * @details The parameters are the ones of compute().
+	 * @param[in] src The CV_8UC1, CV_16UC1 or CV_32FC1 image.
+	 * @param[out] dst The binary image, of the type of src. It may be the source image.
+	 */
+	static void apply(const cv::Mat& src, cv::Mat& dst, Method method, short percentile, AutoThreshold* temporal = nullptr, short smoothing = 0);
+
+	/**
+	 * @brief Gets the name of a method, as the menu shows it.
+	 */
+	static const char* methodName(Method method);
+
+	/**
+	 * @brief Blends the histogram of a frame with the ones of the previous frames.
+	 * @details Every bin becomes (smoothing * previous + (100 - smoothing) * current) / 100, rounded, and the result is kept
+	 for the next frame. The first frame, and a frame of another size or depth than the previous one, start the blend again.
+	 With a still scene the blend settles on the histogram of the frame itself.
+	 * @param[in] histogram The histogram of the frame.
+	 * @param[in] smoothing The weight of the previous frames, from 0 to 100. 0 only keeps the current frame.
+	 * @return The blended histogram.
+	 */
+	Histogram::Bins smooth(const Histogram::Bins& histogram, short smoothing);
+	Histogram::WideBins smooth(const Histogram::WideBins& histogram, short smoothing);
+
+	/**
+	 * @brief Forgets the previous frames, so that the next one starts the blend again.
+	 */
+	void reset();
+
+private:
+	template<typename Counts>
+	Counts blend(const Counts& histogram, short smoothing);
+
+	// the blended histogram of the previous frames
+	std::vector<uint32_t> previous;
+	// the number of pixels of the previous frame
+	uint64_t pixels = 0;
+};
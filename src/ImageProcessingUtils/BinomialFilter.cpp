@@ -0,0 +1,209 @@
+#include "BinomialFilter.h"
+#include "Convolution.h"
+#include "PixelDepth.h"
+#include "RowBands.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Widens a source row to 8.8 fixed point, with radius pixels of border on each side.
+	void padRow(const uchar* src, uint16_t* padded, int cols, int cn, int radius, int borderType)
+	{
+		for (int x = -radius; x < cols + radius; x++)
+		{
+			int sx = cv::borderInterpolate(x, cols, borderType);
+			uint16_t* out = padded + (x + radius) * cn;
+
+			for (int c = 0; c < cn; c++)
+				out[c] = sx < 0 ? 0 : static_cast<uint16_t>(src[sx * cn + c] << 8);
+		}
+	}
+
+	// out[i] = sum(weights[k] * rows[k][i]), tap by tap over the whole row
+	void weightedSumFloat(const float* const* rows, const float* weights, int taps, float* out, int length)
+	{
+		for (int i = 0; i < length; i++)
+			out[i] = weights[0] * rows[0][i];
+
+		for (int k = 1; k < taps; k++)
+		{
+			const float* row = rows[k];
+			const float w = weights[k];
+			for (int i = 0; i < length; i++)
+				out[i] += w * row[i];
+		}
+	}
+
+	// The filter of the 16-bit and float images, in float: the same passes as the fixed point filter, with the same weights.
+	template<typename T>
+	void applyDeep(const cv::Mat& source, cv::Mat& dst, int kernelSize, int borderType)
+	{
+		const std::vector<uint16_t> fixed = BinomialFilter::weights(kernelSize);
+		std::vector<float> w(kernelSize);
+		for (int k = 0; k < kernelSize; k++)
+			w[k] = fixed[k] / 65536.0f;
+
+		const int radius = kernelSize / 2;
+		const int rows = source.rows;
+		const int cols = source.cols;
+		const int cn = source.channels();
+		const int length = cols * cn;
+
+		cv::Mat horizontal(rows, cols, CV_32FC(cn));
+
+		RowBands::Traits rowPass;
+		rowPass.rowBytes = (cols + 2 * radius) * cn * sizeof(float) + length * (sizeof(float) + sizeof(T));
+
+		RowBands::run(rows, rowPass, [&](const cv::Range& range) {
+			std::vector<float> padded((cols + 2 * radius) * cn);
+			std::vector<const float*> taps(kernelSize);
+
+			for (int k = 0; k < kernelSize; k++)
+				taps[k] = padded.data() + k * cn;
+
+			for (int y = range.start; y < range.end; y++)
+			{
+				const T* in = source.ptr<T>(y);
+				for (int x = -radius; x < cols + radius; x++)
+				{
+					int sx = cv::borderInterpolate(x, cols, borderType);
+					for (int c = 0; c < cn; c++)
+						padded[(x + radius) * cn + c] = sx < 0 ? 0.0f : static_cast<float>(in[sx * cn + c]);
+				}
+
+				weightedSumFloat(taps.data(), w.data(), kernelSize, horizontal.ptr<float>(y), length);
+			}
+			});
+
+		dst.create(source.size(), source.type());
+
+		RowBands::Traits columnPass;
+		columnPass.halo = radius;
+		columnPass.rowBytes = length * (2 * sizeof(float) + sizeof(T));
+
+		RowBands::run(rows, columnPass, [&](const cv::Range& range) {
+			std::vector<float> line(length);
+			std::vector<float> zeros(length, 0.0f);
+			std::vector<const float*> taps(kernelSize);
+
+			for (int y = range.start; y < range.end; y++)
+			{
+				for (int k = 0; k < kernelSize; k++)
+				{
+					int sy = cv::borderInterpolate(y + k - radius, rows, borderType);
+					taps[k] = sy < 0 ? zeros.data() : horizontal.ptr<float>(sy);
+				}
+
+				weightedSumFloat(taps.data(), w.data(), kernelSize, line.data(), length);
+
+				T* out = dst.ptr<T>(y);
+				for (int i = 0; i < length; i++)
+					out[i] = cv::saturate_cast<T>(line[i]);
+			}
+			});
+	}
+}
+
+std::vector<uint16_t> BinomialFilter::weights(int kernelSize)
+{
+	CV_Assert(kernelSize >= 3 && kernelSize <= MAX_KERNEL_SIZE && kernelSize % 2 == 1);
+
+	const int n = kernelSize - 1;
+	std::vector<uint16_t> result(kernelSize);
+
+	uint64_t coefficient = 1;
+	uint32_t total = 0;
+	for (int k = 0; k <= n; k++)
+	{
+		result[k] = static_cast<uint16_t>(((coefficient << 16) + (1ull << (n - 1))) >> n);
+		total += result[k];
+		coefficient = coefficient * (n - k) / (k + 1);
+	}
+
+	result[n / 2] = static_cast<uint16_t>(result[n / 2] + 65536 - total);
+	return result;
+}
+
+void BinomialFilter::apply(const cv::Mat& src, cv::Mat& dst, int kernelSize, int borderType)
+{
+	CV_Assert(PixelDepth::supported(src.depth()) && (src.channels() == 1 || src.channels() == 3 || src.channels() == 4));
+	CV_Assert(borderType == cv::BORDER_CONSTANT || borderType == cv::BORDER_REPLICATE ||
+		borderType == cv::BORDER_REFLECT || borderType == cv::BORDER_REFLECT_101);
+
+	if (kernelSize % 2 == 0)
+		kernelSize--;
+
+	if (kernelSize <= 1)
+	{
+		src.copyTo(dst);
+		return;
+	}
+
+	const cv::Mat source = src;
+
+	if (source.depth() == CV_16U)
+	{
+		applyDeep<ushort>(source, dst, kernelSize, borderType);
+		return;
+	}
+	if (source.depth() == CV_32F)
+	{
+		applyDeep<float>(source, dst, kernelSize, borderType);
+		return;
+	}
+
+	const std::vector<uint16_t> w = weights(kernelSize);
+	const int radius = kernelSize / 2;
+	const int rows = source.rows;
+	const int cols = source.cols;
+	const int cn = source.channels();
+	const int length = cols * cn;
+
+	cv::Mat horizontal(rows, cols, CV_16UC(cn));
+
+	RowBands::Traits rowPass;
+	rowPass.rowBytes = (cols + 2 * radius) * cn * sizeof(uint16_t) * 2 + length;
+
+	RowBands::run(rows, rowPass, [&](const cv::Range& range) {
+		std::vector<uint16_t> padded((cols + 2 * radius) * cn);
+		std::vector<const uint16_t*> taps(kernelSize);
+
+		for (int k = 0; k < kernelSize; k++)
+			taps[k] = padded.data() + k * cn;
+
+		for (int y = range.start; y < range.end; y++)
+		{
+			padRow(source.ptr<uchar>(y), padded.data(), cols, cn, radius, borderType);
+			Convolution::weightedSum(taps.data(), w.data(), kernelSize, horizontal.ptr<uint16_t>(y), length);
+		}
+		});
+
+	dst.create(source.size(), source.type());
+
+	// the vertical pass reads the horizontal buffer, never the source, so dst may alias it
+	RowBands::Traits columnPass;
+	columnPass.halo = radius;
+	columnPass.rowBytes = length * (2 * sizeof(uint16_t) + 1);
+
+	RowBands::run(rows, columnPass, [&](const cv::Range& range) {
+		std::vector<uint16_t> line(length);
+		std::vector<uint16_t> zeros(length, 0);
+		std::vector<const uint16_t*> taps(kernelSize);
+
+		for (int y = range.start; y < range.end; y++)
+		{
+			for (int k = 0; k < kernelSize; k++)
+			{
+				int sy = cv::borderInterpolate(y + k - radius, rows, borderType);
+				taps[k] = sy < 0 ? zeros.data() : horizontal.ptr<uint16_t>(sy);
+			}
+
+			Convolution::weightedSum(taps.data(), w.data(), kernelSize, line.data(), length);
+
+			uchar* out = dst.ptr<uchar>(y);
+			for (int i = 0; i < length; i++)
+				out[i] = static_cast<uchar>((line[i] + 128) >> 8);
+		}
+		});
+}
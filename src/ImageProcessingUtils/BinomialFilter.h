@@ -0,0 +1,45 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <vector>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief Separable binomial smoothing of 8-bit, 16-bit and float images.
+ * @details The 2D binomial kernel is the outer product of a row of Pascal's triangle with itself,
+ so the filter runs as a horizontal pass followed by a vertical pass and costs O(kernelSize) per pixel instead of O(kernelSize^2).
+ Both passes work on 16-bit fixed point values with 8 fractional bits: every tap is a single unsigned 16-bit high multiply,
+ which runs across the channels of a row with SSE2/AVX2. The result is within 1 of the exactly rounded filter.
+ 16-bit and float images would lose their low bits in 8.8 fixed point, so they are filtered in float with the same weights,
+ in loops over whole rows that the compiler vectorizes.
+ Pixels outside the image are taken according to an OpenCV border mode, so every output pixel is defined.
+ */
+class IMAGEPROCESSINGUTILS_API BinomialFilter
+{
+public:
+	static const int MAX_KERNEL_SIZE = 31;
+
+	/**
+	 * @brief Smooths an image with a kernelSize x kernelSize binomial kernel.
+	 * @param[in] src The CV_8U, CV_16U or CV_32F source image, with 1, 3 or 4 channels.
+	 * @param[out] dst The destination image, of the same type as src. It may be the source image.
+	 * @param[in] kernelSize The kernel size. Even sizes behave as the next smaller odd size.
+	 * @param[in] borderType cv::BORDER_CONSTANT (zero), cv::BORDER_REPLICATE, cv::BORDER_REFLECT or cv::BORDER_REFLECT_101.
+	 */
+	static void apply(const cv::Mat& src, cv::Mat& dst, int kernelSize, int borderType = cv::BORDER_REFLECT_101);
+
+	/**
+	 * @brief Computes the 1D binomial weights in 0.16 fixed point.
+	 * @details The weights are the binomial coefficients divided by their sum, scaled by 2^16 and rounded,
+	 with the central weight adjusted so that they add up to exactly 2^16.
+	 * @param[in] kernelSize The odd kernel size, at least 3.
+	 * @return The kernelSize weights.
+	 */
+	static std::vector<uint16_t> weights(int kernelSize);
+};
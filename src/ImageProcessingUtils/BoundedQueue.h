@@ -0,0 +1,182 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief What a full queue does with a new item.
+ * @details Block makes the producer wait for room, so a slow consumer slows the producer down and nothing is lost.
+ DropOldest discards the item at the head of the queue, so the producer never waits and the consumer gets the newest items.
+ */
+enum class Backpressure { Block, DropOldest };
+
+/**
+ * @brief The state of a BoundedQueue, for monitoring.
+ */
+struct QueueMetrics
+{
+	// the items in the queue, and its largest number since it was created
+	size_t depth = 0;
+	size_t peak = 0;
+	size_t capacity = 0;
+	uint64_t pushed = 0;
+	// the items discarded by DropOldest or by cancel()
+	uint64_t dropped = 0;
+};
+
+/**
+ * @brief A bounded queue between threads, with a choice of backpressure.
+ * @details Any number of producers and consumers may use it. Once closed, pushes fail and pops drain the items left;
+ once cancelled, the items left are discarded as well, so pops fail right away.
+ */
+template<typename T>
+class BoundedQueue
+{
+public:
+	/**
+	 * @brief Creates an empty queue.
+	 * @param[in] capacity The largest number of items, at least 1.
+	 * @param[in] policy What a push does when the queue is full.
+	 */
+	BoundedQueue(size_t capacity, Backpressure policy)
+		: limit(capacity), policy(policy)
+	{
+		CV_Assert(capacity >= 1);
+	}
+
+	/**
+	 * @brief Appends an item, waiting for room or dropping the oldest item when the queue is full.
+	 * @return Returns false if the queue is closed, in which case the item is discarded.
+	 */
+	bool push(T item)
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		if (policy == Backpressure::Block)
+			spaceFreed.wait(guard, [this] { return items.size() < limit || ended; });
+		if (ended)
+			return false;
+
+		if (items.size() == limit)
+		{
+			items.pop_front();
+			discarded++;
+		}
+		items.push_back(std::move(item));
+		pushes++;
+		highest = std::max(highest, items.size());
+
+		guard.unlock();
+		itemAdded.notify_one();
+		return true;
+	}
+
+	/**
+	 * @brief Removes the item at the head, waiting for one if the queue is empty.
+	 * @return Returns false once the queue is closed and empty.
+	 */
+	bool pop(T& item)
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		itemAdded.wait(guard, [this] { return !items.empty() || ended; });
+		return take(guard, item);
+	}
+
+	/**
+	 * @brief Removes the item at the head, waiting for one at most timeout.
+	 * @return Returns false on timeout, or once the queue is closed and empty.
+	 */
+	bool popFor(T& item, std::chrono::milliseconds timeout)
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		itemAdded.wait_for(guard, timeout, [this] { return !items.empty() || ended; });
+		return take(guard, item);
+	}
+
+	/**
+	 * @brief Removes the item at the head, if any, without waiting.
+	 */
+	bool tryPop(T& item)
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		return take(guard, item);
+	}
+
+	/**
+	 * @brief Closes the queue, waking every thread that waits on it.
+	 */
+	void close()
+	{
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			ended = true;
+		}
+		itemAdded.notify_all();
+		spaceFreed.notify_all();
+	}
+
+	/**
+	 * @brief Closes the queue and discards the items left in it, waking every thread that waits on it.
+	 */
+	void cancel()
+	{
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			ended = true;
+			discarded += items.size();
+			items.clear();
+		}
+		itemAdded.notify_all();
+		spaceFreed.notify_all();
+	}
+
+	/**
+	 * @brief Gets the depth and the counters of the queue.
+	 */
+	QueueMetrics metrics() const
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		QueueMetrics result;
+		result.depth = items.size();
+		result.peak = highest;
+		result.capacity = limit;
+		result.pushed = pushes;
+		result.dropped = discarded;
+		return result;
+	}
+
+private:
+	bool take(std::unique_lock<std::mutex>& guard, T& item)
+	{
+		if (items.empty())
+			return false;
+
+		item = std::move(items.front());
+		items.pop_front();
+
+		guard.unlock();
+		spaceFreed.notify_one();
+		return true;
+	}
+
+	std::deque<T> items;
+	const size_t limit;
+	const Backpressure policy;
+	size_t highest = 0;
+	uint64_t pushes = 0;
+	uint64_t discarded = 0;
+	bool ended = false;
+	mutable std::mutex lock;
+	std::condition_variable itemAdded;
+	std::condition_variable spaceFreed;
+};
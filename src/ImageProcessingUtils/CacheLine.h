@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief The size of a cache line on the x86 and ARM CPUs the project targets.
+ * @details Two atomics written by different threads on the same line make the line bounce between the cores on every write,
+ which is false sharing. The lock-free queues align the data of each side to its own line with it.
+ std::hardware_destructive_interference_size is not used, since its value may change with the compiler flags.
+ */
+constexpr size_t CACHE_LINE_SIZE = 64;
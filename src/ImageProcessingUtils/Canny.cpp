@@ -0,0 +1,179 @@
+#include "Canny.h"
+#include "Gradient.h"
+#include "RowBands.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+	// Classifies the pixels [2, cols - 2) of row m. offsets[d] is the offset, in floats, of the first neighbour
+	// compared along direction d; the rows two above and two below m are readable.
+	void suppressRow(const float* m, const uchar* d, uchar* out, int cols, const int* offsets, int low, int high)
+	{
+		int x = 2;
+#ifdef IPU_SSE2
+		// every direction is loaded for four pixels at once and the neighbours are picked by the direction masks
+		const __m128i lowLimit = _mm_set1_epi32(low);
+		const __m128i highLimit = _mm_set1_epi32(high);
+		const __m128i zero = _mm_setzero_si128();
+		for (; x <= cols - 6; x += 4)
+		{
+			// the pixels that cannot pass the lower threshold are Suppressed whatever their neighbours are
+			const __m128 pixel = _mm_loadu_ps(m + x);
+			const __m128i value = _mm_cvttps_epi32(pixel);
+			const __m128i aboveLow = _mm_cmpgt_epi32(value, lowLimit);
+			if (_mm_movemask_epi8(aboveLow) == 0)
+				continue;
+
+			__m128i dir = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int*>(d + x)), zero), zero);
+			__m128 masks[4];
+			for (int k = 0; k < 4; k++)
+				masks[k] = _mm_castsi128_ps(_mm_cmpeq_epi32(dir, _mm_set1_epi32(k)));
+
+			__m128 neighbours[4];
+			const int steps[4] = { 1, 2, -1, -2 };
+			for (int n = 0; n < 4; n++)
+			{
+				__m128 selected = _mm_setzero_ps();
+				for (int k = 0; k < 4; k++)
+					selected = _mm_or_ps(selected, _mm_and_ps(masks[k], _mm_loadu_ps(m + x + steps[n] * offsets[k])));
+				neighbours[n] = selected;
+			}
+
+			__m128 suppressed = _mm_cmplt_ps(pixel, neighbours[0]);
+			suppressed = _mm_or_ps(suppressed, _mm_cmple_ps(pixel, neighbours[1]));
+			suppressed = _mm_or_ps(suppressed, _mm_cmple_ps(pixel, neighbours[2]));
+			suppressed = _mm_or_ps(suppressed, _mm_cmple_ps(pixel, neighbours[3]));
+
+			__m128i classes = _mm_sub_epi32(zero, _mm_add_epi32(aboveLow, _mm_cmpgt_epi32(value, highLimit)));
+			classes = _mm_andnot_si128(_mm_castps_si128(suppressed), classes);
+			classes = _mm_packus_epi16(_mm_packs_epi32(classes, zero), zero);
+			*reinterpret_cast<int*>(out + x) = _mm_cvtsi128_si32(classes);
+		}
+#endif
+		for (; x < cols - 2; x++)
+		{
+			const int offset = offsets[d[x]];
+			const float pixel = m[x];
+
+			if (pixel < m[x + offset] || pixel <= m[x + 2 * offset] || pixel <= m[x - offset] || pixel <= m[x - 2 * offset])
+				continue;
+
+			const int value = static_cast<int>(pixel);
+			out[x] = value > high ? CannyDetector::Strong : value > low ? CannyDetector::Weak : CannyDetector::Suppressed;
+		}
+	}
+}
+
+void CannyDetector::suppressNonMaxima(const cv::Mat& magnitude, const cv::Mat& direction, int threshold1, int threshold2, cv::Mat& classes)
+{
+	CV_Assert(magnitude.type() == CV_32FC1 && direction.type() == CV_8UC1 && magnitude.size() == direction.size());
+
+	const int low = std::min(threshold1, threshold2);
+	const int high = std::max(threshold1, threshold2);
+	const int step = static_cast<int>(magnitude.step1());
+
+	// offset of the first neighbour compared along each GradientEngine::Direction
+	const int offsets[4] = { -1, -step - 1, -step, -step + 1 };
+
+	classes = cv::Mat::zeros(magnitude.size(), CV_8UC1);
+
+	RowBands::Traits traits;
+	traits.halo = 2;
+	traits.rowBytes = magnitude.cols * (sizeof(float) + 2);
+
+	// the bands cover the rows [2, rows - 2)
+	RowBands::run(std::max(magnitude.rows - 4, 0), traits, [&](const cv::Range& range) {
+		for (int y = range.start + 2; y < range.end + 2; y++)
+			suppressRow(magnitude.ptr<float>(y), direction.ptr<uchar>(y), classes.ptr<uchar>(y), magnitude.cols, offsets, low, high);
+		});
+}
+
+void CannyDetector::trackEdges(const cv::Mat& classes, cv::Mat& edges)
+{
+	CV_Assert(classes.type() == CV_8UC1);
+
+	const int rows = classes.rows;
+	const int cols = classes.cols;
+
+	// a copy with a Suppressed border, so the neighbours of any pixel can be visited without bound checks
+	cv::Mat map;
+	cv::copyMakeBorder(classes, map, 1, 1, 1, 1, cv::BORDER_CONSTANT, cv::Scalar(Suppressed));
+
+	const int step = static_cast<int>(map.step);
+	const int neighbours[8] = { -step - 1, -step, -step + 1, -1, 1, step - 1, step, step + 1 };
+
+	RowBands::Traits traits;
+	traits.rowBytes = 2 * cols;
+
+	// the strong pixels are gathered band by band, then the chains are followed from a single stack
+	// since the chains of different bands can meet
+	const std::vector<cv::Range> bands = RowBands::split(rows, traits);
+	std::vector<std::vector<uchar*>> seeds(bands.size());
+
+	RowBands::forEachBand(bands, [&](int band) {
+		std::vector<uchar*>& found = seeds[band];
+
+		for (int y = bands[band].start + 1; y <= bands[band].end; y++)
+		{
+			uchar* c = map.ptr<uchar>(y);
+			int x = 1;
+#ifdef IPU_SSE2
+			// strong pixels are sparse: skip sixteen of them at a time when none is Strong
+			const __m128i strong = _mm_set1_epi8(Strong);
+			for (; x <= cols - 15; x += 16)
+			{
+				int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(c + x)), strong));
+				for (; mask != 0; mask &= mask - 1)
+				{
+					int bit = 0;
+					while (!(mask & (1 << bit)))
+						bit++;
+					found.push_back(c + x + bit);
+				}
+			}
+#endif
+			for (; x <= cols; x++)
+				if (c[x] == Strong)
+					found.push_back(c + x);
+		}
+		});
+
+	std::vector<uchar*> stack;
+	for (const std::vector<uchar*>& found : seeds)
+		stack.insert(stack.end(), found.begin(), found.end());
+
+	// a weak pixel turns Strong when it is reached, so it is pushed at most once
+	while (!stack.empty())
+	{
+		uchar* p = stack.back();
+		stack.pop_back();
+
+		for (int n : neighbours)
+			if (p[n] == Weak)
+			{
+				p[n] = Strong;
+				stack.push_back(p + n);
+			}
+	}
+
+	edges.create(classes.size(), CV_8UC1);
+
+	RowBands::run(rows, traits, [&](const cv::Range& range) {
+		for (int y = range.start; y < range.end; y++)
+		{
+			const uchar* c = map.ptr<uchar>(y + 1) + 1;
+			uchar* e = edges.ptr<uchar>(y);
+			int x = 0;
+#ifdef IPU_SSE2
+			const __m128i strong = _mm_set1_epi8(Strong);
+			for (; x <= cols - 16; x += 16)
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(e + x), _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(c + x)), strong));
+#endif
+			for (; x < cols; x++)
+				e[x] = c[x] == Strong ? 255 : 0;
+		}
+		});
+}
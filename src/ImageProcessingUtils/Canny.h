@@ -0,0 +1,47 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief The non-maximum suppression and hysteresis stages of canny().
+ * @details suppressNonMaxima() reads the magnitude and the quantized direction computed by GradientEngine,
+ so no angle is ever computed: every pixel is compared with its neighbours along one of four axes picked by integer tests.
+ The comparison and the threshold classification are fused in a single parallel sweep over row bands,
+ which writes one byte per pixel. trackEdges() then follows every chain of weak pixels that touches a strong one,
+ with an explicit stack, so an edge is kept however far it runs from its strong pixel.
+ */
+class IMAGEPROCESSINGUTILS_API CannyDetector
+{
+public:
+	/**
+	 * @brief The class of a pixel after non-maximum suppression.
+	 */
+	enum Class : uchar { Suppressed, Weak, Strong };
+
+	/**
+	 * @brief Thins the gradient to its ridges and classifies the remaining pixels against the thresholds.
+	 * @details A pixel survives if its magnitude is greater than the neighbour before it along its direction
+	 and not smaller than the two pixels after it nor the second pixel before it. The integer part of a surviving magnitude
+	 is Strong above the larger threshold, Weak above the smaller one and Suppressed otherwise, whatever order the thresholds come in.
+	 The two pixels along every border, which lack the neighbours to compare with, are Suppressed.
+	 * @param[in] magnitude The CV_32FC1 gradient magnitude.
+	 * @param[in] direction The CV_8UC1 GradientEngine::Direction of every pixel.
+	 * @param[in] threshold1 One of the hysteresis thresholds.
+	 * @param[in] threshold2 The other hysteresis threshold.
+	 * @param[out] classes The CV_8UC1 Class of every pixel.
+	 */
+	static void suppressNonMaxima(const cv::Mat& magnitude, const cv::Mat& direction, int threshold1, int threshold2, cv::Mat& classes);
+
+	/**
+	 * @brief Keeps the strong pixels and every weak pixel 8-connected to one of them through other weak pixels.
+	 * @param[in] classes The classes computed by suppressNonMaxima().
+	 * @param[out] edges The CV_8UC1 edge map: 255 on the edges and 0 elsewhere.
+	 */
+	static void trackEdges(const cv::Mat& classes, cv::Mat& edges);
+};
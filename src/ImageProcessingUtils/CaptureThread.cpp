@@ -0,0 +1,57 @@
+#include "CaptureThread.h"
+
+CaptureThread::CaptureThread(size_t ringCapacity)
+	: frames(ringCapacity)
+{
+}
+
+CaptureThread::~CaptureThread()
+{
+	stop();
+}
+
+bool CaptureThread::start(int device)
+{
+	CV_Assert(!worker.joinable() && !frames.closed());
+
+	if (!capture.open(device))
+		return false;
+
+	active = true;
+	worker = std::thread(&CaptureThread::run, this);
+	return true;
+}
+
+void CaptureThread::stop()
+{
+	stopping = true;
+	if (worker.joinable())
+		worker.join();
+	capture.release();
+	frames.close();
+}
+
+bool CaptureThread::running() const
+{
+	return active;
+}
+
+FrameRing& CaptureThread::ring()
+{
+	return frames;
+}
+
+void CaptureThread::run()
+{
+	while (!stopping)
+	{
+		// the camera writes into the buffer of the oldest frame, which the ring has got back by now
+		FrameRing::Frame& slot = frames.beginWrite();
+		if (!capture.read(slot.image.reuse()))
+			break;
+		frames.publish();
+	}
+
+	active = false;
+	frames.close();
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "FrameRing.h"
+
+#include <opencv2/videoio.hpp>
+#include <atomic>
+#include <thread>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief Reads a camera on its own thread, into a FrameRing.
+ * @details cv::VideoCapture::read() blocks until the camera delivers the next frame. On its own thread it no longer
+ adds up with the processing of the previous frame: the camera keeps its rate, and a consumer slower than it takes
+ the newest frame each time and skips the others, which the ring counts as dropped.
+ */
+class IMAGEPROCESSINGUTILS_API CaptureThread
+{
+public:
+	/**
+	 * @brief Creates a capture that is not started.
+	 * @param[in] ringCapacity The number of frames of the ring.
+	 */
+	explicit CaptureThread(size_t ringCapacity = FrameRing::DEFAULT_CAPACITY);
+
+	/**
+	 * @brief Stops the capture.
+	 */
+	~CaptureThread();
+
+	CaptureThread(const CaptureThread&) = delete;
+	CaptureThread& operator=(const CaptureThread&) = delete;
+
+	/**
+	 * @brief Opens a camera and starts reading it. A capture is only started once.
+	 * @param[in] device The index of the camera, as cv::VideoCapture takes it.
+	 * @return Returns false if the camera could not be opened.
+	 */
+	bool start(int device);
+
+	/**
+	 * @brief Stops reading, after the frame in flight, and closes the camera and the ring.
+	 */
+	void stop();
+
+	/**
+	 * @brief Gets whether the camera is still being read: false once stopped or once the camera fails to deliver a frame.
+	 */
+	bool running() const;
+
+	/**
+	 * @brief Gets the ring the frames are published to, for the consumer.
+	 */
+	FrameRing& ring();
+
+private:
+	void run();
+
+	cv::VideoCapture capture;
+	FrameRing frames;
+	std::thread worker;
+	std::atomic<bool> stopping{ false };
+	std::atomic<bool> active{ false };
+};
@@ -0,0 +1,267 @@
+#include "Clahe.h"
+#include "Histogram.h"
+#include "Kernels.h"
+#include "PixelDepth.h"
+#include "RowBands.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+	const int LANES = 4;
+
+	struct Grid
+	{
+		int tilesX;
+		int tilesY;
+		int tileWidth;
+		int tileHeight;
+		int bins;
+	};
+
+	// the bin a pixel counts in and looks up
+	inline int binOf(uchar value)
+	{
+		return value;
+	}
+
+	inline int binOf(ushort value)
+	{
+		return value;
+	}
+
+	inline int binOf(float value)
+	{
+		return Histogram::wideBin(value);
+	}
+
+	/**
+	 * @brief Counts the pixels of a tile into bins that are already cleared.
+	 * @details The rows and columns of the tile past the image are the mirror image of its last ones. 8-bit pixels are counted
+	 into interleaved copies of the bins, like Histogram::compute(), so that runs of equal pixels do not wait on the same counter.
+	 */
+	template<typename T>
+	void countTile(const cv::Mat& src, const Grid& grid, int tx, const cv::Range& rows, uint32_t* counts)
+	{
+		const int x0 = tx * grid.tileWidth;
+		const int x1 = x0 + grid.tileWidth;
+		const int inside = std::min(x1, src.cols);
+
+		uint32_t lanes[LANES][Histogram::BINS] = {};
+
+		for (int y = rows.start; y < rows.end; y++)
+		{
+			const T* row = src.ptr<T>(y < src.rows ? y : cv::borderInterpolate(y, src.rows, cv::BORDER_REFLECT_101));
+
+			int x = x0;
+			if constexpr (std::is_same<T, uchar>::value)
+			{
+				for (; x <= inside - LANES; x += LANES)
+				{
+					lanes[0][row[x]]++;
+					lanes[1][row[x + 1]]++;
+					lanes[2][row[x + 2]]++;
+					lanes[3][row[x + 3]]++;
+				}
+			}
+			for (; x < inside; x++)
+				counts[binOf(row[x])]++;
+			for (; x < x1; x++)
+				counts[binOf(row[cv::borderInterpolate(x, src.cols, cv::BORDER_REFLECT_101)])]++;
+		}
+
+		if constexpr (std::is_same<T, uchar>::value)
+			for (int i = 0; i < Histogram::BINS; i++)
+				counts[i] += lanes[0][i] + lanes[1][i] + lanes[2][i] + lanes[3][i];
+	}
+
+	/**
+	 * @brief Clips the histogram of a tile and turns it into the equalization table of the tile, as cv::CLAHE does.
+	 * @details The counts above clip are cut down to it, and the pixels cut are spread evenly over all the bins,
+	 the remainder one by one at regular steps from the first bin. The table maps a bin to the rounded (bins - 1) * cdf / area.
+	 * @param[in] clip The largest count, or 0 not to clip.
+	 */
+	template<typename Level>
+	void tileTable(uint32_t* counts, int bins, int area, int clip, Level* table)
+	{
+		if (clip > 0)
+		{
+			const uint32_t limit = static_cast<uint32_t>(clip);
+			uint32_t clipped = 0;
+
+			for (int i = 0; i < bins; i++)
+				if (counts[i] > limit)
+				{
+					clipped += counts[i] - limit;
+					counts[i] = limit;
+				}
+
+			const uint32_t batch = clipped / bins;
+			int residual = static_cast<int>(clipped - batch * bins);
+
+			for (int i = 0; i < bins; i++)
+				counts[i] += batch;
+
+			if (residual != 0)
+			{
+				const int step = std::max(bins / residual, 1);
+				for (int i = 0; i < bins && residual > 0; i += step, residual--)
+					counts[i]++;
+			}
+		}
+
+		const float scale = static_cast<float>(bins - 1) / area;
+		uint32_t sum = 0;
+
+		for (int i = 0; i < bins; i++)
+		{
+			sum += counts[i];
+			table[i] = static_cast<Level>(cvRound(sum * scale));
+		}
+	}
+
+	/**
+	 * @brief The two tiles every pixel of a line blends, with the weight of the second one.
+	 * @details A pixel at the centre of a tile only takes its table, and the pixels outside the centres of the first and the last tile
+	 only take theirs. The tiles are given as offsets into the tables, a tile apart being stride entries apart.
+	 */
+	struct Axis
+	{
+		std::vector<int> first;
+		std::vector<int> second;
+		std::vector<float> weight;
+
+		Axis(int length, int tileSize, int tiles, int stride)
+			: first(length), second(length), weight(length)
+		{
+			const float inverse = 1.0f / tileSize;
+
+			for (int i = 0; i < length; i++)
+			{
+				const float position = i * inverse - 0.5f;
+				const int tile = cvFloor(position);
+
+				weight[i] = position - tile;
+				first[i] = std::max(tile, 0) * stride;
+				second[i] = std::min(tile + 1, tiles - 1) * stride;
+			}
+		}
+	};
+
+	// the pixel of a blended table entry
+	template<typename T>
+	T pixelOf(float level)
+	{
+		if constexpr (std::is_same<T, float>::value)
+			return level * (1.0f / (Histogram::WIDE_BINS - 1));
+		else
+			return static_cast<T>(static_cast<int>(level + 0.5f));
+	}
+
+	/**
+	 * @brief Builds the table of every tile, in parallel.
+	 * @return The tables, tile after tile in row order, bins entries each.
+	 */
+	template<typename T, typename Level>
+	std::vector<Level> buildTables(const cv::Mat& src, const Grid& grid, double clipLimit)
+	{
+		const int area = grid.tileWidth * grid.tileHeight;
+		const int clip = clipLimit > 0 ? std::max(static_cast<int>(clipLimit * area / grid.bins), 1) : 0;
+
+		std::vector<Level> tables(static_cast<size_t>(grid.tilesX) * grid.tilesY * grid.bins);
+
+		// one band per tile, which covers the rows of the tile
+		std::vector<cv::Range> bands;
+		for (int ty = 0; ty < grid.tilesY; ty++)
+			for (int tx = 0; tx < grid.tilesX; tx++)
+				bands.push_back(cv::Range(ty * grid.tileHeight, (ty + 1) * grid.tileHeight));
+
+		RowBands::forEachBand(bands, [&](int tile) {
+			std::vector<uint32_t> counts(grid.bins, 0);
+			countTile<T>(src, grid, tile % grid.tilesX, bands[tile], counts.data());
+			tileTable(counts.data(), grid.bins, area, clip, tables.data() + static_cast<size_t>(tile) * grid.bins);
+			});
+
+		return tables;
+	}
+
+	// the 16-bit and float blend, pixel by pixel with the arithmetic of Kernels::claheRow
+	template<typename T>
+	void blendDeep(const cv::Mat& source, cv::Mat& dst, const Grid& grid, const std::vector<ushort>& tables, const Axis& columns, const Axis& rows)
+	{
+		RowBands::Traits traits;
+		traits.rowBytes = source.cols * (2 * sizeof(T) + 2 * sizeof(int) + sizeof(float));
+
+		RowBands::run(source.rows, traits, [&](const cv::Range& range) {
+			for (int y = range.start; y < range.end; y++)
+			{
+				const T* in = source.ptr<T>(y);
+				T* out = dst.ptr<T>(y);
+				const ushort* top = tables.data() + rows.first[y];
+				const ushort* bottom = tables.data() + rows.second[y];
+				const float yw = rows.weight[y], ywc = 1.0f - yw;
+
+				for (int x = 0; x < source.cols; x++)
+				{
+					const int bin = binOf(in[x]);
+					const int l = columns.first[x] + bin, r = columns.second[x] + bin;
+					const float xw = columns.weight[x], xwc = 1.0f - xw;
+					const float upper = top[l] * xwc + top[r] * xw;
+					const float lower = bottom[l] * xwc + bottom[r] * xw;
+					out[x] = pixelOf<T>(upper * ywc + lower * yw);
+				}
+			}
+			});
+	}
+}
+
+void Clahe::apply(const cv::Mat& src, cv::Mat& dst, cv::Size tiles, double clipLimit)
+{
+	CV_Assert(src.channels() == 1 && PixelDepth::supported(src.depth()));
+	CV_Assert(tiles.width >= 1 && tiles.height >= 1 && clipLimit >= 0);
+
+	const cv::Mat source = src;
+	dst.create(source.size(), source.type());
+	if (source.empty())
+		return;
+
+	Grid grid;
+	// a deep image has a table of 65536 levels per tile, which a fine grid would multiply into hundreds of megabytes
+	const int most = source.depth() == CV_8U ? INT_MAX : MAX_DEEP_TILES;
+	grid.tilesX = std::min({ tiles.width, source.cols, most });
+	grid.tilesY = std::min({ tiles.height, source.rows, most });
+	grid.tileWidth = (source.cols + grid.tilesX - 1) / grid.tilesX;
+	grid.tileHeight = (source.rows + grid.tilesY - 1) / grid.tilesY;
+	grid.bins = source.depth() == CV_8U ? Histogram::BINS : Histogram::WIDE_BINS;
+
+	// the offsets of the tables: a tile is bins entries after its left neighbour, a row of tiles tilesX * bins after the one above
+	const Axis columns(source.cols, grid.tileWidth, grid.tilesX, grid.bins);
+	const Axis rows(source.rows, grid.tileHeight, grid.tilesY, grid.tilesX * grid.bins);
+
+	// every pixel only reads its own value once the tables are built, so the blend may write over the source
+	if (source.depth() == CV_8U)
+	{
+		// the 8-bit tables hold their rounded levels as floats, which the blend gathers directly
+		const std::vector<float> tables = buildTables<uchar, float>(source, grid, clipLimit);
+		const Kernels& kernels = Kernels::active();
+
+		RowBands::Traits traits;
+		traits.rowBytes = source.cols * (2 + 2 * sizeof(int) + sizeof(float));
+
+		RowBands::run(source.rows, traits, [&](const cv::Range& range) {
+			for (int y = range.start; y < range.end; y++)
+				kernels.claheRow(source.ptr<uchar>(y), dst.ptr<uchar>(y), source.cols, tables.data() + rows.first[y], tables.data() + rows.second[y],
+					columns.first.data(), columns.second.data(), columns.weight.data(), rows.weight[y]);
+			});
+		return;
+	}
+
+	PixelDepth::dispatch(source.depth(), [&](auto pixel) {
+		typedef decltype(pixel) T;
+		blendDeep<T>(source, dst, grid, buildTables<T, ushort>(source, grid, clipLimit), columns, rows);
+		});
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief Contrast limited adaptive histogram equalization (CLAHE), as cv::CLAHE computes it.
+ * @details The image is cut into a grid of tiles and every tile gets the equalization table of its own histogram,
+ whose bins are first clipped at clipLimit times their mean count, the excess being spread over all the bins. A pixel then blends
+ the tables of the four tiles whose centres surround it, bilinearly, so the contrast follows the local lighting without seams.
+ That costs two passes over the image: the tile histograms, one tile per task of the OpenCV thread pool, then the blend in
+ parallel row bands. The 8-bit blend gathers the four table entries of 8 or 16 pixels at a time with AVX2/AVX-512 (see Kernels).
+ When the size of the image is not a multiple of the grid, the last tiles extend past it and count its mirror image
+ (cv::BORDER_REFLECT_101), without copying it.
+ */
+class IMAGEPROCESSINGUTILS_API Clahe
+{
+public:
+	// the most tiles across and down a 16-bit or float image is cut into: a table of Histogram::WIDE_BINS levels takes 128 KiB,
+	// so the tables of this grid come to 32 MiB
+	static const int MAX_DEEP_TILES = 16;
+
+	/**
+	 * @brief Equalizes a single-channel image tile by tile.
+	 * @details 8-bit images have 256 bins per tile. 16-bit and float images have Histogram::WIDE_BINS, a float pixel counting
+	 in Histogram::wideBin() of its value; their blend is scalar. Their grid is capped at MAX_DEEP_TILES across and down.
+	 * @param[in] src The CV_8UC1, CV_16UC1 or CV_32FC1 image.
+	 * @param[out] dst The equalized image, of the type of src. It may be the source image.
+	 * @param[in] tiles The number of tiles across and down, each at least 1. A grid finer than the image is reduced to one pixel per tile.
+	 * @param[in] clipLimit The largest count of a bin, as a multiple of the mean count of the bins of a tile.
+	 0 disables the clipping, which gives the plain equalization of every tile.
+	 */
+	static void apply(const cv::Mat& src, cv::Mat& dst, cv::Size tiles, double clipLimit);
+};
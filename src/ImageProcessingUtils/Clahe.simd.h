@@ -0,0 +1,102 @@
+#pragma once
+
+// The interpolation row of Clahe, compiled once per CpuDispatch level through Kernels.simd.h.
+
+#include "Simd.h"
+
+#include <opencv2/core.hpp>
+
+namespace IPU_SIMD_NAMESPACE
+{
+	namespace
+	{
+		// Every pixel blends the tables of the four tiles around it:
+		// ((top[left + v] * (1 - xw) + top[right + v] * xw) * (1 - yw) + (bottom[left + v] * (1 - xw) + bottom[right + v] * xw) * yw,
+		// rounded half up. The tables hold floats so that AVX2 and AVX-512 gather the four entries straight into the arithmetic.
+		// SSE2 has no gather, so it loads them one by one and only blends four pixels at a time.
+		void claheRow(const uchar* src, uchar* dst, int width, const float* top, const float* bottom,
+			const int* left, const int* right, const float* xWeights, float yWeight)
+		{
+			int x = 0;
+#ifdef IPU_AVX512
+			const __m512 one16 = _mm512_set1_ps(1.0f);
+			const __m512 half16 = _mm512_set1_ps(0.5f);
+			const __m512 yw16 = _mm512_set1_ps(yWeight);
+			const __m512 yw16c = _mm512_sub_ps(one16, yw16);
+			for (; x <= width - 16; x += 16)
+			{
+				const __m512i v = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x)));
+				const __m512i l = _mm512_add_epi32(_mm512_loadu_si512(left + x), v);
+				const __m512i r = _mm512_add_epi32(_mm512_loadu_si512(right + x), v);
+				const __m512 xw = _mm512_loadu_ps(xWeights + x);
+				const __m512 xwc = _mm512_sub_ps(one16, xw);
+
+				const __m512 upper = _mm512_add_ps(_mm512_mul_ps(_mm512_i32gather_ps(l, top, 4), xwc), _mm512_mul_ps(_mm512_i32gather_ps(r, top, 4), xw));
+				const __m512 lower = _mm512_add_ps(_mm512_mul_ps(_mm512_i32gather_ps(l, bottom, 4), xwc), _mm512_mul_ps(_mm512_i32gather_ps(r, bottom, 4), xw));
+				const __m512 blend = _mm512_add_ps(_mm512_mul_ps(upper, yw16c), _mm512_mul_ps(lower, yw16));
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm512_cvtepi32_epi8(_mm512_cvttps_epi32(_mm512_add_ps(blend, half16))));
+			}
+#endif
+#ifdef IPU_AVX2
+			const __m256 one8 = _mm256_set1_ps(1.0f);
+			const __m256 half8 = _mm256_set1_ps(0.5f);
+			const __m256 yw8 = _mm256_set1_ps(yWeight);
+			const __m256 yw8c = _mm256_sub_ps(one8, yw8);
+			for (; x <= width - 8; x += 8)
+			{
+				const __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + x)));
+				const __m256i l = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + x)), v);
+				const __m256i r = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(right + x)), v);
+				const __m256 xw = _mm256_loadu_ps(xWeights + x);
+				const __m256 xwc = _mm256_sub_ps(one8, xw);
+
+				const __m256 upper = _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(top, l, 4), xwc), _mm256_mul_ps(_mm256_i32gather_ps(top, r, 4), xw));
+				const __m256 lower = _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(bottom, l, 4), xwc), _mm256_mul_ps(_mm256_i32gather_ps(bottom, r, 4), xw));
+				const __m256 blend = _mm256_add_ps(_mm256_mul_ps(upper, yw8c), _mm256_mul_ps(lower, yw8));
+
+				// the values are in [0, 255], so the signed packs do not saturate
+				const __m256i rounded = _mm256_cvttps_epi32(_mm256_add_ps(blend, half8));
+				const __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(rounded), _mm256_extracti128_si256(rounded, 1));
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(words, words));
+			}
+#endif
+#ifdef IPU_SSE2
+			const __m128 one4 = _mm_set1_ps(1.0f);
+			const __m128 half4 = _mm_set1_ps(0.5f);
+			const __m128 yw4 = _mm_set1_ps(yWeight);
+			const __m128 yw4c = _mm_sub_ps(one4, yw4);
+			for (; x <= width - 4; x += 4)
+			{
+				const int l0 = left[x] + src[x], l1 = left[x + 1] + src[x + 1], l2 = left[x + 2] + src[x + 2], l3 = left[x + 3] + src[x + 3];
+				const int r0 = right[x] + src[x], r1 = right[x + 1] + src[x + 1], r2 = right[x + 2] + src[x + 2], r3 = right[x + 3] + src[x + 3];
+				const __m128 xw = _mm_loadu_ps(xWeights + x);
+				const __m128 xwc = _mm_sub_ps(one4, xw);
+
+				const __m128 upper = _mm_add_ps(_mm_mul_ps(_mm_setr_ps(top[l0], top[l1], top[l2], top[l3]), xwc),
+					_mm_mul_ps(_mm_setr_ps(top[r0], top[r1], top[r2], top[r3]), xw));
+				const __m128 lower = _mm_add_ps(_mm_mul_ps(_mm_setr_ps(bottom[l0], bottom[l1], bottom[l2], bottom[l3]), xwc),
+					_mm_mul_ps(_mm_setr_ps(bottom[r0], bottom[r1], bottom[r2], bottom[r3]), xw));
+				const __m128 blend = _mm_add_ps(_mm_mul_ps(upper, yw4c), _mm_mul_ps(lower, yw4));
+
+				const __m128i rounded = _mm_cvttps_epi32(_mm_add_ps(blend, half4));
+				const __m128i words = _mm_packs_epi32(rounded, rounded);
+				const int bytes = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+				dst[x] = static_cast<uchar>(bytes);
+				dst[x + 1] = static_cast<uchar>(bytes >> 8);
+				dst[x + 2] = static_cast<uchar>(bytes >> 16);
+				dst[x + 3] = static_cast<uchar>(bytes >> 24);
+			}
+#endif
+			const float ywc = 1.0f - yWeight;
+			for (; x < width; x++)
+			{
+				const int l = left[x] + src[x], r = right[x] + src[x];
+				const float xw = xWeights[x], xwc = 1.0f - xw;
+				const float upper = top[l] * xwc + top[r] * xw;
+				const float lower = bottom[l] * xwc + bottom[r] * xw;
+				dst[x] = static_cast<uchar>(static_cast<int>(upper * ywc + lower * yWeight + 0.5f));
+			}
+		}
+	}
+}
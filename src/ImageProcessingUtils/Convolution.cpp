@@ -0,0 +1,43 @@
+#include "Convolution.h"
+#include "Kernels.h"
+#include "RowBands.h"
+
+#include <vector>
+
+void Convolution::filter(const cv::Mat& src, cv::Mat& dst, const float* kernel, int radius, int borderType)
+{
+	CV_Assert((src.depth() == CV_8U || src.depth() == CV_32F) && radius >= 0);
+
+	const int rows = src.rows;
+	const int cn = src.channels();
+	const int length = src.cols * cn;
+
+	cv::Mat padded;
+	cv::copyMakeBorder(src, padded, radius, radius, radius, radius, borderType);
+	padded.convertTo(padded, CV_32F);
+
+	dst.create(src.size(), CV_32FC(cn));
+
+	const Kernels::FilterRow row = Kernels::active().filterRow(radius, cn);
+
+	RowBands::Traits traits;
+	traits.halo = radius;
+	traits.rowBytes = (padded.cols * cn + length) * sizeof(float);
+
+	RowBands::run(rows, traits, [&](const cv::Range& range) {
+		std::vector<const float*> taps(2 * radius + 1);
+
+		for (int y = range.start; y < range.end; y++)
+		{
+			for (int k = 0; k <= 2 * radius; k++)
+				taps[k] = padded.ptr<float>(y + k) + radius * cn;
+
+			row(taps.data(), kernel, dst.ptr<float>(y), length, radius, cn);
+		}
+		});
+}
+
+void Convolution::weightedSum(const uint16_t* const* rows, const uint16_t* weights, int taps, uint16_t* out, int length)
+{
+	Kernels::active().weightedSum(taps)(rows, weights, taps, out, length);
+}
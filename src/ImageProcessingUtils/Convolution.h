@@ -0,0 +1,56 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <array>
+#include <cstdint>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief Convolution kernels shared by the filters of the library.
+ * @details Every entry point dispatches on the kernel radius (1 to 4) and, for the 2D filter, on the channel count (1, 3 or 4)
+ to an instantiation of a template in which both are compile-time constants, so the tap loops are fully unrolled
+ and the tap offsets are immediate values. Any other radius or channel count goes through the same template
+ instantiated with runtime bounds.
+ */
+class IMAGEPROCESSINGUTILS_API Convolution
+{
+public:
+	static const int MAX_SPECIALIZED_RADIUS = 4;
+
+	/**
+	 * @brief A square (2 * Radius + 1) x (2 * Radius + 1) kernel, stored row by row.
+	 * @details Fixed kernels can be built as constexpr values of this type and passed to filter() through data().
+	 */
+	template<int Radius>
+	using Kernel = std::array<float, (2 * Radius + 1) * (2 * Radius + 1)>;
+
+	/**
+	 * @brief Correlates an 8-bit or float image with a square float kernel.
+	 * @details The image is padded once according to borderType and converted to float if it is 8-bit,
+	 then every output row is computed with SSE2/AVX2 multiply-adds over the interleaved channels. Rows run in parallel bands.
+	 * @param[in] src The CV_8U or CV_32F source image, with any number of channels.
+	 * @param[out] dst The CV_32F result, with the channel count of src.
+	 * @param[in] kernel The (2 * radius + 1)^2 weights, row by row.
+	 * @param[in] radius The kernel radius.
+	 * @param[in] borderType The OpenCV border mode used for the pixels outside the image.
+	 */
+	static void filter(const cv::Mat& src, cv::Mat& dst, const float* kernel, int radius, int borderType = cv::BORDER_REFLECT_101);
+
+	/**
+	 * @brief Computes a 16-bit fixed-point weighted sum of rows.
+	 * @details out[i] is the sum over the taps of (rows[k][i] * weights[k]) >> 16. When the weights add up to at most 2^16
+	 the result never exceeds the largest input. The rows can be offsets of a single padded row, which gives a horizontal
+	 1D filter, or different image rows, which gives a vertical one.
+	 * @param[in] rows The row pointers, one per tap.
+	 * @param[in] weights The 0.16 fixed point weights.
+	 * @param[in] taps The number of rows and weights.
+	 * @param[out] out The result.
+	 * @param[in] length The number of values in every row.
+	 */
+	static void weightedSum(const uint16_t* const* rows, const uint16_t* weights, int taps, uint16_t* out, int length);
+};
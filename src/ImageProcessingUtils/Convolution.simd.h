@@ -0,0 +1,185 @@
+#pragma once
+
+// The row kernels of Convolution, compiled once per CpuDispatch level through Kernels.simd.h.
+
+#include "Kernels.h"
+#include "Simd.h"
+
+#include <cstdint>
+
+namespace IPU_SIMD_NAMESPACE
+{
+	namespace
+	{
+		// A template argument of 0 means that the bound is only known at runtime and is taken from the function argument.
+		// rows[k] points to pixel 0 of padded row k, so the taps of element i are at rows[k][i + (j - radius) * cn].
+		// The products are added in the same order in every variant and never fused, so all of them give the same floats.
+		template<int Radius, int Channels>
+		void filterRow(const float* const* rows, const float* kernel, float* out, int length, int radius, int cn)
+		{
+			const int r = Radius > 0 ? Radius : radius;
+			const int c = Channels > 0 ? Channels : cn;
+			const int size = 2 * r + 1;
+
+			// a local copy cannot alias out, so the weights stay in registers across the row
+			float local[Radius > 0 ? (2 * Radius + 1) * (2 * Radius + 1) : 1];
+			const float* k = kernel;
+			if (Radius > 0)
+			{
+				for (int t = 0; t < size * size; t++)
+					local[t] = kernel[t];
+				k = local;
+			}
+
+			int i = 0;
+#ifdef IPU_AVX512
+			for (; i <= length - 16; i += 16)
+			{
+				__m512 sum = _mm512_setzero_ps();
+				for (int y = 0; y < size; y++)
+				{
+					const float* row = rows[y] + i - r * c;
+					for (int x = 0; x < size; x++)
+						sum = _mm512_add_ps(sum, _mm512_mul_ps(_mm512_set1_ps(k[y * size + x]), _mm512_loadu_ps(row + x * c)));
+				}
+				_mm512_storeu_ps(out + i, sum);
+			}
+#endif
+#ifdef IPU_AVX2
+			for (; i <= length - 8; i += 8)
+			{
+				__m256 sum = _mm256_setzero_ps();
+				for (int y = 0; y < size; y++)
+				{
+					const float* row = rows[y] + i - r * c;
+					for (int x = 0; x < size; x++)
+						sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(k[y * size + x]), _mm256_loadu_ps(row + x * c)));
+				}
+				_mm256_storeu_ps(out + i, sum);
+			}
+#endif
+#ifdef IPU_SSE2
+			for (; i <= length - 4; i += 4)
+			{
+				__m128 sum = _mm_setzero_ps();
+				for (int y = 0; y < size; y++)
+				{
+					const float* row = rows[y] + i - r * c;
+					for (int x = 0; x < size; x++)
+						sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(k[y * size + x]), _mm_loadu_ps(row + x * c)));
+				}
+				_mm_storeu_ps(out + i, sum);
+			}
+#endif
+			for (; i < length; i++)
+			{
+				float sum = 0;
+				for (int y = 0; y < size; y++)
+				{
+					const float* row = rows[y] + i - r * c;
+					for (int x = 0; x < size; x++)
+						sum = sum + k[y * size + x] * row[x * c];
+				}
+				out[i] = sum;
+			}
+		}
+
+		template<int Taps>
+		void weightedSumRow(const uint16_t* const* rows, const uint16_t* weights, int taps, uint16_t* out, int length)
+		{
+			const int n = Taps > 0 ? Taps : taps;
+
+			int i = 0;
+#ifdef IPU_AVX512
+			for (; i <= length - 32; i += 32)
+			{
+				__m512i sum = _mm512_setzero_si512();
+				for (int k = 0; k < n; k++)
+					sum = _mm512_add_epi16(sum, _mm512_mulhi_epu16(_mm512_loadu_si512(rows[k] + i), _mm512_set1_epi16(static_cast<short>(weights[k]))));
+				_mm512_storeu_si512(out + i, sum);
+			}
+#endif
+#ifdef IPU_AVX2
+			for (; i <= length - 16; i += 16)
+			{
+				__m256i sum = _mm256_setzero_si256();
+				for (int k = 0; k < n; k++)
+				{
+					__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[k] + i));
+					sum = _mm256_add_epi16(sum, _mm256_mulhi_epu16(v, _mm256_set1_epi16(static_cast<short>(weights[k]))));
+				}
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), sum);
+			}
+#endif
+#ifdef IPU_SSE2
+			for (; i <= length - 8; i += 8)
+			{
+				__m128i sum = _mm_setzero_si128();
+				for (int k = 0; k < n; k++)
+				{
+					__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + i));
+					sum = _mm_add_epi16(sum, _mm_mulhi_epu16(v, _mm_set1_epi16(static_cast<short>(weights[k]))));
+				}
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), sum);
+			}
+#endif
+			for (; i < length; i++)
+			{
+				uint32_t sum = 0;
+				for (int k = 0; k < n; k++)
+					sum += (static_cast<uint32_t>(rows[k][i]) * weights[k]) >> 16;
+				out[i] = static_cast<uint16_t>(sum);
+			}
+		}
+
+		template<int Radius>
+		Kernels::FilterRow selectChannels(int cn)
+		{
+			switch (cn)
+			{
+			case 1:
+				return filterRow<Radius, 1>;
+			case 3:
+				return filterRow<Radius, 3>;
+			case 4:
+				return filterRow<Radius, 4>;
+			default:
+				return filterRow<Radius, 0>;
+			}
+		}
+
+		Kernels::FilterRow selectFilterRow(int radius, int cn)
+		{
+			switch (radius)
+			{
+			case 1:
+				return selectChannels<1>(cn);
+			case 2:
+				return selectChannels<2>(cn);
+			case 3:
+				return selectChannels<3>(cn);
+			case 4:
+				return selectChannels<4>(cn);
+			default:
+				return filterRow<0, 0>;
+			}
+		}
+
+		Kernels::WeightedSum selectWeightedSum(int taps)
+		{
+			switch (taps)
+			{
+			case 3:
+				return weightedSumRow<3>;
+			case 5:
+				return weightedSumRow<5>;
+			case 7:
+				return weightedSumRow<7>;
+			case 9:
+				return weightedSumRow<9>;
+			default:
+				return weightedSumRow<0>;
+			}
+		}
+	}
+}
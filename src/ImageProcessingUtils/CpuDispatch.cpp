@@ -0,0 +1,131 @@
+#include "CpuDispatch.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#define IPU_X86_CPUID 1
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define IPU_X86_CPUID 1
+#endif
+
+namespace
+{
+	const char* const NAMES[CpuDispatch::LEVELS] = { "baseline", "sse42", "avx2", "avx512" };
+
+#ifdef IPU_X86_CPUID
+	struct Registers
+	{
+		unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+	};
+
+	Registers cpuid(unsigned leaf, unsigned subleaf)
+	{
+		Registers r;
+#ifdef _MSC_VER
+		int info[4];
+		__cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+		r.eax = info[0];
+		r.ebx = info[1];
+		r.ecx = info[2];
+		r.edx = info[3];
+#else
+		__cpuid_count(leaf, subleaf, r.eax, r.ebx, r.ecx, r.edx);
+#endif
+		return r;
+	}
+
+	// the register states the operating system saves on a context switch
+	unsigned long long enabledStates()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		unsigned eax, edx;
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+	}
+
+	CpuDispatch::Level detect()
+	{
+		const unsigned maxLeaf = cpuid(0, 0).eax;
+		const Registers features = cpuid(1, 0);
+
+		const bool sse42 = (features.ecx & (1u << 20)) && (features.ecx & (1u << 9));
+		if (!sse42)
+			return CpuDispatch::Baseline;
+
+		// AVX needs the OS to save the YMM registers (XCR0 bits 1 and 2), AVX-512 the opmask and ZMM ones as well (bits 5 to 7)
+		const bool osxsave = (features.ecx & (1u << 27)) && (features.ecx & (1u << 28));
+		const unsigned long long states = osxsave ? enabledStates() : 0;
+		if ((states & 0x06) != 0x06 || maxLeaf < 7)
+			return CpuDispatch::Sse42;
+
+		const Registers extended = cpuid(7, 0);
+		if (!(extended.ebx & (1u << 5)))
+			return CpuDispatch::Sse42;
+
+		const bool avx512 = (extended.ebx & (1u << 16)) && (extended.ebx & (1u << 30));
+		if (!avx512 || (states & 0xE0) != 0xE0)
+			return CpuDispatch::Avx2;
+
+		return CpuDispatch::Avx512;
+	}
+#else
+	CpuDispatch::Level detect()
+	{
+		return CpuDispatch::Baseline;
+	}
+#endif
+
+	CpuDispatch::Level choose()
+	{
+		const CpuDispatch::Level best = CpuDispatch::supported();
+
+		CpuDispatch::Level forced;
+		const char* value = std::getenv(CpuDispatch::ENVIRONMENT_VARIABLE);
+		if (value != nullptr && CpuDispatch::parse(value, forced))
+			return std::min(forced, best);
+
+		return best;
+	}
+}
+
+const char* const CpuDispatch::ENVIRONMENT_VARIABLE = "IPU_CPU_LEVEL";
+
+CpuDispatch::Level CpuDispatch::supported()
+{
+	static const Level detected = detect();
+	return detected;
+}
+
+CpuDispatch::Level CpuDispatch::level()
+{
+	static const Level chosen = choose();
+	return chosen;
+}
+
+const char* CpuDispatch::name(Level level)
+{
+	return level >= Baseline && level < LEVELS ? NAMES[level] : "";
+}
+
+bool CpuDispatch::parse(const std::string& name, Level& level)
+{
+	std::string lower = name;
+	std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+	for (int i = 0; i < LEVELS; i++)
+		if (lower == NAMES[i])
+		{
+			level = static_cast<Level>(i);
+			return true;
+		}
+
+	return false;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief Detects the instruction sets of the CPU and picks the level of the kernel variants the library runs.
+ * @details The level is chosen once, the first time it is asked for: the best level the CPU and the operating system
+ support, unless the IPU_CPU_LEVEL environment variable names a lower one. Setting it to baseline, sse42, avx2 or avx512
+ runs that variant of every kernel, so each variant can be tested on any machine that supports it.
+ A level above the supported one is lowered to it, since its instructions could not run.
+ */
+class IMAGEPROCESSINGUTILS_API CpuDispatch
+{
+public:
+	/**
+	 * @brief The instruction set levels, each including the ones before it.
+	 */
+	enum Level
+	{
+		Baseline,	// SSE2, which every x64 CPU has
+		Sse42,		// SSE4.2 and SSSE3
+		Avx2,
+		Avx512,		// AVX-512 F and BW
+		LEVELS
+	};
+
+	/**
+	 * @brief The environment variable that forces a level.
+	 */
+	static const char* const ENVIRONMENT_VARIABLE;
+
+	/**
+	 * @brief Gets the best level the CPU and the operating system support.
+	 */
+	static Level supported();
+
+	/**
+	 * @brief Gets the level the kernels run at, chosen on the first call.
+	 */
+	static Level level();
+
+	/**
+	 * @brief Gets the name of a level, as IPU_CPU_LEVEL takes it.
+	 */
+	static const char* name(Level level);
+
+	/**
+	 * @brief Reads the name of a level.
+	 * @param[in] name The name, in any case.
+	 * @param[out] level The level, left untouched when the name is unknown.
+	 * @return Returns true if the name is the one of a level.
+	 */
+	static bool parse(const std::string& name, Level& level);
+};
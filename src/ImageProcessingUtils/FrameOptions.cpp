@@ -80,6 +80,22 @@ short FrameOptions::getAdaptiveThresholdingValue() const {
 	return adaptiveThresholdingValue;
 }
 
+void FrameOptions::setAdaptiveBlockSize(const short& val) {
+	adaptiveBlockSize = val;
+}
+
+short FrameOptions::getAdaptiveBlockSize() const {
+	return adaptiveBlockSize;
+}
+
+void FrameOptions::setAdaptiveC(const short& val) {
+	adaptiveC = val;
+}
+
+short FrameOptions::getAdaptiveC() const {
+	return adaptiveC;
+}
+
 void FrameOptions::setGrayscaleHistogramEqualization(const bool& val) {
 	grayscaleHistogramEqualization = val;
 }
@@ -96,6 +112,54 @@ bool FrameOptions::getColorHistogramEqualization() const {
 	return colorHistogramEqualization;
 }
 
+void FrameOptions::setEqualizationStride(const short& val) {
+	equalizationStride = val;
+}
+
+short FrameOptions::getEqualizationStride() const {
+	return equalizationStride;
+}
+
+void FrameOptions::setEqualizationDrift(const short& val) {
+	equalizationDrift = val;
+}
+
+short FrameOptions::getEqualizationDrift() const {
+	return equalizationDrift;
+}
+
+void FrameOptions::setDetectionInterval(const short& val) {
+	detectionInterval = val;
+}
+
+short FrameOptions::getDetectionInterval() const {
+	return detectionInterval;
+}
+
+void FrameOptions::setClahe(const bool& val) {
+	clahe = val;
+}
+
+bool FrameOptions::getClahe() const {
+	return clahe;
+}
+
+void FrameOptions::setClaheTiles(const short& val) {
+	claheTiles = val;
+}
+
+short FrameOptions::getClaheTiles() const {
+	return claheTiles;
+}
+
+void FrameOptions::setClaheClipLimit(const short& val) {
+	claheClipLimit = val;
+}
+
+short FrameOptions::getClaheClipLimit() const {
+	return claheClipLimit;
+}
+
 void FrameOptions::setSobel(const bool& val) {
 	sobel = val;
 }
@@ -114,6 +178,46 @@ bool FrameOptions::getTriangleThresholding() const
 	return triangleThresholding;
 }
 
+void FrameOptions::setAutoThresholding(const bool& val)
+{
+	autoThresholding = val;
+}
+
+bool FrameOptions::getAutoThresholding() const
+{
+	return autoThresholding;
+}
+
+void FrameOptions::setAutoThresholdMethod(const short& val)
+{
+	autoThresholdMethod = val;
+}
+
+short FrameOptions::getAutoThresholdMethod() const
+{
+	return autoThresholdMethod;
+}
+
+void FrameOptions::setAutoThresholdPercentile(const short& val)
+{
+	autoThresholdPercentile = val;
+}
+
+short FrameOptions::getAutoThresholdPercentile() const
+{
+	return autoThresholdPercentile;
+}
+
+void FrameOptions::setAutoThresholdSmoothing(const short& val)
+{
+	autoThresholdSmoothing = val;
+}
+
+short FrameOptions::getAutoThresholdSmoothing() const
+{
+	return autoThresholdSmoothing;
+}
+
 void FrameOptions::setBinomial(const short& val)
 {
 	binomial = val;
@@ -1,3 +1,4 @@
+#pragma once
 #include "RevertableOptions.h"
 
 #include <string>
@@ -10,13 +11,25 @@ private:
 	short zeroThresholdingValue = 0;
 	short truncThresholdingValue = 0;
 	short adaptiveThresholdingValue = 0;
+	short adaptiveBlockSize = 11;
+	short adaptiveC = 2;
 	short binomial = 0;
 	short sobel = 0;
 	short canny = 0;
 	short opening = 0;
+	short claheTiles = 8;
+	short claheClipLimit = 20;
+	short autoThresholdMethod = 1;
+	short autoThresholdPercentile = 50;
+	short autoThresholdSmoothing = 50;
+	short equalizationStride = 4;
+	short equalizationDrift = 10;
+	short detectionInterval = 0;
 	bool colorHistogramEqualization = false;
 	bool grayscaleHistogramEqualization = false;
+	bool clahe = false;
 	bool triangleThresholding = false;
+	bool autoThresholding = false;
 	bool showFeatures = false;
 	bool flipH = true; // on camera, it's true by default
 	bool flipV = false;
@@ -135,6 +148,28 @@ public:
 	 */
 	short getAdaptiveThresholdingValue() const;
 
+	/**
+	 * @brief Sets the neighborhood size used by adaptive thresholding.
+	 * @param[in] val The side of the square neighborhood, in pixels.
+	 */
+	void setAdaptiveBlockSize(const short& val);
+	/**
+	 * @brief Gets the neighborhood size used by adaptive thresholding.
+	 * @return Returns the side of the square neighborhood, in pixels.
+	 */
+	short getAdaptiveBlockSize() const;
+
+	/**
+	 * @brief Sets the constant used by adaptive thresholding.
+	 * @param[in] val The percentage by which the local mean is lowered.
+	 */
+	void setAdaptiveC(const short& val);
+	/**
+	 * @brief Gets the constant used by adaptive thresholding.
+	 * @return Returns the percentage by which the local mean is lowered.
+	 */
+	short getAdaptiveC() const;
+
 	/**
 	 * @brief Sets whether to equalize the histogram of an image or not.
 	 * @param[in] val The boolean value to be set.
@@ -149,12 +184,123 @@ public:
 	void setColorHistogramEqualization(const bool& val);
 	bool getColorHistogramEqualization() const;
 
+	/**
+	 * @brief Sets the sampling stride of the histogram equalization of a video.
+	 * @param[in] val One pixel in val x val is counted.
+	 */
+	void setEqualizationStride(const short& val);
+	/**
+	 * @brief Gets the sampling stride of the histogram equalization of a video.
+	 * @return Returns the distance between the counted pixels.
+	 */
+	short getEqualizationStride() const;
+
+	/**
+	 * @brief Sets how far the histogram of a video drifts before its equalization table is rebuilt.
+	 * @param[in] val The distance between the running histogram and the one of the table, in tenths of a percent.
+	 */
+	void setEqualizationDrift(const short& val);
+	/**
+	 * @brief Gets how far the histogram of a video drifts before its equalization table is rebuilt.
+	 * @return Returns the distance in tenths of a percent.
+	 */
+	short getEqualizationDrift() const;
+
+	/**
+	 * @brief Sets how often the detector runs on a video.
+	 * @param[in] val 0 to detect every frame before it is shown; otherwise the detector runs in the background on at most one frame
+	 in val, whenever it is idle, and its detections are tracked on the frames in between.
+	 */
+	void setDetectionInterval(const short& val);
+	/**
+	 * @brief Gets how often the detector runs on a video.
+	 * @return Returns the least number of frames between two detected ones, or 0 if every frame is detected.
+	 */
+	short getDetectionInterval() const;
+
+	/**
+	 * @brief Sets whether to apply contrast limited adaptive histogram equalization or not.
+	 * @param[in] val The boolean value to be set.
+	 */
+	void setClahe(const bool& val);
+	/**
+	 * @brief Gets whether to apply contrast limited adaptive histogram equalization or not.
+	 * @return Returns true if CLAHE is to be applied, otherwise returns false.
+	 */
+	bool getClahe() const;
+
+	/**
+	 * @brief Sets the tile grid of CLAHE.
+	 * @param[in] val The number of tiles across and down.
+	 */
+	void setClaheTiles(const short& val);
+	/**
+	 * @brief Gets the tile grid of CLAHE.
+	 * @return Returns the number of tiles across and down.
+	 */
+	short getClaheTiles() const;
+
+	/**
+	 * @brief Sets the clip limit of CLAHE.
+	 * @param[in] val The clip limit in tenths of the mean bin count of a tile, or 0 not to clip.
+	 */
+	void setClaheClipLimit(const short& val);
+	/**
+	 * @brief Gets the clip limit of CLAHE.
+	 * @return Returns the clip limit in tenths of the mean bin count of a tile.
+	 */
+	short getClaheClipLimit() const;
+
 	void setSobel(const bool& val);
 	short getSobel() const;
 
 	void setTriangleThresholding(const bool& val);
 	bool getTriangleThresholding() const;
 
+	/**
+	 * @brief Sets whether to binarize the image at an automatic threshold or not.
+	 * @param[in] val The boolean value to be set.
+	 */
+	void setAutoThresholding(const bool& val);
+	/**
+	 * @brief Gets whether to binarize the image at an automatic threshold or not.
+	 * @return Returns true if automatic thresholding is to be applied, otherwise returns false.
+	 */
+	bool getAutoThresholding() const;
+
+	/**
+	 * @brief Sets the method of automatic thresholding.
+	 * @param[in] val The AutoThreshold::Method.
+	 */
+	void setAutoThresholdMethod(const short& val);
+	/**
+	 * @brief Gets the method of automatic thresholding.
+	 * @return Returns the AutoThreshold::Method.
+	 */
+	short getAutoThresholdMethod() const;
+
+	/**
+	 * @brief Sets the percentile of the percentile method of automatic thresholding.
+	 * @param[in] val The percentage of the pixels that are set to black.
+	 */
+	void setAutoThresholdPercentile(const short& val);
+	/**
+	 * @brief Gets the percentile of the percentile method of automatic thresholding.
+	 * @return Returns the percentage of the pixels that are set to black.
+	 */
+	short getAutoThresholdPercentile() const;
+
+	/**
+	 * @brief Sets how much the automatic threshold of a video is smoothed over its frames.
+	 * @param[in] val The weight of the previous frames, in percent.
+	 */
+	void setAutoThresholdSmoothing(const short& val);
+	/**
+	 * @brief Gets how much the automatic threshold of a video is smoothed over its frames.
+	 * @return Returns the weight of the previous frames, in percent.
+	 */
+	short getAutoThresholdSmoothing() const;
+
 	void setBinomial(const short& val);
 	short getBinomial() const;
 
@@ -0,0 +1,214 @@
+#pragma once
+
+#include "BoundedQueue.h"
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief A chain of stages that process a stream of items on their own threads, with a bounded queue in front of each stage.
+ * @details Every stage pops items from its queue, works on them and pushes them into the queue of the next stage,
+ the last one into the output queue the consumer takes from. The stages thus work on different items at the same time:
+ while one stage processes item N, the one before it already processes item N + 1, and the throughput is the one
+ of the slowest stage instead of the sum of all of them. A full queue applies the Backpressure of its stage.
+ A stage with several workers processes several items at once, and may then deliver them out of order.
+ An optional source runs on its own thread and feeds the first stage.
+ The pipeline is configured, started once and stopped; the items still queued when it stops are discarded.
+ */
+template<typename Item>
+class FramePipeline
+{
+public:
+	/**
+	 * @brief The work of a stage on one item. It runs on the workers of the stage and must not throw.
+	 * @return Returns false to drop the item, which then goes no further.
+	 */
+	typedef std::function<bool(Item&)> Work;
+
+	/**
+	 * @brief Produces the next item for the first stage. It should not wait for long, since stop() waits for it to return.
+	 * @return Returns false if there was no item yet, in which case it is called again.
+	 */
+	typedef std::function<bool(Item&)> Source;
+
+	struct StageMetrics
+	{
+		std::string name;
+		// the queue in front of the stage
+		QueueMetrics queue;
+		// the items the stage has worked on
+		uint64_t processed = 0;
+	};
+
+	FramePipeline() = default;
+
+	~FramePipeline()
+	{
+		stop();
+	}
+
+	FramePipeline(const FramePipeline&) = delete;
+	FramePipeline& operator=(const FramePipeline&) = delete;
+
+	/**
+	 * @brief Appends a stage.
+	 * @param[in] name The name of the stage, in the metrics.
+	 * @param[in] work The work of the stage.
+	 * @param[in] workers The number of threads of the stage, at least 1.
+	 * @param[in] capacity The number of items the queue in front of the stage holds.
+	 * @param[in] policy What a push into the full queue does.
+	 */
+	void addStage(const std::string& name, Work work, int workers, size_t capacity, Backpressure policy)
+	{
+		CV_Assert(!started && workers >= 1);
+
+		std::unique_ptr<Stage> stage(new Stage(capacity, policy));
+		stage->name = name;
+		stage->work = std::move(work);
+		stage->workers = workers;
+		stages.push_back(std::move(stage));
+	}
+
+	/**
+	 * @brief Sets the queue the last stage pushes into, which the consumer takes from. By default it holds one item and drops the oldest.
+	 */
+	void setOutput(size_t capacity, Backpressure policy)
+	{
+		CV_Assert(!started);
+		output.reset(new BoundedQueue<Item>(capacity, policy));
+	}
+
+	/**
+	 * @brief Sets a source that feeds the first stage from its own thread, instead of submit().
+	 */
+	void setSource(Source produce)
+	{
+		CV_Assert(!started);
+		source = std::move(produce);
+	}
+
+	/**
+	 * @brief Starts the workers of every stage, and the source.
+	 */
+	void start()
+	{
+		CV_Assert(!started && !stages.empty());
+		started = true;
+
+		for (size_t i = 0; i < stages.size(); i++)
+		{
+			Stage& stage = *stages[i];
+			BoundedQueue<Item>& next = i + 1 < stages.size() ? *stages[i + 1]->input : *output;
+			for (int w = 0; w < stage.workers; w++)
+				threads.emplace_back([&stage, &next] {
+					Item item;
+					while (stage.input->pop(item))
+					{
+						const bool keep = stage.work(item);
+						stage.processed++;
+						if (keep && !next.push(std::move(item)))
+							break;
+					}
+					});
+		}
+
+		if (source)
+			threads.emplace_back([this] {
+				while (!stopping)
+				{
+					Item item;
+					if (source(item) && !stages.front()->input->push(std::move(item)))
+						break;
+				}
+				});
+	}
+
+	/**
+	 * @brief Stops the source and the workers, once they are done with their current item, and discards the items of every queue.
+	 * @details No stage starts on another item once stop() is called, so a slow stage only delays it by the item it works on.
+	 */
+	void stop()
+	{
+		stopping = true;
+		for (const std::unique_ptr<Stage>& stage : stages)
+			stage->input->cancel();
+		output->cancel();
+
+		for (std::thread& thread : threads)
+			thread.join();
+		threads.clear();
+	}
+
+	/**
+	 * @brief Pushes an item into the queue of the first stage.
+	 * @return Returns false once the pipeline is stopped.
+	 */
+	bool submit(Item item)
+	{
+		return stages.front()->input->push(std::move(item));
+	}
+
+	/**
+	 * @brief Takes the next item out of the last stage, waiting for one at most timeout.
+	 * @return Returns false on timeout, or once the pipeline is stopped.
+	 */
+	bool take(Item& item, std::chrono::milliseconds timeout)
+	{
+		return output->popFor(item, timeout);
+	}
+
+	/**
+	 * @brief Gets the queue and the counters of every stage, in order, followed by the output queue under the name "output".
+	 */
+	std::vector<StageMetrics> metrics() const
+	{
+		std::vector<StageMetrics> result;
+		for (const std::unique_ptr<Stage>& stage : stages)
+		{
+			StageMetrics metrics;
+			metrics.name = stage->name;
+			metrics.queue = stage->input->metrics();
+			metrics.processed = stage->processed;
+			result.push_back(metrics);
+		}
+
+		StageMetrics last;
+		last.name = "output";
+		last.queue = output->metrics();
+		result.push_back(last);
+		return result;
+	}
+
+private:
+	struct Stage
+	{
+		Stage(size_t capacity, Backpressure policy)
+			: input(new BoundedQueue<Item>(capacity, policy))
+		{
+		}
+
+		std::string name;
+		Work work;
+		int workers = 1;
+		std::unique_ptr<BoundedQueue<Item>> input;
+		std::atomic<uint64_t> processed{ 0 };
+	};
+
+	std::vector<std::unique_ptr<Stage>> stages;
+	std::unique_ptr<BoundedQueue<Item>> output{ new BoundedQueue<Item>(1, Backpressure::DropOldest) };
+	Source source;
+	std::vector<std::thread> threads;
+	std::atomic<bool> stopping{ false };
+	bool started = false;
+};
@@ -0,0 +1,85 @@
+#include "FrameRing.h"
+
+#include <utility>
+
+FrameRing::FrameRing(size_t capacity)
+	: slots(capacity)
+{
+	// the producer fills a slot while the consumer exchanges another one
+	CV_Assert(capacity >= 2);
+}
+
+size_t FrameRing::capacity() const
+{
+	return slots.size();
+}
+
+FrameRing::Frame& FrameRing::beginWrite()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	writing = sequence == 0 ? 0 : (newest + 1) % slots.size();
+	return slots[writing];
+}
+
+void FrameRing::publish()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		Frame& frame = slots[writing];
+		frame.sequence = ++sequence;
+		frame.timestamp = std::chrono::steady_clock::now();
+		newest = writing;
+	}
+	arrived.notify_one();
+}
+
+bool FrameRing::takeNewest(Frame& frame)
+{
+	if (taken == sequence)
+		return false;
+
+	skipped += sequence - taken - 1;
+	taken = sequence;
+	std::swap(frame, slots[newest]);
+	return true;
+}
+
+bool FrameRing::takeLatest(Frame& frame)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return takeNewest(frame);
+}
+
+bool FrameRing::waitLatest(Frame& frame, std::chrono::milliseconds timeout)
+{
+	std::unique_lock<std::mutex> guard(lock);
+	arrived.wait_for(guard, timeout, [this] { return taken != sequence || ended; });
+	return takeNewest(frame);
+}
+
+void FrameRing::close()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		ended = true;
+	}
+	arrived.notify_all();
+}
+
+bool FrameRing::closed() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return ended;
+}
+
+uint64_t FrameRing::published() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return sequence;
+}
+
+uint64_t FrameRing::dropped() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return skipped;
+}
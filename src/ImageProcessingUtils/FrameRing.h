@@ -0,0 +1,114 @@
+#pragma once
+
+#include "SharedFrame.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief A fixed ring of frames between one producer, like a camera thread, and one consumer that only wants the newest frame.
+ * @details The producer fills the slot after the newest frame, which holds the oldest one, and publishes it: a frame
+ the consumer has not taken yet is overwritten rather than waited for, so the producer never blocks.
+ The consumer takes the newest frame by exchanging it with a frame of its own, which goes back into the ring.
+ The buffers thus circulate between the two sides: once the slots have been filled, a frame is captured into a buffer
+ that already has its size, unless something still shares it (see SharedFrame::reuse()).
+ Every published frame is numbered, and the frames the consumer never takes are counted as dropped.
+ */
+class IMAGEPROCESSINGUTILS_API FrameRing
+{
+public:
+	struct Frame
+	{
+		SharedFrame image;
+		// 1 for the first frame published, 0 for a frame that never was
+		uint64_t sequence = 0;
+		// when the frame was published
+		std::chrono::steady_clock::time_point timestamp;
+	};
+
+	static const size_t DEFAULT_CAPACITY = 4;
+
+	/**
+	 * @brief Creates a ring of empty slots.
+	 * @param[in] capacity The number of slots, at least 2.
+	 */
+	explicit FrameRing(size_t capacity = DEFAULT_CAPACITY);
+
+	/**
+	 * @brief Gets the number of slots.
+	 */
+	size_t capacity() const;
+
+	/**
+	 * @brief Gets the slot the producer fills next.
+	 * @details It is the slot after the newest frame, so the oldest frame is the one dropped. The consumer never touches it
+	 until publish(), so the producer may fill it without holding any lock. Every call must be followed by publish().
+	 * @return The slot. Only its image is meant to be written.
+	 */
+	Frame& beginWrite();
+
+	/**
+	 * @brief Publishes the slot of the last beginWrite() as the newest frame, numbering and stamping it, and wakes the consumer.
+	 */
+	void publish();
+
+	/**
+	 * @brief Takes the newest frame, if the consumer has not taken it yet.
+	 * @details The frames published since the last one taken and before this one are counted as dropped.
+	 * @param[in,out] frame The frame of the consumer, which goes back into the ring in exchange for the newest one.
+	 * @return Returns true if a new frame was taken; frame is left untouched otherwise.
+	 */
+	bool takeLatest(Frame& frame);
+
+	/**
+	 * @brief Takes the newest frame, waiting for one if the consumer has taken them all.
+	 * @param[in,out] frame The frame of the consumer, as in takeLatest().
+	 * @param[in] timeout The longest wait.
+	 * @return Returns true if a new frame was taken, false on timeout or once the ring is closed.
+	 */
+	bool waitLatest(Frame& frame, std::chrono::milliseconds timeout);
+
+	/**
+	 * @brief Marks the end of the stream, waking a waiting consumer. The frame published last can still be taken.
+	 */
+	void close();
+
+	/**
+	 * @brief Gets whether close() was called.
+	 */
+	bool closed() const;
+
+	/**
+	 * @brief Gets the number of frames published.
+	 */
+	uint64_t published() const;
+
+	/**
+	 * @brief Gets the number of frames published before the newest one taken that the consumer never took.
+	 */
+	uint64_t dropped() const;
+
+private:
+	bool takeNewest(Frame& frame);
+
+	std::vector<Frame> slots;
+	// the slot the producer fills, and the one of the newest frame
+	size_t writing = 0;
+	size_t newest = 0;
+	// the sequence of the newest frame, and of the last one taken
+	uint64_t sequence = 0;
+	uint64_t taken = 0;
+	uint64_t skipped = 0;
+	bool ended = false;
+	mutable std::mutex lock;
+	std::condition_variable arrived;
+};
@@ -0,0 +1,183 @@
+#include "Gradient.h"
+#include "Convolution.h"
+#include "Kernels.h"
+#include "RowBands.h"
+#include "SobelWeights.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	std::vector<int> sobelWeights(int radius, bool vertical)
+	{
+		const int size = 2 * radius + 1;
+		std::vector<int> weights(size * size);
+
+		for (int i = -radius; i <= radius; i++)
+			for (int j = -radius; j <= radius; j++)
+				weights[(i + radius) * size + j + radius] = sobelWeight(i, j, vertical);
+
+		return weights;
+	}
+
+	// The number of fractional bits the 16-bit derivatives can keep: the largest derivative is 255 times
+	// the sum of the positive weights, in 1 / 2^SOBEL_WEIGHT_BITS units.
+	int fractionBits(int radius)
+	{
+		CV_Assert(radius >= 0);
+
+		long long positive = 0;
+		for (int w : sobelWeights(radius, false))
+			positive += std::max(w, 0);
+
+		int bits = 0;
+		while (bits < SOBEL_WEIGHT_BITS && 255 * positive * (2LL << bits) <= 32767LL << SOBEL_WEIGHT_BITS)
+			bits++;
+
+		return bits;
+	}
+
+	GradientEngine::Direction directionOf(double sx, double sy)
+	{
+		const double ax = std::abs(sx), ay = std::abs(sy);
+
+		if ((ax + ay) * (ax + ay) <= 2 * ax * ax)
+			return GradientEngine::Horizontal;
+		if (ay > ax && (ay - ax) * (ay - ax) > 2 * ax * ax)
+			return GradientEngine::Vertical;
+		return (sx > 0) == (sy > 0) ? GradientEngine::Diagonal : GradientEngine::AntiDiagonal;
+	}
+
+	// The sweep of a float image: both derivatives go through the float engine of Convolution with the integer weights
+	// in float, then a second pass over the rows derives the magnitude and the direction from them.
+	// The derivatives are the real ones, so there is no scale to apply.
+	void computeFloat(const cv::Mat& src, int radius, const GradientEngine::Outputs& outputs, int borderType)
+	{
+		const float unit = 1.0f / (1 << SOBEL_WEIGHT_BITS);
+		std::vector<float> kernelX, kernelY;
+		for (int w : sobelWeights(radius, false))
+			kernelX.push_back(w * unit);
+		for (int w : sobelWeights(radius, true))
+			kernelY.push_back(w * unit);
+
+		cv::Mat gx, gy;
+		cv::Mat& sumX = outputs.gx != nullptr ? *outputs.gx : gx;
+		cv::Mat& sumY = outputs.gy != nullptr ? *outputs.gy : gy;
+		Convolution::filter(src, sumX, kernelX.data(), radius, borderType);
+		Convolution::filter(src, sumY, kernelY.data(), radius, borderType);
+
+		if (outputs.magnitude == nullptr && outputs.direction == nullptr)
+			return;
+
+		const int cols = src.cols;
+
+		RowBands::Traits traits;
+		traits.rowBytes = cols * (2 * sizeof(float) + sizeof(float) + 1);
+
+		RowBands::run(src.rows, traits, [&](const cv::Range& range) {
+			for (int y = range.start; y < range.end; y++)
+			{
+				const float* dx = sumX.ptr<float>(y);
+				const float* dy = sumY.ptr<float>(y);
+
+				if (outputs.magnitude != nullptr)
+				{
+					for (int x = 0; x < cols; x++)
+					{
+						const float m = std::sqrt(dx[x] * dx[x] + dy[x] * dy[x]);
+						switch (outputs.magnitudeDepth)
+						{
+						case CV_8U:
+							outputs.magnitude->ptr<uchar>(y)[x] = cv::saturate_cast<uchar>(m);
+							break;
+						case CV_16U:
+							outputs.magnitude->ptr<ushort>(y)[x] = cv::saturate_cast<ushort>(m);
+							break;
+						default:
+							outputs.magnitude->ptr<float>(y)[x] = m;
+							break;
+						}
+					}
+				}
+
+				if (outputs.direction != nullptr)
+				{
+					uchar* out = outputs.direction->ptr<uchar>(y);
+					for (int x = 0; x < cols; x++)
+						out[x] = static_cast<uchar>(directionOf(dx[x], dy[x]));
+				}
+			}
+			});
+	}
+}
+
+int GradientEngine::scale(int radius)
+{
+	return 1 << fractionBits(radius);
+}
+
+void GradientEngine::compute(const cv::Mat& src, int radius, const Outputs& outputs, int borderType)
+{
+	CV_Assert((src.type() == CV_8UC1 || src.type() == CV_32FC1) && radius >= 0);
+	CV_Assert(outputs.magnitudeDepth == CV_8U || outputs.magnitudeDepth == CV_16U || outputs.magnitudeDepth == CV_32F);
+
+	const int rows = src.rows;
+	const int cols = src.cols;
+	const int size = 2 * radius + 1;
+
+	const int derivativeType = src.depth() == CV_8U ? CV_16SC1 : CV_32FC1;
+	if (outputs.gx != nullptr)
+		outputs.gx->create(src.size(), derivativeType);
+	if (outputs.gy != nullptr)
+		outputs.gy->create(src.size(), derivativeType);
+	if (outputs.magnitude != nullptr)
+		outputs.magnitude->create(src.size(), CV_MAKETYPE(outputs.magnitudeDepth, 1));
+	if (outputs.direction != nullptr)
+		outputs.direction->create(src.size(), CV_8UC1);
+
+	if (src.depth() == CV_32F)
+	{
+		computeFloat(src, radius, outputs, borderType);
+		return;
+	}
+
+	cv::Mat padded;
+	cv::copyMakeBorder(src, padded, radius, radius, radius, radius, borderType);
+
+	const Kernels& kernels = Kernels::active();
+	const Kernels::DerivativeRow derivatives = kernels.derivativeRow(radius);
+	const std::vector<int> weightsX = sobelWeights(radius, false);
+	const std::vector<int> weightsY = sobelWeights(radius, true);
+	const int shift = SOBEL_WEIGHT_BITS - fractionBits(radius);
+
+	// the padded source is read, so the outputs never alias it
+	RowBands::Traits traits;
+	traits.halo = radius;
+	traits.rowBytes = padded.cols + cols * (2 * sizeof(int) + 2 * sizeof(short) + sizeof(float) + 1);
+
+	RowBands::run(rows, traits, [&](const cv::Range& range) {
+		std::vector<const uchar*> taps(size);
+		std::vector<int> sumX(cols), sumY(cols);
+
+		for (int y = range.start; y < range.end; y++)
+		{
+			for (int i = 0; i < size; i++)
+				taps[i] = padded.ptr<uchar>(y + i) + radius;
+
+			derivatives(taps.data(), sumX.data(), sumY.data(), cols, weightsX.data(), weightsY.data(), radius);
+
+			if (outputs.gx != nullptr)
+				kernels.derivativeStore(sumX.data(), outputs.gx->ptr<short>(y), cols, shift);
+			if (outputs.gy != nullptr)
+				kernels.derivativeStore(sumY.data(), outputs.gy->ptr<short>(y), cols, shift);
+
+			if (outputs.magnitude != nullptr)
+				kernels.magnitudeRow(sumX.data(), sumY.data(), outputs.magnitude->ptr(y), cols, outputs.magnitudeDepth);
+
+			if (outputs.direction != nullptr)
+				kernels.directionRow(sumX.data(), sumY.data(), outputs.direction->ptr<uchar>(y), cols);
+		}
+		});
+}
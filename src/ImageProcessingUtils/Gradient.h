@@ -0,0 +1,58 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief Fused computation of the image gradient used by sobel() and canny().
+ * @details The derivative kernels weigh the pixel at offset (i, j) with 2 * j / (i^2 + j^2) horizontally and 2 * i / (i^2 + j^2) vertically.
+ Their weights are held as integers with 12 fractional bits, so both derivatives are accumulated exactly in 32-bit integers.
+ A single sweep over the image then writes only the outputs the caller asked for, one row at a time while the sums are still in cache.
+ Kernels of radius 1 to 4 are compile-time constants, so their zero taps disappear and the loops unroll.
+ Float images, which the algorithms make of 16-bit and float frames, take the same weights in float through Convolution::filter().
+ */
+class IMAGEPROCESSINGUTILS_API GradientEngine
+{
+public:
+	/**
+	 * @brief Gradient direction, quantized to the axis along which non-maximum suppression compares neighbours.
+	 */
+	enum Direction { Horizontal, Diagonal, Vertical, AntiDiagonal };
+
+	/**
+	 * @brief The outputs of compute(). A null pointer means that the output is not needed.
+	 */
+	struct Outputs
+	{
+		// CV_16SC1 derivatives, multiplied by scale(radius) and rounded; CV_32FC1 derivatives of a float image
+		cv::Mat* gx = nullptr;
+		cv::Mat* gy = nullptr;
+		// gradient magnitude, of depth magnitudeDepth: CV_8U or CV_16U (rounded and saturated) or CV_32F
+		cv::Mat* magnitude = nullptr;
+		int magnitudeDepth = CV_32F;
+		// CV_8UC1 Direction of every pixel. Diagonal is the direction in which x and y grow together (Gx * Gy > 0).
+		cv::Mat* direction = nullptr;
+	};
+
+	/**
+	 * @brief Computes the requested gradient outputs of a single-channel 8-bit or float image.
+	 * @param[in] src The CV_8UC1 or CV_32FC1 image, usually already smoothed.
+	 * @param[in] radius The kernel radius. A radius of 0 gives a null gradient.
+	 * @param[in] outputs The outputs to compute.
+	 * @param[in] borderType The OpenCV border mode used for the pixels outside the image.
+	 */
+	static void compute(const cv::Mat& src, int radius, const Outputs& outputs, int borderType = cv::BORDER_REFLECT_101);
+
+	/**
+	 * @brief Gets the factor between the CV_16S derivatives and the real ones.
+	 * @details It is the largest power of two, at most 4096, for which the derivatives of any 8-bit image fit in 16 bits.
+	 * @param[in] radius The kernel radius.
+	 * @return The scale of the derivatives.
+	 */
+	static int scale(int radius);
+};
@@ -0,0 +1,375 @@
+#pragma once
+
+// The row kernels of GradientEngine, compiled once per CpuDispatch level through Kernels.simd.h.
+
+#include "Gradient.h"
+#include "Kernels.h"
+#include "SobelWeights.h"
+#include "Simd.h"
+
+#include <cmath>
+
+namespace IPU_SIMD_NAMESPACE
+{
+	namespace
+	{
+		template<int Radius>
+		struct SobelWeights
+		{
+			static const int SIZE = 2 * Radius + 1;
+			int x[SIZE * SIZE];
+			int y[SIZE * SIZE];
+
+			constexpr SobelWeights() : x(), y()
+			{
+				for (int i = -Radius; i <= Radius; i++)
+					for (int j = -Radius; j <= Radius; j++)
+					{
+						x[(i + Radius) * SIZE + j + Radius] = sobelWeight(i, j, false);
+						y[(i + Radius) * SIZE + j + Radius] = sobelWeight(i, j, true);
+					}
+			}
+		};
+
+		template<int Radius>
+		struct ConstantWeights
+		{
+			static constexpr SobelWeights<Radius> weights = SobelWeights<Radius>();
+		};
+
+		// rows[i] points to pixel 0 of padded row i. A Radius of 0 takes the radius and the weights from the arguments,
+		// otherwise they are compile-time constants and the pairs of zero taps are skipped without a runtime test.
+		template<int Radius>
+		void derivativeRow(const uchar* const* rows, int* sumX, int* sumY, int cols, const int* weightsX, const int* weightsY, int radius)
+		{
+			const int r = Radius > 0 ? Radius : radius;
+			const int size = 2 * r + 1;
+			const int taps = size * size;
+			const int* wx = weightsX;
+			const int* wy = weightsY;
+			if constexpr (Radius > 0)
+			{
+				wx = ConstantWeights<Radius>::weights.x;
+				wy = ConstantWeights<Radius>::weights.y;
+			}
+
+			// the taps are taken two at a time: interleaving their pixels lets one madd apply both weights
+			int x = 0;
+#ifdef IPU_AVX512
+			// the 16-bit interleaving works within 128-bit lanes, so the sums come out with their lanes interleaved
+			// and a two-register permute puts them back in pixel order
+			const __m512i first = _mm512_set_epi64(11, 10, 3, 2, 9, 8, 1, 0);
+			const __m512i second = _mm512_set_epi64(15, 14, 7, 6, 13, 12, 5, 4);
+			for (; x <= cols - 32; x += 32)
+			{
+				__m512i sx0 = _mm512_setzero_si512(), sx1 = sx0, sy0 = sx0, sy1 = sx0;
+
+				for (int t = 0; t < taps; t += 2)
+				{
+					const int wx0 = wx[t], wy0 = wy[t];
+					const int wx1 = t + 1 < taps ? wx[t + 1] : 0;
+					const int wy1 = t + 1 < taps ? wy[t + 1] : 0;
+					if (wx0 == 0 && wx1 == 0 && wy0 == 0 && wy1 == 0)
+						continue;
+
+					const uchar* p0 = rows[t / size] + x + t % size - r;
+					__m512i a = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p0)));
+					__m512i b = _mm512_setzero_si512();
+					if (t + 1 < taps)
+					{
+						const uchar* p1 = rows[(t + 1) / size] + x + (t + 1) % size - r;
+						b = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p1)));
+					}
+
+					__m512i lo = _mm512_unpacklo_epi16(a, b);
+					__m512i hi = _mm512_unpackhi_epi16(a, b);
+					__m512i px = _mm512_set1_epi32(static_cast<int>((static_cast<unsigned>(wx1) << 16) | (wx0 & 0xffff)));
+					__m512i py = _mm512_set1_epi32(static_cast<int>((static_cast<unsigned>(wy1) << 16) | (wy0 & 0xffff)));
+
+					sx0 = _mm512_add_epi32(sx0, _mm512_madd_epi16(lo, px));
+					sx1 = _mm512_add_epi32(sx1, _mm512_madd_epi16(hi, px));
+					sy0 = _mm512_add_epi32(sy0, _mm512_madd_epi16(lo, py));
+					sy1 = _mm512_add_epi32(sy1, _mm512_madd_epi16(hi, py));
+				}
+
+				_mm512_storeu_si512(sumX + x, _mm512_permutex2var_epi64(sx0, first, sx1));
+				_mm512_storeu_si512(sumX + x + 16, _mm512_permutex2var_epi64(sx0, second, sx1));
+				_mm512_storeu_si512(sumY + x, _mm512_permutex2var_epi64(sy0, first, sy1));
+				_mm512_storeu_si512(sumY + x + 16, _mm512_permutex2var_epi64(sy0, second, sy1));
+			}
+#endif
+#ifdef IPU_AVX2
+			for (; x <= cols - 16; x += 16)
+			{
+				__m256i sx0 = _mm256_setzero_si256(), sx1 = sx0, sy0 = sx0, sy1 = sx0;
+
+				for (int t = 0; t < taps; t += 2)
+				{
+					const int wx0 = wx[t], wy0 = wy[t];
+					const int wx1 = t + 1 < taps ? wx[t + 1] : 0;
+					const int wy1 = t + 1 < taps ? wy[t + 1] : 0;
+					if (wx0 == 0 && wx1 == 0 && wy0 == 0 && wy1 == 0)
+						continue;
+
+					const uchar* p0 = rows[t / size] + x + t % size - r;
+					__m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p0)));
+					__m256i b = _mm256_setzero_si256();
+					if (t + 1 < taps)
+					{
+						const uchar* p1 = rows[(t + 1) / size] + x + (t + 1) % size - r;
+						b = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p1)));
+					}
+
+					__m256i lo = _mm256_unpacklo_epi16(a, b);
+					__m256i hi = _mm256_unpackhi_epi16(a, b);
+					__m256i px = _mm256_set1_epi32(static_cast<int>((static_cast<unsigned>(wx1) << 16) | (wx0 & 0xffff)));
+					__m256i py = _mm256_set1_epi32(static_cast<int>((static_cast<unsigned>(wy1) << 16) | (wy0 & 0xffff)));
+
+					sx0 = _mm256_add_epi32(sx0, _mm256_madd_epi16(lo, px));
+					sx1 = _mm256_add_epi32(sx1, _mm256_madd_epi16(hi, px));
+					sy0 = _mm256_add_epi32(sy0, _mm256_madd_epi16(lo, py));
+					sy1 = _mm256_add_epi32(sy1, _mm256_madd_epi16(hi, py));
+				}
+
+				// lo holds the pixels 0-3 and 8-11, hi the pixels 4-7 and 12-15
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(sumX + x), _mm256_permute2x128_si256(sx0, sx1, 0x20));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(sumX + x + 8), _mm256_permute2x128_si256(sx0, sx1, 0x31));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(sumY + x), _mm256_permute2x128_si256(sy0, sy1, 0x20));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(sumY + x + 8), _mm256_permute2x128_si256(sy0, sy1, 0x31));
+			}
+#endif
+#ifdef IPU_SSE2
+			const __m128i zero = _mm_setzero_si128();
+			for (; x <= cols - 8; x += 8)
+			{
+				__m128i sx0 = zero, sx1 = zero, sy0 = zero, sy1 = zero;
+
+				for (int t = 0; t < taps; t += 2)
+				{
+					const int wx0 = wx[t], wy0 = wy[t];
+					const int wx1 = t + 1 < taps ? wx[t + 1] : 0;
+					const int wy1 = t + 1 < taps ? wy[t + 1] : 0;
+					if (wx0 == 0 && wx1 == 0 && wy0 == 0 && wy1 == 0)
+						continue;
+
+					const uchar* p0 = rows[t / size] + x + t % size - r;
+					__m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p0)), zero);
+					__m128i b = zero;
+					if (t + 1 < taps)
+					{
+						const uchar* p1 = rows[(t + 1) / size] + x + (t + 1) % size - r;
+						b = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p1)), zero);
+					}
+
+					__m128i lo = _mm_unpacklo_epi16(a, b);
+					__m128i hi = _mm_unpackhi_epi16(a, b);
+					__m128i px = _mm_set1_epi32(static_cast<int>((static_cast<unsigned>(wx1) << 16) | (wx0 & 0xffff)));
+					__m128i py = _mm_set1_epi32(static_cast<int>((static_cast<unsigned>(wy1) << 16) | (wy0 & 0xffff)));
+
+					sx0 = _mm_add_epi32(sx0, _mm_madd_epi16(lo, px));
+					sx1 = _mm_add_epi32(sx1, _mm_madd_epi16(hi, px));
+					sy0 = _mm_add_epi32(sy0, _mm_madd_epi16(lo, py));
+					sy1 = _mm_add_epi32(sy1, _mm_madd_epi16(hi, py));
+				}
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(sumX + x), sx0);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(sumX + x + 4), sx1);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(sumY + x), sy0);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(sumY + x + 4), sy1);
+			}
+#endif
+			for (; x < cols; x++)
+			{
+				int sx = 0, sy = 0;
+				for (int t = 0; t < taps; t++)
+				{
+					int pixel = rows[t / size][x + t % size - r];
+					sx += wx[t] * pixel;
+					sy += wy[t] * pixel;
+				}
+				sumX[x] = sx;
+				sumY[x] = sy;
+			}
+		}
+
+		Kernels::DerivativeRow selectDerivativeRow(int radius)
+		{
+			switch (radius)
+			{
+			case 1:
+				return derivativeRow<1>;
+			case 2:
+				return derivativeRow<2>;
+			case 3:
+				return derivativeRow<3>;
+			case 4:
+				return derivativeRow<4>;
+			default:
+				return derivativeRow<0>;
+			}
+		}
+
+		// (sum + half) >> shift, saturated to 16 bits
+		void derivativeStore(const int* sum, short* out, int cols, int shift)
+		{
+			const int half = shift > 0 ? 1 << (shift - 1) : 0;
+
+			int x = 0;
+#ifdef IPU_AVX512
+			const __m512i h16 = _mm512_set1_epi32(half);
+			const __m128i count16 = _mm_cvtsi32_si128(shift);
+			for (; x <= cols - 16; x += 16)
+			{
+				__m512i v = _mm512_sra_epi32(_mm512_add_epi32(_mm512_loadu_si512(sum + x), h16), count16);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm512_cvtsepi32_epi16(v));
+			}
+#endif
+#ifdef IPU_AVX2
+			const __m256i h8 = _mm256_set1_epi32(half);
+			const __m128i count8 = _mm_cvtsi32_si128(shift);
+			for (; x <= cols - 16; x += 16)
+			{
+				__m256i a = _mm256_sra_epi32(_mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(sum + x)), h8), count8);
+				__m256i b = _mm256_sra_epi32(_mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(sum + x + 8)), h8), count8);
+				// the pack works within 128-bit lanes, so the 64-bit quarters are put back in order
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8));
+			}
+#endif
+#ifdef IPU_SSE2
+			const __m128i h = _mm_set1_epi32(half);
+			const __m128i count = _mm_cvtsi32_si128(shift);
+			for (; x <= cols - 8; x += 8)
+			{
+				__m128i a = _mm_sra_epi32(_mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sum + x)), h), count);
+				__m128i b = _mm_sra_epi32(_mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sum + x + 4)), h), count);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packs_epi32(a, b));
+			}
+#endif
+			for (; x < cols; x++)
+			{
+				const int v = (sum[x] + half) >> shift;
+				out[x] = static_cast<short>(v < -32768 ? -32768 : v > 32767 ? 32767 : v);
+			}
+		}
+
+		inline float magnitude(int sx, int sy)
+		{
+			float fx = static_cast<float>(sx);
+			float fy = static_cast<float>(sy);
+			return sqrtf(fx * fx + fy * fy) * (1.0f / (1 << SOBEL_WEIGHT_BITS));
+		}
+
+		void magnitudeRow(const int* sumX, const int* sumY, uchar* out, int cols, int depth)
+		{
+			const float unit = 1.0f / (1 << SOBEL_WEIGHT_BITS);
+			int x = 0;
+
+			if (depth == CV_32F)
+			{
+				float* m = reinterpret_cast<float*>(out);
+#ifdef IPU_AVX512
+				for (; x <= cols - 16; x += 16)
+				{
+					__m512 fx = _mm512_cvtepi32_ps(_mm512_loadu_si512(sumX + x));
+					__m512 fy = _mm512_cvtepi32_ps(_mm512_loadu_si512(sumY + x));
+					_mm512_storeu_ps(m + x, _mm512_mul_ps(_mm512_sqrt_ps(_mm512_add_ps(_mm512_mul_ps(fx, fx), _mm512_mul_ps(fy, fy))), _mm512_set1_ps(unit)));
+				}
+#endif
+#ifdef IPU_AVX2
+				for (; x <= cols - 8; x += 8)
+				{
+					__m256 fx = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(sumX + x)));
+					__m256 fy = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(sumY + x)));
+					_mm256_storeu_ps(m + x, _mm256_mul_ps(_mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(fx, fx), _mm256_mul_ps(fy, fy))), _mm256_set1_ps(unit)));
+				}
+#endif
+#ifdef IPU_SSE2
+				for (; x <= cols - 4; x += 4)
+				{
+					__m128 fx = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sumX + x)));
+					__m128 fy = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sumY + x)));
+					_mm_storeu_ps(m + x, _mm_mul_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(fx, fx), _mm_mul_ps(fy, fy))), _mm_set1_ps(unit)));
+				}
+#endif
+				for (; x < cols; x++)
+					m[x] = magnitude(sumX[x], sumY[x]);
+			}
+			else if (depth == CV_16U)
+			{
+				ushort* m = reinterpret_cast<ushort*>(out);
+				for (; x < cols; x++)
+				{
+					const float v = magnitude(sumX[x], sumY[x]) + 0.5f;
+					m[x] = static_cast<ushort>(v < 65535.0f ? v : 65535.0f);
+				}
+			}
+			else
+			{
+#ifdef IPU_AVX512
+				for (; x <= cols - 16; x += 16)
+				{
+					__m512 fx = _mm512_cvtepi32_ps(_mm512_loadu_si512(sumX + x));
+					__m512 fy = _mm512_cvtepi32_ps(_mm512_loadu_si512(sumY + x));
+					__m512 v = _mm512_mul_ps(_mm512_sqrt_ps(_mm512_add_ps(_mm512_mul_ps(fx, fx), _mm512_mul_ps(fy, fy))), _mm512_set1_ps(unit));
+					__m512i rounded = _mm512_cvttps_epi32(_mm512_min_ps(_mm512_add_ps(v, _mm512_set1_ps(0.5f)), _mm512_set1_ps(255.0f)));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm512_cvtepi32_epi8(rounded));
+				}
+#endif
+#ifdef IPU_AVX2
+				for (; x <= cols - 8; x += 8)
+				{
+					__m256 fx = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(sumX + x)));
+					__m256 fy = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(sumY + x)));
+					__m256 v = _mm256_mul_ps(_mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(fx, fx), _mm256_mul_ps(fy, fy))), _mm256_set1_ps(unit));
+					__m256i rounded = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_add_ps(v, _mm256_set1_ps(0.5f)), _mm256_set1_ps(255.0f)));
+					__m128i words = _mm_packs_epi32(_mm256_castsi256_si128(rounded), _mm256_extracti128_si256(rounded, 1));
+					_mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(words, words));
+				}
+#endif
+#ifdef IPU_SSE2
+				const __m128 unit4 = _mm_set1_ps(unit);
+				const __m128 half = _mm_set1_ps(0.5f);
+				const __m128 limit = _mm_set1_ps(255.0f);
+				for (; x <= cols - 8; x += 8)
+				{
+					__m128i v[2];
+					for (int k = 0; k < 2; k++)
+					{
+						__m128 fx = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sumX + x + 4 * k)));
+						__m128 fy = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sumY + x + 4 * k)));
+						__m128 m = _mm_mul_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(fx, fx), _mm_mul_ps(fy, fy))), unit4);
+						v[k] = _mm_cvttps_epi32(_mm_min_ps(_mm_add_ps(m, half), limit));
+					}
+					__m128i packed = _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_setzero_si128());
+					_mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), packed);
+				}
+#endif
+				for (; x < cols; x++)
+				{
+					const float v = magnitude(sumX[x], sumY[x]) + 0.5f;
+					out[x] = static_cast<uchar>(v < 255.0f ? v : 255.0f);
+				}
+			}
+		}
+
+		// tan(22.5) = sqrt(2) - 1 and tan(67.5) = sqrt(2) + 1, so the sector boundaries are exact integer tests:
+		// |gy| < (sqrt(2) - 1) |gx|  <=>  (|gx| + |gy|)^2 < 2 gx^2 (also taken by the null gradient)
+		// |gy| > (sqrt(2) + 1) |gx|  <=>  |gy| > |gx| and (|gy| - |gx|)^2 > 2 gx^2
+		void directionRow(const int* sumX, const int* sumY, uchar* out, int cols)
+		{
+			for (int x = 0; x < cols; x++)
+			{
+				const int sx = sumX[x], sy = sumY[x];
+				const long long ax = sx < 0 ? -static_cast<long long>(sx) : sx;
+				const long long ay = sy < 0 ? -static_cast<long long>(sy) : sy;
+
+				if ((ax + ay) * (ax + ay) <= 2 * ax * ax)
+					out[x] = GradientEngine::Horizontal;
+				else if (ay > ax && (ay - ax) * (ay - ax) > 2 * ax * ax)
+					out[x] = GradientEngine::Vertical;
+				else
+					out[x] = (sx > 0) == (sy > 0) ? GradientEngine::Diagonal : GradientEngine::AntiDiagonal;
+			}
+		}
+	}
+}
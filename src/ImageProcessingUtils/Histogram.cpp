@@ -0,0 +1,227 @@
+#include "Histogram.h"
+#include "RowBands.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+	const int LANES = 4;
+	const int MIN_BAND_ROWS = 16;
+	// every band of a wide histogram clears and merges 256 KB of bins
+	const int MIN_WIDE_BAND_ROWS = 64;
+
+	void countRows(const cv::Mat& src, int begin, int end, Histogram::Bins& bins)
+	{
+		uint32_t lanes[LANES][Histogram::BINS] = {};
+		const int cols = src.cols;
+
+		for (int y = begin; y < end; y++)
+		{
+			const uchar* row = src.ptr<uchar>(y);
+
+			int x = 0;
+			for (; x <= cols - LANES; x += LANES)
+			{
+				lanes[0][row[x]]++;
+				lanes[1][row[x + 1]]++;
+				lanes[2][row[x + 2]]++;
+				lanes[3][row[x + 3]]++;
+			}
+			for (; x < cols; x++)
+				lanes[0][row[x]]++;
+		}
+
+		for (int i = 0; i < Histogram::BINS; i++)
+			bins[i] = lanes[0][i] + lanes[1][i] + lanes[2][i] + lanes[3][i];
+	}
+
+	void countWideRows(const cv::Mat& src, int begin, int end, Histogram::WideBins& bins)
+	{
+		bins.assign(Histogram::WIDE_BINS, 0);
+		const int cols = src.cols;
+
+		for (int y = begin; y < end; y++)
+		{
+			if (src.depth() == CV_16U)
+			{
+				const ushort* row = src.ptr<ushort>(y);
+				for (int x = 0; x < cols; x++)
+					bins[row[x]]++;
+			}
+			else
+			{
+				const float* row = src.ptr<float>(y);
+				for (int x = 0; x < cols; x++)
+					bins[Histogram::wideBin(row[x])]++;
+			}
+		}
+	}
+
+	// The functions below serve the 256 bins and the wide bins alike, with the size of the histogram in place of BINS.
+	template<typename Counts>
+	Counts cumulativeOf(const Counts& histogram)
+	{
+		Counts cdf = histogram;
+		uint32_t sum = 0;
+
+		for (size_t i = 0; i < histogram.size(); i++)
+		{
+			sum += histogram[i];
+			cdf[i] = sum;
+		}
+
+		return cdf;
+	}
+
+	template<typename Counts, typename Value>
+	void equalize(const Counts& cdf, Value* lut)
+	{
+		const int size = static_cast<int>(cdf.size());
+		const uint64_t low = cdf[0];
+		const uint64_t range = cdf[size - 1] - low;
+
+		if (range == 0)
+		{
+			for (int i = 0; i < size; i++)
+				lut[i] = static_cast<Value>(i);
+			return;
+		}
+
+		// round((size - 1) * (cdf - low) / range) without leaving integer arithmetic
+		const uint64_t top = 2 * static_cast<uint64_t>(size - 1);
+		for (int i = 0; i < size; i++)
+			lut[i] = static_cast<Value>((top * (cdf[i] - low) + range) / (2 * range));
+	}
+
+	template<typename Counts>
+	int triangle(const Counts& histogram)
+	{
+		const int bins = static_cast<int>(histogram.size());
+		const int peak = static_cast<int>(std::max_element(histogram.begin(), histogram.end()) - histogram.begin());
+		const uint32_t low = *std::min_element(histogram.begin(), histogram.end());
+		const uint32_t high = histogram[peak];
+		const float height = high > low ? static_cast<float>(high - low) : 1.0f;
+
+		const bool darkPeak = peak < bins / 2;
+		const int first = darkPeak ? peak : 0;
+		const int last = darkPeak ? bins - 1 : peak;
+		const int size = last - first + 1;
+
+		float maxDistance = 0;
+		int threshold = 0;
+
+		for (int i = first; i <= last; i++)
+		{
+			float x = static_cast<float>(i - first) / static_cast<float>(last - first);
+			float y = (static_cast<float>(histogram[i]) - low) / height;
+			float distance = darkPeak ? (1 - x) - y : x - y;
+
+			if (distance > maxDistance)
+			{
+				maxDistance = distance;
+				threshold = i - first;
+			}
+		}
+
+		if (darkPeak)
+			return bins - size + static_cast<int>(threshold + size * 0.2);
+
+		return static_cast<int>(threshold - size * 0.2);
+	}
+}
+
+Histogram::Bins Histogram::compute(const cv::Mat& src)
+{
+	CV_Assert(src.type() == CV_8UC1);
+
+	// every band clears and merges four lane histograms, so it is kept at least MIN_BAND_ROWS tall
+	RowBands::Traits traits;
+	traits.rowBytes = src.cols;
+	traits.granularity = MIN_BAND_ROWS;
+
+	const std::vector<cv::Range> bands = RowBands::split(src.rows, traits);
+	std::vector<Bins> partial(bands.size());
+
+	RowBands::forEachBand(bands, [&](int band) {
+		countRows(src, bands[band].start, bands[band].end, partial[band]);
+		});
+
+	Bins result{};
+	for (const Bins& bins : partial)
+		for (int i = 0; i < BINS; i++)
+			result[i] += bins[i];
+
+	return result;
+}
+
+Histogram::WideBins Histogram::computeWide(const cv::Mat& src)
+{
+	CV_Assert(src.type() == CV_16UC1 || src.type() == CV_32FC1);
+
+	RowBands::Traits traits;
+	traits.rowBytes = src.cols * src.elemSize();
+	traits.granularity = MIN_WIDE_BAND_ROWS;
+
+	const std::vector<cv::Range> bands = RowBands::split(src.rows, traits);
+	std::vector<WideBins> partial(bands.size());
+
+	RowBands::forEachBand(bands, [&](int band) {
+		countWideRows(src, bands[band].start, bands[band].end, partial[band]);
+		});
+
+	WideBins result(WIDE_BINS, 0);
+	for (const WideBins& bins : partial)
+		for (int i = 0; i < WIDE_BINS; i++)
+			result[i] += bins[i];
+
+	return result;
+}
+
+double Histogram::wideBinValue(int bin, int depth)
+{
+	CV_Assert(depth == CV_16U || depth == CV_32F);
+	return depth == CV_16U ? bin : bin / (WIDE_BINS - 1.0);
+}
+
+Histogram::Bins Histogram::cumulative(const Bins& histogram)
+{
+	return cumulativeOf(histogram);
+}
+
+Histogram::WideBins Histogram::cumulative(const WideBins& histogram)
+{
+	return cumulativeOf(histogram);
+}
+
+void Histogram::equalizationLut(const Bins& cdf, uchar* lut)
+{
+	equalize(cdf, lut);
+}
+
+void Histogram::equalizationLut(const WideBins& cdf, ushort* lut)
+{
+	CV_Assert(cdf.size() == WIDE_BINS);
+	equalize(cdf, lut);
+}
+
+int Histogram::triangleThreshold(const Bins& histogram)
+{
+	return triangle(histogram);
+}
+
+int Histogram::triangleThreshold(const WideBins& histogram)
+{
+	CV_Assert(!histogram.empty());
+	return triangle(histogram);
+}
+
+Histogram::Bins Histogram::remap(const Bins& histogram, const uchar* lut)
+{
+	Bins result{};
+
+	for (int i = 0; i < BINS; i++)
+		result[lut[i]] += histogram[i];
+
+	return result;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief 256-bin histograms of 8-bit images, 65536-bin histograms of 16-bit and float images, and the tables derived from them.
+ * @details The bins are plain integer arrays. The histogram of an image is built in parallel row bands,
+ each band counting into its own sub-histograms which are merged at the end, so no bin is ever shared between threads.
+ The wide histograms keep every level of a 16-bit image, so the tables derived from them map every level on its own
+ rather than groups of 256 levels. Every function on the bins works the same on both sizes.
+ */
+class IMAGEPROCESSINGUTILS_API Histogram
+{
+public:
+	static const int BINS = 256;
+	typedef std::array<uint32_t, BINS> Bins;
+
+	static const int WIDE_BINS = 65536;
+	typedef std::vector<uint32_t> WideBins;
+
+	/**
+	 * @brief Counts the pixels of a single-channel 8-bit image.
+	 * @details Inside a band, consecutive pixels are counted into interleaved copies of the bins,
+	 so runs of equal pixels do not keep incrementing the same counter back to back
+	 (each increment would otherwise wait for the previous store to the same address).
+	 * @param[in] src The CV_8UC1 image.
+	 * @return The number of pixels of every value.
+	 */
+	static Bins compute(const cv::Mat& src);
+
+	/**
+	 * @brief Counts the pixels of a single-channel 16-bit or float image into WIDE_BINS bins.
+	 * @details A 16-bit pixel counts in the bin of its value, a float pixel in wideBin() of its value.
+	 Each band counts into a single copy of the bins, which is already large enough for equal pixels to be rare neighbours in it.
+	 * @param[in] src The CV_16UC1 or CV_32FC1 image.
+	 * @return The number of pixels in every bin.
+	 */
+	static WideBins computeWide(const cv::Mat& src);
+
+	/**
+	 * @brief Gets the wide bin of a float pixel: round(65535 v), with v clamped to [0, 1] and NaN counted as 0.
+	 */
+	static int wideBin(float value)
+	{
+		const float v = value > 0 ? (value < 1 ? value : 1) : 0;
+		return static_cast<int>(v * (WIDE_BINS - 1) + 0.5f);
+	}
+
+	/**
+	 * @brief Gets the pixel value of a wide bin: the bin itself for a 16-bit image, bin / 65535 for a float image.
+	 * @param[in] bin The bin, from 0 to WIDE_BINS - 1.
+	 * @param[in] depth CV_16U or CV_32F.
+	 */
+	static double wideBinValue(int bin, int depth);
+
+	/**
+	 * @brief Computes the cumulative distribution of a histogram.
+	 * @param[in] histogram The histogram.
+	 * @return For every bin, the number of pixels less than or equal to it.
+	 */
+	static Bins cumulative(const Bins& histogram);
+	static WideBins cumulative(const WideBins& histogram);
+
+	/**
+	 * @brief Builds the histogram equalization lookup table from a cumulative distribution.
+	 * @details The distribution is stretched linearly so that its smallest count maps to 0 and the total to the last bin,
+	 rounding to the nearest value. When every pixel is in the first bin the table is the identity.
+	 * @param[in] cdf The cumulative distribution, as returned by cumulative().
+	 * @param[out] lut The table, with one entry per bin: 256 entries from 0 to 255, or 65536 from 0 to 65535.
+	 */
+	static void equalizationLut(const Bins& cdf, uchar* lut);
+	static void equalizationLut(const WideBins& cdf, ushort* lut);
+
+	/**
+	 * @brief Finds the triangle threshold of a histogram.
+	 * @details The histogram is normalized to [0, 1] on both axes, between its peak and the far end of the value range.
+	 The threshold is the bin furthest below the line joining the two ends, moved by a fifth of the range away from the peak.
+	 * @param[in] histogram The histogram.
+	 * @return The threshold, as a bin.
+	 */
+	static int triangleThreshold(const Bins& histogram);
+	static int triangleThreshold(const WideBins& histogram);
+
+	/**
+	 * @brief Computes the histogram an image would have after a lookup table is applied to it.
+	 * @param[in] histogram The histogram of the image.
+	 * @param[in] lut The 256 entry table.
+	 * @return The histogram of the mapped image.
+	 */
+	static Bins remap(const Bins& histogram, const uchar* lut);
+};
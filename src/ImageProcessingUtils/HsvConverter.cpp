@@ -0,0 +1,237 @@
+#include "HsvConverter.h"
+#include "Histogram.h"
+#include "Kernels.h"
+#include "PixelDepth.h"
+#include "RowBands.h"
+
+#include <type_traits>
+
+namespace
+{
+	// V and S are filled with the floating point formulas of the original conversion,
+	// so the rounding of every table entry is the same as before.
+	HsvConverter::Tables buildTables()
+	{
+		HsvConverter::Tables t;
+
+		for (int max = 0; max < 256; max++)
+		{
+			double cmax = max / 255.0;
+			t.value[max] = static_cast<uchar>(cmax * 100 * 2.55);
+
+			for (int min = 0; min <= max; min++)
+			{
+				double s = max == 0 ? 0 : ((cmax - min / 255.0) / cmax) * 100;
+				t.saturation[max][min] = static_cast<uchar>(s * 2.55);
+			}
+		}
+
+		t.reciprocal[0] = 0;
+		for (uint32_t d = 1; d < 256; d++)
+			t.reciprocal[d] = ((1u << 24) + d - 1) / d;
+
+		return t;
+	}
+
+	// Every conversion is pointwise: it reads a pixel of src and writes 3 channels per pixel.
+	template<typename RowFunction>
+	void forEachRow(const cv::Mat& src, RowFunction&& row)
+	{
+		RowBands::Traits traits;
+		traits.rowBytes = src.cols * (src.elemSize() + 3 * src.elemSize1());
+
+		RowBands::run(src.rows, traits, [&](const cv::Range& range) {
+			for (int y = range.start; y < range.end; y++)
+				row(y);
+			});
+	}
+
+	// the V of a deep pixel
+	template<typename T>
+	T valueOf(const T* pixel)
+	{
+		const T bg = pixel[0] > pixel[1] ? pixel[0] : pixel[1];
+		return bg > pixel[2] ? bg : pixel[2];
+	}
+
+	// Gives a deep pixel the V newValue, with its H and S: every channel is scaled by newValue / V, and a black pixel,
+	// whose S is 0, becomes the gray of newValue.
+	template<typename T>
+	void scaleValue(const T* in, T newValue, T* out)
+	{
+		const T value = valueOf(in);
+
+		for (int c = 0; c < 3; c++)
+		{
+			if (value == 0)
+				out[c] = newValue;
+			else if constexpr (std::is_same<T, float>::value)
+				out[c] = in[c] * (newValue / value);
+			else
+			{
+				const uint64_t v = value;
+				out[c] = static_cast<T>((2 * static_cast<uint64_t>(in[c]) * newValue + v) / (2 * v));
+			}
+		}
+	}
+
+	bool deepBgr(const cv::Mat& src)
+	{
+		return (src.depth() == CV_16U || src.depth() == CV_32F) && (src.channels() == 3 || src.channels() == 4);
+	}
+}
+
+const HsvConverter::Tables& HsvConverter::tables()
+{
+	static const Tables t = buildTables();
+	return t;
+}
+
+void HsvConverter::bgrToHsv(const cv::Mat& src, cv::Mat& dst)
+{
+	CV_Assert(src.type() == CV_8UC3 || src.type() == CV_8UC4);
+
+	const cv::Mat source = src;
+	const Tables& t = tables();
+	const Kernels& kernels = Kernels::active();
+	const int cn = source.channels();
+
+	dst.create(source.size(), CV_8UC3);
+
+	forEachRow(source, [&](int y) {
+		kernels.bgrToHsvRow(source.ptr<uchar>(y), dst.ptr<uchar>(y), source.cols, cn, t);
+		});
+}
+
+void HsvConverter::hsvToBgr(const cv::Mat& src, cv::Mat& dst)
+{
+	CV_Assert(src.type() == CV_8UC3);
+
+	const cv::Mat source = src;
+	const Kernels& kernels = Kernels::active();
+	dst.create(source.size(), CV_8UC3);
+
+	forEachRow(source, [&](int y) {
+		kernels.hsvToBgrRow(source.ptr<uchar>(y), dst.ptr<uchar>(y), source.cols);
+		});
+}
+
+void HsvConverter::valuePlane(const cv::Mat& src, cv::Mat& value)
+{
+	if (deepBgr(src))
+	{
+		const cv::Mat source = src;
+		const int cn = source.channels();
+		value.create(source.size(), CV_MAKETYPE(source.depth(), 1));
+
+		PixelDepth::dispatch(source.depth(), [&](auto pixel) {
+			typedef decltype(pixel) T;
+			forEachRow(source, [&](int y) {
+				const T* in = source.ptr<T>(y);
+				T* out = value.ptr<T>(y);
+				for (int x = 0; x < source.cols; x++)
+					out[x] = valueOf(in + x * cn);
+				});
+			});
+		return;
+	}
+
+	CV_Assert(src.type() == CV_8UC3 || src.type() == CV_8UC4);
+
+	const cv::Mat source = src;
+	const Tables& t = tables();
+	const Kernels& kernels = Kernels::active();
+	const int cn = source.channels();
+
+	value.create(source.size(), CV_8UC1);
+
+	forEachRow(source, [&](int y) {
+		kernels.valueRow(source.ptr<uchar>(y), value.ptr<uchar>(y), source.cols, cn, t);
+		});
+}
+
+void HsvConverter::replaceValue(const cv::Mat& src, const cv::Mat& value, cv::Mat& dst)
+{
+	if (deepBgr(src))
+	{
+		CV_Assert(value.type() == CV_MAKETYPE(src.depth(), 1) && value.size() == src.size());
+
+		const cv::Mat source = src;
+		const cv::Mat newValue = value;
+		const int cn = source.channels();
+		dst.create(source.size(), CV_MAKETYPE(source.depth(), 3));
+
+		PixelDepth::dispatch(source.depth(), [&](auto pixel) {
+			typedef decltype(pixel) T;
+			forEachRow(source, [&](int y) {
+				const T* in = source.ptr<T>(y);
+				const T* v = newValue.ptr<T>(y);
+				T* out = dst.ptr<T>(y);
+				for (int x = 0; x < source.cols; x++)
+					scaleValue(in + x * cn, v[x], out + x * 3);
+				});
+			});
+		return;
+	}
+
+	CV_Assert(src.type() == CV_8UC3 || src.type() == CV_8UC4);
+	CV_Assert(value.type() == CV_8UC1 && value.size() == src.size());
+
+	const cv::Mat source = src;
+	const Tables& t = tables();
+	const Kernels& kernels = Kernels::active();
+	const int cn = source.channels();
+
+	dst.create(source.size(), CV_8UC3);
+
+	forEachRow(source, [&](int y) {
+		kernels.replaceValueRow(source.ptr<uchar>(y), value.ptr<uchar>(y), dst.ptr<uchar>(y), source.cols, cn, t);
+		});
+}
+
+void HsvConverter::remapValue(const cv::Mat& src, const uchar* lut, cv::Mat& dst)
+{
+	CV_Assert(src.type() == CV_8UC3 || src.type() == CV_8UC4);
+
+	const cv::Mat source = src;
+	const Tables& t = tables();
+	const Kernels& kernels = Kernels::active();
+	const int cn = source.channels();
+
+	// fold the V lookup into the caller's table, so the new V comes straight from max(B, G, R)
+	uchar maxToValue[256];
+	for (int i = 0; i < 256; i++)
+		maxToValue[i] = lut[t.value[i]];
+
+	dst.create(source.size(), CV_8UC3);
+
+	forEachRow(source, [&](int y) {
+		kernels.remapValueRow(source.ptr<uchar>(y), maxToValue, dst.ptr<uchar>(y), source.cols, cn, t);
+		});
+}
+
+void HsvConverter::remapValue(const cv::Mat& src, const ushort* lut, cv::Mat& dst)
+{
+	CV_Assert(deepBgr(src));
+
+	const cv::Mat source = src;
+	const int cn = source.channels();
+	dst.create(source.size(), CV_MAKETYPE(source.depth(), 3));
+
+	forEachRow(source, [&](int y) {
+		if (source.depth() == CV_16U)
+		{
+			const ushort* in = source.ptr<ushort>(y);
+			ushort* out = dst.ptr<ushort>(y);
+			for (int x = 0; x < source.cols; x++, in += cn, out += 3)
+				scaleValue(in, lut[valueOf(in)], out);
+		}
+		else
+		{
+			const float* in = source.ptr<float>(y);
+			float* out = dst.ptr<float>(y);
+			for (int x = 0; x < source.cols; x++, in += cn, out += 3)
+				scaleValue(in, lut[Histogram::wideBin(valueOf(in))] * (1.0f / 65535), out);
+		}
+		});
+}
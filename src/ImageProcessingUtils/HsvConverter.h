@@ -0,0 +1,98 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief Fixed-point conversions between BGR and the 8-bit HSV layout used by the processing algorithms.
+ * @details H is stored in [0, 180) (degrees / 2), S and V in [0, 255].
+ The conversions use integer arithmetic only: divisions by the pixel range are replaced by a table of reciprocals,
+ and V and S come from lookup tables filled with the original floating point formulas,
+ so the forward conversion gives the same bytes as the previous double precision implementation.
+ The inverse conversion is within 1 of it on every channel.
+ Since the algorithms only ever change V, the class also offers V-only paths that go straight from BGR to BGR,
+ keeping the H and S of the source pixels, without ever building the HSV image.
+ The V-only paths also take 16-bit and float images. Their V is max(B, G, R) itself, and a new V that keeps H and S
+ scales the three channels by the same factor, so they need neither the tables nor the HSV layout.
+ All the functions accept 3 or 4 channel sources (alpha is ignored) and process row bands in parallel.
+ */
+class IMAGEPROCESSINGUTILS_API HsvConverter
+{
+public:
+	/**
+	 * @brief Converts a BGR image to HSV.
+	 * @param[in] src The CV_8UC3 or CV_8UC4 source image.
+	 * @param[out] dst The CV_8UC3 HSV image.
+	 */
+	static void bgrToHsv(const cv::Mat& src, cv::Mat& dst);
+
+	/**
+	 * @brief Converts an HSV image back to BGR.
+	 * @param[in] src The CV_8UC3 HSV image.
+	 * @param[out] dst The CV_8UC3 BGR image. It may be the source image.
+	 */
+	static void hsvToBgr(const cv::Mat& src, cv::Mat& dst);
+
+	/**
+	 * @brief Extracts the V plane of a BGR image.
+	 * @details This is the V channel bgrToHsv() would produce, computed from max(B, G, R) with a single lookup.
+	 The V of a 16-bit or float image is max(B, G, R).
+	 * @param[in] src The 3 or 4 channel CV_8U, CV_16U or CV_32F source image.
+	 * @param[out] value The single-channel V plane, of the depth of src.
+	 */
+	static void valuePlane(const cv::Mat& src, cv::Mat& value);
+
+	/**
+	 * @brief Replaces the V channel of a BGR image.
+	 * @details The result is the same as converting src to HSV, replacing its V channel with value
+	 and converting back to BGR, in a single pass over the image. A 16-bit result is rounded to the nearest value.
+	 * @param[in] src The 3 or 4 channel CV_8U, CV_16U or CV_32F source image, which provides H and S.
+	 * @param[in] value The single-channel V plane of the result, of the depth of src.
+	 * @param[out] dst The 3 channel result, of the depth of src. It may be the source image when it has 3 channels.
+	 */
+	static void replaceValue(const cv::Mat& src, const cv::Mat& value, cv::Mat& dst);
+
+	/**
+	 * @brief Maps the V channel of a BGR image through a lookup table.
+	 * @details The result is the same as converting src to HSV, replacing every V with lut[V]
+	 and converting back to BGR, in a single pass over the image.
+	 * @param[in] src The CV_8UC3 or CV_8UC4 source image.
+	 * @param[in] lut The 256 entry table applied to V.
+	 * @param[out] dst The CV_8UC3 result. It may be the source image when it has 3 channels.
+	 */
+	static void remapValue(const cv::Mat& src, const uchar* lut, cv::Mat& dst);
+
+	/**
+	 * @brief Maps the V channel of a 16-bit or float BGR image through a table of Histogram::WIDE_BINS entries.
+	 * @details The V of a 16-bit pixel is replaced by lut[V], the one of a float pixel by lut[Histogram::wideBin(V)] / 65535,
+	 as replaceValue() would replace it.
+	 * @param[in] src The 3 or 4 channel CV_16U or CV_32F source image.
+	 * @param[in] lut The 65536 entry table applied to V.
+	 * @param[out] dst The 3 channel result, of the depth of src. It may be the source image when it has 3 channels.
+	 */
+	static void remapValue(const cv::Mat& src, const ushort* lut, cv::Mat& dst);
+
+	/**
+	 * @brief The lookup tables of the conversions, shared by every kernel variant of Kernels.
+	 */
+	struct Tables
+	{
+		// V for every max(B, G, R)
+		uchar value[256];
+		// S indexed by [max(B, G, R)][min(B, G, R)]
+		uchar saturation[256][256];
+		// ceil(2^24 / d): floor(n / d) == (n * reciprocal[d]) >> 24 for every n < 2^16 and d < 256
+		uint32_t reciprocal[256];
+	};
+
+	/**
+	 * @brief Gets the lookup tables, built on the first call.
+	 */
+	static const Tables& tables();
+};
@@ -0,0 +1,167 @@
+#pragma once
+
+// The row kernels of HsvConverter, compiled once per CpuDispatch level through Kernels.simd.h.
+// They are table driven and branchy, so the variants mostly differ in what the compiler vectorizes on its own.
+
+#include "HsvConverter.h"
+
+#include <cmath>
+#include <cstdint>
+
+namespace IPU_SIMD_NAMESPACE
+{
+	namespace
+	{
+		inline int maxOf(int a, int b, int c)
+		{
+			int m = a > b ? a : b;
+			return m > c ? m : c;
+		}
+
+		inline int minOf(int a, int b, int c)
+		{
+			int m = a < b ? a : b;
+			return m < c ? m : c;
+		}
+
+		// The original floating point hue. Only used for the few pixels whose exact hue falls on an integer,
+		// where the double computation may round either way.
+		uchar referenceHue(int b8, int g8, int r8)
+		{
+			double r = r8 / 255.0;
+			double g = g8 / 255.0;
+			double b = b8 / 255.0;
+
+			double cmax = r > g ? (r > b ? r : b) : (g > b ? g : b);
+			double cmin = r < g ? (r < b ? r : b) : (g < b ? g : b);
+			double diff = cmax - cmin;
+			double h = 0;
+
+			if (cmax == r)
+				h = fmod(60 * ((g - b) / diff) + 360, 360);
+			else if (cmax == g)
+				h = fmod(60 * ((b - r) / diff) + 120, 360);
+			else
+				h = fmod(60 * ((r - g) / diff) + 240, 360);
+
+			return static_cast<uchar>(h / 2);
+		}
+
+		struct Hsv
+		{
+			int h, s, max;
+		};
+
+		inline Hsv decode(const uchar* pixel, const HsvConverter::Tables& t)
+		{
+			int b = pixel[0], g = pixel[1], r = pixel[2];
+			int max = maxOf(r, g, b);
+			int min = minOf(r, g, b);
+			int range = max - min;
+
+			Hsv hsv{ 0, t.saturation[max][min], max };
+			if (range == 0)
+				return hsv;
+
+			// hue / 2 = offset + 30 * num / range, computed as one non-negative quotient
+			int num, offset;
+			if (max == r)
+			{
+				num = g - b;
+				offset = g < b ? 180 : 0;
+			}
+			else if (max == g)
+			{
+				num = b - r;
+				offset = 60;
+			}
+			else
+			{
+				num = r - g;
+				offset = 120;
+			}
+
+			uint32_t n = 30 * num + offset * range;
+			uint32_t q = static_cast<uint32_t>((static_cast<uint64_t>(n) * t.reciprocal[range]) >> 24);
+
+			if (q * range == n && num != 0 && num != range && num != -range)
+				hsv.h = referenceHue(b, g, r);
+			else
+				hsv.h = q;
+
+			return hsv;
+		}
+
+		// Which of { top, middle, bottom } goes to B, G and R in each 60 degree sector.
+		const uchar sectorRoles[6][3] = {
+			{ 2, 1, 0 },
+			{ 2, 0, 1 },
+			{ 1, 0, 2 },
+			{ 0, 1, 2 },
+			{ 0, 2, 1 },
+			{ 1, 2, 0 },
+		};
+
+		// With P = S * V, the channels of an HSV pixel are V, V - P / 255 and V - P * (30 - k) / 7650
+		// (k being the distance of h / 2 to the sector edge), all rounded down.
+		inline void encode(int h, int s, int v, uchar* out)
+		{
+			int p = s * v;
+			int sector = h / 30 < 5 ? h / 30 : 5;
+			int phase = h % 60;
+			int k = phase < 30 ? phase : 60 - phase;
+
+			uchar channels[3];
+			channels[0] = static_cast<uchar>(v);
+			channels[1] = static_cast<uchar>(v - ((30 - k) * p + 7649) / 7650);
+			channels[2] = static_cast<uchar>(v - (p + 254) / 255);
+
+			const uchar* roles = sectorRoles[sector];
+			out[0] = channels[roles[0]];
+			out[1] = channels[roles[1]];
+			out[2] = channels[roles[2]];
+		}
+
+		void bgrToHsvRow(const uchar* in, uchar* out, int cols, int cn, const HsvConverter::Tables& t)
+		{
+			for (int x = 0; x < cols; x++, in += cn, out += 3)
+			{
+				Hsv hsv = decode(in, t);
+				out[0] = static_cast<uchar>(hsv.h);
+				out[1] = static_cast<uchar>(hsv.s);
+				out[2] = t.value[hsv.max];
+			}
+		}
+
+		void hsvToBgrRow(const uchar* in, uchar* out, int cols)
+		{
+			for (int x = 0; x < cols; x++, in += 3, out += 3)
+				encode(in[0], in[1], in[2], out);
+		}
+
+		void valueRow(const uchar* in, uchar* out, int cols, int cn, const HsvConverter::Tables& t)
+		{
+			for (int x = 0; x < cols; x++, in += cn)
+				out[x] = t.value[maxOf(in[0], in[1], in[2])];
+		}
+
+		void replaceValueRow(const uchar* in, const uchar* value, uchar* out, int cols, int cn, const HsvConverter::Tables& t)
+		{
+			for (int x = 0; x < cols; x++, in += cn, out += 3)
+			{
+				Hsv hsv = decode(in, t);
+				encode(hsv.h, hsv.s, value[x], out);
+			}
+		}
+
+		// maxToValue gives the new V of a pixel from its max(B, G, R)
+		void remapValueRow(const uchar* in, const uchar* maxToValue, uchar* out, int cols, int cn, const HsvConverter::Tables& t)
+		{
+			for (int x = 0; x < cols; x++, in += cn, out += 3)
+			{
+				Hsv hsv = decode(in, t);
+				encode(hsv.h, hsv.s, maxToValue[hsv.max], out);
+			}
+		}
+	}
+}
@@ -1,10 +1,23 @@
 #pragma once
+#include "AutoThreshold.h"
 #include "OptionsHistory.h"
+#include "SharedFrame.h"
+#include "StageCache.h"
+#include "VideoState.h"
 #include "Timer.h"
 
 #include <opencv2/opencv.hpp>
 #include <QPainter>
+#include <atomic>
 
+class ProcessingGraph;
+
+/**
+ * @brief The processing algorithms of the menu, on CV_8U, CV_16U and CV_32F images.
+ * @details Every algorithm returns an image of the depth of its source, so a 12-bit camera frame keeps its low bits
+ through the whole pipeline and is only brought to 8 bits by ConvertMat2QImage(), for display.
+ The thresholds and maximum values are on the 8-bit scale for every depth (see PixelDepth).
+ */
 class IMAGEPROCESSINGUTILS_API ProcessingAlgorithms
 {
 public:
@@ -12,8 +25,10 @@ public:
 	 * @brief Applies binary thresholding to an image.
 	 * @details	It sets all pixel values below the specified threshold to 0 and all pixel values above the threshold to 255.
 	 The resulting image is a binary image where all pixels are either black or white.
+	 Colour images are converted to grayscale and the result is returned as BGR;
+	 single-channel images are thresholded without any colour conversion and stay single-channel.
 	 * @param[in] src The source image
-	 * @param[out] dst The destination image
+	 * @param[out] dst The destination image. It may be the source image, in which case a single-channel image is thresholded in place.
 	 * @param[in] threshold The threshold value.
 	 */
 	static void binaryThresholding(cv::Mat src, cv::Mat& dst, short threshold);
@@ -23,33 +38,39 @@ public:
 	 * @details It sets all pixel values below the specified threshold to 0 and leaves all pixel values above the threshold unchanged.
 	 The resulting image is an image where all pixels below the threshold are black
 	 and all pixels above the threshold retain their original values.
-	 Each color channel is computed separately.
+	 Colour images are converted to grayscale and the result is returned as BGR;
+	 single-channel images are thresholded without any colour conversion and stay single-channel.
 	 * @param[in] src The source image
-	 * @param[out] dst The destination image
+	 * @param[out] dst The destination image. It may be the source image, in which case a single-channel image is thresholded in place.
 	 * @param[in] threshold The threshold value.
 	 */
 	static void zeroThresholding(cv::Mat src, cv::Mat& dst, short threshold);
 
 	/**
 	 * @brief Applies adaptive thresholding to an image.
-	 * @details This function applies adaptive thresholding to an image using OpenCV's adaptiveThreshold function.
-	 It calculates a different threshold for each pixel based on its local neighborhood
-	 and then applies binary thresholding using that calculated threshold.
-	 The resulting image is a binary image where all pixels are either black or white.
-	 The size of the local neighborhood and the method used to calculate the thresholds can be adjusted
-	 by changing the parameters of the adaptiveThreshold function call.
+	 * @details It calculates a different threshold for each pixel based on its local neighborhood:
+	 the mean of the blockSize x blockSize window around the pixel, lowered by C percent.
+	 Pixels brighter than their threshold are set to maxValue, the others to 0.
+	 The window sums are maintained incrementally, so the cost per pixel does not depend on the block size,
+	 and the image is processed in parallel row bands (see ThresholdingEngine::adaptive).
+	 Colour images are converted to grayscale and the result is returned as BGR;
+	 single-channel images stay single-channel.
 	 * @param[in] src The source image
 	 * @param[out] dst The destination image
-	 * @param[in] threshold The threshold value.
+	 * @param[in] maxValue The value given to the pixels above their local threshold.
+	 * @param[in] blockSize The size of the local neighborhood.
+	 * @param[in] C The percentage subtracted from the local mean.
 	 */
-	static void adaptiveThresholding(cv::Mat src, cv::Mat& dst, short threshold);
+	static void adaptiveThresholding(cv::Mat src, cv::Mat& dst, short maxValue, short blockSize = 11, short C = 2);
 
 	/**
 	* * @brief Applies truncate thresholding to an image.
 	* @details It sets all pixels above a specified threshold to that threshold value and leaves the pixels with a luminance
 	below the threshold unchanged.
+	Single-channel images are truncated directly and stay single-channel.
 	* @param [in] src The source image
-	* @param[out] dst The destination image
+	* @param[out] dst The destination image. It may be the source image, in which case the image is truncated in place.
+	* @param[in] threshold The threshold value.
 	*/
 	static void truncate(cv::Mat src, cv::Mat& dst, short threshold);
 
@@ -66,31 +87,128 @@ public:
 
 	static void colorHistogramEqualization(cv::Mat src, cv::Mat& dst);
 
+	/**
+	 * @brief Applies contrast limited adaptive histogram equalization (CLAHE) to an image.
+	 * @details Every tile of a tiles x tiles grid is equalized on its own, with its histogram clipped so that noise in flat areas
+	 is not amplified, and the tables of neighbouring tiles are blended bilinearly (see Clahe).
+	 Unevenly lit scenes keep their local contrast, where a global equalization washes out the dark or the bright parts.
+	 Grayscale images are equalized directly. Colour images are equalized on their HSV value, max(B, G, R), and keep their hue and saturation.
+	 * @param[in] src The source image.
+	 * @param[out] dst The destination image: grayscale for a grayscale source, BGR otherwise. It may be the source image.
+	 * @param[in] tiles The number of tiles across and down.
+	 * @param[in] clipLimit The clip limit in tenths: 20 clips every bin at twice the mean count of its tile. 0 does not clip.
+	 */
+	static void clahe(cv::Mat src, cv::Mat& dst, short tiles, short clipLimit);
+
+	/**
+	 * @brief Computes the gradient magnitude of an image.
+	 * @details The image is converted to grayscale and smoothed, then GradientEngine computes the derivatives
+	 and the magnitude in a single sweep. Only the optional outputs that are requested are written.
+	 * @param[in] src The source image.
+	 * @param[out] dst The BGR image of the magnitude, of the depth of src and saturated to its range.
+	 * @param[in] kernelSize The size of the smoothing and derivative kernels. Even sizes behave as the next smaller odd size.
+	 * @param[out] Gx If not null, the CV_16SC1 horizontal derivative, multiplied by GradientEngine::scale(kernelSize / 2).
+	 The derivatives of a 16-bit or float image are CV_32FC1, on the 8-bit scale and without any factor.
+	 * @param[out] Gy If not null, the CV_16SC1 vertical derivative, with the same scale.
+	 * @param[out] magnitude If not null, the CV_32FC1 magnitude, on the 8-bit scale.
+	 */
 	static void sobel(cv::Mat src, cv::Mat& dst, short kernelSize = 3, cv::Mat* Gx = nullptr, cv::Mat* Gy = nullptr, cv::Mat* magnitude = nullptr);
 
+	/**
+	 * @brief Computes the gradient magnitude sobel() displays, as a single-channel image of the depth of src.
+	 * @details The parameters are the ones of sobel(). dst may be the source image.
+	 */
+	static void sobelMagnitude(const cv::Mat& src, cv::Mat& dst, short kernelSize, cv::Mat* Gx = nullptr, cv::Mat* Gy = nullptr, cv::Mat* magnitude = nullptr);
+
+	/**
+	 * @brief Binarizes an image at its triangle threshold, as autoThresholding() with AutoThreshold::Triangle.
+	 */
 	static void triangleThresholding(cv::Mat src, cv::Mat& dst);
 
+	/**
+	 * @brief Binarizes an image at a threshold derived from its histogram.
+	 * @details The image is converted to grayscale once, its histogram is counted once and the threshold is found on it
+	 by one of the methods of AutoThreshold, then the grayscale image is binarized in place in one vectorized pass.
+	 Colour images are returned as BGR; single-channel images stay single-channel.
+	 * @param[in] src The source image.
+	 * @param[out] dst The binary image. It may be the source image.
+	 * @param[in] method The AutoThreshold::Method.
+	 * @param[in] percentile The percentage of black pixels of AutoThreshold::Percentile.
+	 * @param[in,out] temporal If not null, the histograms of the previous frames of a video, which the histogram of this one is blended with.
+	 * @param[in] smoothing The weight of the previous frames in the blend, in percent.
+	 */
+	static void autoThresholding(cv::Mat src, cv::Mat& dst, short method, short percentile, AutoThreshold* temporal = nullptr, short smoothing = 0);
+
 	static void binomial(cv::Mat src, cv::Mat& dst, short kernelSize);
 
+	/**
+	 * @brief Detects the edges of an image with the Canny algorithm.
+	 * @details Pixels whose suppressed gradient magnitude is above the larger threshold are edges,
+	 and so are the pixels above the smaller threshold that are connected to them along a chain of such pixels.
+	 * @param[in] src The source image.
+	 * @param[out] dst The BGR edge map.
+	 * @param[in] threshold1 One of the hysteresis thresholds.
+	 * @param[in] threshold2 The other hysteresis threshold.
+	 * @param[in] kernelSize The size of the smoothing and derivative kernels.
+	 */
 	static void canny(cv::Mat src, cv::Mat& dst, short threshold1, short threshold2, short kernelSize);
 
+	/**
+	 * @brief Computes the Canny edge map canny() displays, as a single-channel image.
+	 * @details With a cache, the gradient is kept under gradientKey, so that new thresholds only redo the suppression and the tracking.
+	 * @param[in] src The source image.
+	 * @param[out] edges The single-channel edge map, of the depth of src: white on the edges and 0 elsewhere. It may be the source image.
+	 * @param[in] threshold1 One of the hysteresis thresholds.
+	 * @param[in] threshold2 The other hysteresis threshold.
+	 * @param[in] kernelSize The size of the smoothing and derivative kernels.
+	 * @param[in,out] cache The cache of the gradient, or nullptr.
+	 * @param[in] gradientKey The key of the gradient of src in the cache.
+	 */
+	static void cannyEdges(const cv::Mat& src, cv::Mat& edges, short threshold1, short threshold2, short kernelSize,
+		StageCache* cache = nullptr, StageCache::Key gradientKey = 0);
+
+	/**
+	 * @brief Applies a morphological opening with a square structuring element.
+	 * @details Grayscale images are opened directly. Color images are opened on their HSV value, max(B, G, R), and keep their hue and saturation.
+	 * @param[in] src The source image.
+	 * @param[out] dst The destination image: grayscale for a grayscale source, BGR otherwise.
+	 * @param[in] kernelSize The size of the structuring element. Even sizes behave as the next larger odd size.
+	 */
 	static void opening(cv::Mat src, cv::Mat& dst, short kernelSize);
 	/**
 	* @brief Applies various image processing algorithms based on the provided options.
 	* @details This function applies a series of image processing algorithms to the input image
 	based on the specified options.
+	The stages pass a ModelImage along, so a colour frame is converted to grayscale once for all its grayscale stages
+	and back to BGR once, at the end. A grayscale frame stays grayscale unless a stage needs colour.
+	With a cache, the result of every stage is stored under the image key combined with the parameters of the stages up to it,
+	and the pipeline resumes from the longest prefix it finds there, so changing a parameter only recomputes the stages from the first
+	one it affects. Canny also keeps its gradient and the histogram stages their histogram, so a threshold change does not recompute them.
 	* @param[in,out] image The input and output cv::Mat image to be processed.
 	* @param[in] options A pointer to a FrameOptions object containing the algorithm activation flags.
 	* @param[in] value The threshold value used in some of the algorithms (e.g., binary thresholding).
+	* @param[in,out] cache The cache of the stage results, or nullptr to compute every stage.
+	* @param[in] imageKey The identity of the input image in the cache: two different images must never share it.
+	* @param[in] cancelled If not null, checked before every stage, so that another thread can stop a run whose result is no longer wanted.
+	* @param[in,out] video If not null, the state of the video the image is a frame of: the automatic thresholds are smoothed
+	over its frames and the histogram equalizations estimate their tables incrementally (see ProcessingGraph::setVideoState()).
+	Its equalizers take the sampling stride and the drift threshold of the options. Nothing is cached.
+	* @param[in,out] graph If not null, the graph the caller keeps for a video: it is only rebuilt when the options change,
+	so the stages reuse its buffers from one frame to the next. Otherwise a graph is built for the call.
+	* @return Returns false if the run was cancelled, in which case image must be discarded.
 	*/
-	static void applyingAlgorithms(cv::Mat& image, FrameOptions* options, const short& value1, const short& value2, const short& kernel);
+	static bool applyingAlgorithms(cv::Mat& image, FrameOptions* options, const short& value1, const short& value2, const short& kernel,
+		StageCache* cache = nullptr, StageCache::Key imageKey = 0, const std::atomic<bool>* cancelled = nullptr, VideoState* video = nullptr,
+		ProcessingGraph* graph = nullptr);
 };
 
 
 /**
  * @brief Converts a cv::Mat to a QImage.
- * @details This function converts a cv::Mat to a QImage.
- It supports 8-bit, 4 channel; 8-bit, 3 channel; and 8-bit, 1 channel cv::Mats.
+ * @details This function converts a cv::Mat to a QImage through SharedFrame, without copying the pixels.
+ It supports 8-bit, 4 channel; 8-bit, 3 channel; and 8-bit, 1 channel cv::Mats, given as Format_ARGB32, Format_BGR888 and Format_Grayscale8 QImages.
+ The QImage keeps the pixels of the cv::Mat alive and is read-only, so Qt copies them before writing.
+ 16-bit and float cv::Mats with the same channels are brought to 8 bits by ToneMap first, into a new buffer.
  If the cv::Mat type is not supported, the function returns false and prints an error message to the console.
  * @param[in] src The source cv::Mat to convert.
  * @param[out] dest The destination QImage to store the converted image.
@@ -100,8 +218,11 @@ bool IMAGEPROCESSINGUTILS_API ConvertMat2QImage(const cv::Mat& src, QImage& dest
 
 /**
  * @brief Converts a QImage to a cv::Mat.
- * @details This function converts a QImage to a cv::Mat.
- It supports Format_ARGB32, Format_ARGB32_Premultiplied, Format_RGB32, Format_RGB888 and Format_Indexed8 QImages.
+ * @details This function converts a QImage to a cv::Mat through SharedFrame.
+ Format_ARGB32, Format_ARGB32_Premultiplied, Format_BGR888, Format_Indexed8, Format_Grayscale8 and Format_Grayscale16 QImages are shared
+ without a copy, and the cv::Mat keeps them alive; writing into it writes into the QImage, so a caller that writes should use SharedFrame::writable().
+ Format_RGB32 and Format_RGB888 QImages are converted to a CV_8UC3 cv::Mat, and the 16-bit Format_RGBX64, Format_RGBA64 and
+ Format_RGBA64_Premultiplied ones of 16-bit image files to a CV_16UC3 one.
  If the QImage format is not supported, the function returns false and prints an error message to the console.
  * @param[in] src The source QImage to convert.
  * @param[out] dest The destination cv::Mat to store the converted image.
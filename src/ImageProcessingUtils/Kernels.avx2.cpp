@@ -0,0 +1,4 @@
+// The AVX2 variant of the kernels, compiled with the flags of its level (see CMakeLists.txt)
+#define IPU_SIMD_NAMESPACE kernels_avx2
+#define IPU_SIMD_LEVEL CpuDispatch::Avx2
+#include "Kernels.simd.h"
@@ -0,0 +1,4 @@
+// The AVX-512 variant of the kernels, compiled with the flags of its level (see CMakeLists.txt)
+#define IPU_SIMD_NAMESPACE kernels_avx512
+#define IPU_SIMD_LEVEL CpuDispatch::Avx512
+#include "Kernels.simd.h"
@@ -0,0 +1,36 @@
+#define IPU_SIMD_NAMESPACE kernels_baseline
+#define IPU_SIMD_LEVEL CpuDispatch::Baseline
+#include "Kernels.simd.h"
+
+// The wider variants, each in its own translation unit (see Kernels.simd.h)
+#ifdef IPU_DISPATCH
+namespace kernels_sse42 { const Kernels& table(); }
+namespace kernels_avx2 { const Kernels& table(); }
+namespace kernels_avx512 { const Kernels& table(); }
+#endif
+
+const Kernels& Kernels::active()
+{
+	static const Kernels* const chosen = &forLevel(CpuDispatch::level());
+	return *chosen;
+}
+
+const Kernels& Kernels::forLevel(CpuDispatch::Level level)
+{
+#ifdef IPU_DISPATCH
+	switch (level)
+	{
+	case CpuDispatch::Avx512:
+		return kernels_avx512::table();
+	case CpuDispatch::Avx2:
+		return kernels_avx2::table();
+	case CpuDispatch::Sse42:
+		return kernels_sse42::table();
+	default:
+		break;
+	}
+#else
+	(void)level;
+#endif
+	return kernels_baseline::table();
+}
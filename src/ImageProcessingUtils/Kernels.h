@@ -0,0 +1,110 @@
+#pragma once
+
+#include "CpuDispatch.h"
+#include "HsvConverter.h"
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief The table of the hot row kernels of the library, one table per CpuDispatch level.
+ * @details Every kernel is written once, in the *.simd.h header of its module, with an SSE2 loop and the wider loops
+ the instruction sets of Simd.h enable. Kernels.cpp compiles them for the baseline, and Kernels.sse42.cpp,
+ Kernels.avx2.cpp and Kernels.avx512.cpp compile them again with the flags of their level, each into its own table.
+ The modules call the kernels through active(), the table of CpuDispatch::level(), so a single build runs the widest
+ variant the CPU supports. All the variants give the same results, bit for bit.
+ */
+class IMAGEPROCESSINGUTILS_API Kernels
+{
+public:
+	/**
+	 * @brief A row of a float convolution: rows[k] points to element 0 of padded row k.
+	 */
+	typedef void (*FilterRow)(const float* const* rows, const float* kernel, float* out, int length, int radius, int cn);
+
+	/**
+	 * @brief A row of a separable 16-bit filter pass: out = sum((rows[k] * weights[k]) >> 16).
+	 */
+	typedef void (*WeightedSum)(const uint16_t* const* rows, const uint16_t* weights, int taps, uint16_t* out, int length);
+
+	/**
+	 * @brief A row of both derivatives of GradientEngine: rows[k] points to pixel 0 of padded row k.
+	 */
+	typedef void (*DerivativeRow)(const uchar* const* rows, int* sumX, int* sumY, int cols, const int* weightsX, const int* weightsY, int radius);
+
+	// ThresholdingEngine: the fixed thresholds, and the running column sums of the adaptive threshold
+	void (*binaryRow)(const uchar* src, uchar* dst, int width, uchar t);
+	void (*toZeroRow)(const uchar* src, uchar* dst, int width, uchar t);
+	void (*truncateRow)(const uchar* src, uchar* dst, int width, uchar t);
+	void (*truncateColorRow)(const uchar* src, uchar* dst, int width, int limit, uchar value);
+	void (*binaryRow16)(const ushort* src, ushort* dst, int width, ushort t);
+	void (*toZeroRow16)(const ushort* src, ushort* dst, int width, ushort t);
+	void (*truncateRow16)(const ushort* src, ushort* dst, int width, ushort t);
+	void (*binaryRow32f)(const float* src, float* dst, int width, float t);
+	void (*toZeroRow32f)(const float* src, float* dst, int width, float t);
+	void (*truncateRow32f)(const float* src, float* dst, int width, float t);
+	void (*addColumns)(int* sums, const uchar* row, int width);
+	void (*subtractColumns)(int* sums, const uchar* row, int width);
+
+	// PointwiseChain and the histogram equalizations: dst[x] = table[src[x]]
+	void (*lookupRow)(const uchar* src, const uchar* table, uchar* dst, int cols);
+
+	// Convolution, specialized for the common radii, channel counts and tap counts
+	FilterRow (*filterRow)(int radius, int cn);
+	WeightedSum (*weightedSum)(int taps);
+
+	// Morphology: the element-wise minimum, maximum and saturated difference of two rows, for every depth
+	void (*minRow)(const uchar* a, const uchar* b, uchar* out, int length);
+	void (*maxRow)(const uchar* a, const uchar* b, uchar* out, int length);
+	void (*differenceRow)(const uchar* a, const uchar* b, uchar* out, int length);
+	void (*minRow16)(const ushort* a, const ushort* b, ushort* out, int length);
+	void (*maxRow16)(const ushort* a, const ushort* b, ushort* out, int length);
+	void (*differenceRow16)(const ushort* a, const ushort* b, ushort* out, int length);
+	void (*minRow32f)(const float* a, const float* b, float* out, int length);
+	void (*maxRow32f)(const float* a, const float* b, float* out, int length);
+	void (*differenceRow32f)(const float* a, const float* b, float* out, int length);
+
+	// HsvConverter
+	void (*bgrToHsvRow)(const uchar* in, uchar* out, int cols, int cn, const HsvConverter::Tables& t);
+	void (*hsvToBgrRow)(const uchar* in, uchar* out, int cols);
+	void (*valueRow)(const uchar* in, uchar* out, int cols, int cn, const HsvConverter::Tables& t);
+	void (*replaceValueRow)(const uchar* in, const uchar* value, uchar* out, int cols, int cn, const HsvConverter::Tables& t);
+	void (*remapValueRow)(const uchar* in, const uchar* maxToValue, uchar* out, int cols, int cn, const HsvConverter::Tables& t);
+
+	// GradientEngine, specialized for the common radii
+	DerivativeRow (*derivativeRow)(int radius);
+	void (*derivativeStore)(const int* sum, short* out, int cols, int shift);
+	void (*magnitudeRow)(const int* sumX, const int* sumY, uchar* out, int cols, int depth);
+	void (*directionRow)(const int* sumX, const int* sumY, uchar* out, int cols);
+
+	// ToneMap: out = min((src * scale) >> 16, 255)
+	void (*toneMapRow16)(const ushort* src, uchar* dst, int length, ushort scale);
+
+	// Clahe: the bilinear blend of the tables of the four tiles around every pixel
+	void (*claheRow)(const uchar* src, uchar* dst, int width, const float* top, const float* bottom,
+		const int* left, const int* right, const float* xWeights, float yWeight);
+
+	/**
+	 * @brief The level the kernels of the table were compiled for.
+	 */
+	CpuDispatch::Level level;
+
+	/**
+	 * @brief Gets the table of CpuDispatch::level(), chosen on the first call.
+	 */
+	static const Kernels& active();
+
+	/**
+	 * @brief Gets the table of the best variant compiled into the library that does not exceed a level.
+	 * @details The baseline is always compiled. The wider variants are left out when the library is built
+	 without IMAGEPROCESSINGUTILS_DISPATCH.
+	 * @param[in] level The level, which the CPU must support.
+	 */
+	static const Kernels& forLevel(CpuDispatch::Level level);
+};
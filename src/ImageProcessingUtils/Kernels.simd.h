@@ -0,0 +1,83 @@
+#pragma once
+
+// The body of every kernel variant. A variant translation unit defines IPU_SIMD_NAMESPACE and IPU_SIMD_LEVEL,
+// then includes this header with the compiler flags of its level.
+//
+// The variants are compiled from the same source, so anything they share with the rest of the library must not be
+// emitted by them: the linker keeps a single copy of an inline function, and it may be the AVX-512 one. The kernels
+// are therefore in an anonymous namespace, and they only call the intrinsics and their own helpers, never an inline
+// function of the standard library, of OpenCV or of an exported class.
+
+#include "Clahe.simd.h"
+#include "Convolution.simd.h"
+#include "Gradient.simd.h"
+#include "HsvConverter.simd.h"
+#include "Kernels.h"
+#include "Morphology.simd.h"
+#include "PointwiseChain.simd.h"
+#include "Thresholding.simd.h"
+#include "ToneMap.simd.h"
+
+namespace IPU_SIMD_NAMESPACE
+{
+	namespace
+	{
+		bool fill(Kernels& kernels)
+		{
+			kernels.binaryRow = binaryRow;
+			kernels.toZeroRow = toZeroRow;
+			kernels.truncateRow = truncateRow;
+			kernels.truncateColorRow = truncateColorRow;
+			kernels.binaryRow16 = binaryRow16;
+			kernels.toZeroRow16 = toZeroRow16;
+			kernels.truncateRow16 = truncateRow16;
+			kernels.binaryRow32f = binaryRow32f;
+			kernels.toZeroRow32f = toZeroRow32f;
+			kernels.truncateRow32f = truncateRow32f;
+			kernels.addColumns = accumulateColumns<1>;
+			kernels.subtractColumns = accumulateColumns<-1>;
+
+			kernels.lookupRow = lookupRow;
+
+			kernels.filterRow = selectFilterRow;
+			kernels.weightedSum = selectWeightedSum;
+
+			kernels.minRow = extremumRow<false>;
+			kernels.maxRow = extremumRow<true>;
+			kernels.differenceRow = differenceRow;
+			kernels.minRow16 = extremumRow16<false>;
+			kernels.maxRow16 = extremumRow16<true>;
+			kernels.differenceRow16 = differenceRow16;
+			kernels.minRow32f = extremumRow32f<false>;
+			kernels.maxRow32f = extremumRow32f<true>;
+			kernels.differenceRow32f = differenceRow32f;
+
+			kernels.bgrToHsvRow = bgrToHsvRow;
+			kernels.hsvToBgrRow = hsvToBgrRow;
+			kernels.valueRow = valueRow;
+			kernels.replaceValueRow = replaceValueRow;
+			kernels.remapValueRow = remapValueRow;
+
+			kernels.derivativeRow = selectDerivativeRow;
+			kernels.derivativeStore = derivativeStore;
+			kernels.magnitudeRow = magnitudeRow;
+			kernels.directionRow = directionRow;
+
+			kernels.toneMapRow16 = toneMapRow16;
+			kernels.claheRow = claheRow;
+
+			kernels.level = IPU_SIMD_LEVEL;
+			return true;
+		}
+	}
+
+	// The table is filled member by member rather than copied, since a copy would go through the implicit
+	// copy constructor of the exported class.
+	const Kernels& table()
+	{
+		static Kernels kernels;
+		static const bool filled = fill(kernels);
+		(void)filled;
+		return kernels;
+	}
+}
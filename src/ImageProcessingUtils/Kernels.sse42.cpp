@@ -0,0 +1,4 @@
+// The SSE4.2 variant of the kernels, compiled with the flags of its level (see CMakeLists.txt)
+#define IPU_SIMD_NAMESPACE kernels_sse42
+#define IPU_SIMD_LEVEL CpuDispatch::Sse42
+#include "Kernels.simd.h"
@@ -0,0 +1,158 @@
+#include "ModelImage.h"
+#include "HsvConverter.h"
+#include "PixelDepth.h"
+
+#include <opencv2/imgproc.hpp>
+
+namespace
+{
+	ModelImage::Model modelOf(const cv::Mat& mat)
+	{
+		CV_Assert(PixelDepth::supported(mat.depth()));
+
+		switch (mat.channels())
+		{
+		case 1:
+			return ModelImage::Gray;
+		case 3:
+			return ModelImage::Bgr;
+		case 4:
+			return ModelImage::Bgra;
+		default:
+			CV_Error(cv::Error::StsBadArg, "unsupported number of channels");
+		}
+	}
+
+	// the cvtColor code between two of Gray, Bgr and Bgra
+	int conversionCode(ModelImage::Model from, ModelImage::Model to)
+	{
+		switch (from)
+		{
+		case ModelImage::Gray:
+			return to == ModelImage::Bgr ? cv::COLOR_GRAY2BGR : cv::COLOR_GRAY2BGRA;
+		case ModelImage::Bgr:
+			return to == ModelImage::Gray ? cv::COLOR_BGR2GRAY : cv::COLOR_BGR2BGRA;
+		default:
+			return to == ModelImage::Gray ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGRA2BGR;
+		}
+	}
+}
+
+ModelImage::ModelImage(const cv::Mat& mat)
+	: data(mat), current(modelOf(mat))
+{
+}
+
+ModelImage::ModelImage(const cv::Mat& mat, Model model)
+	: data(mat), current(model)
+{
+	CV_Assert(PixelDepth::supported(mat.depth()) && mat.channels() == channels(model));
+	CV_Assert(model != Hsv || mat.depth() == CV_8U);
+}
+
+ModelImage::Model ModelImage::model() const
+{
+	return current;
+}
+
+const cv::Mat& ModelImage::mat() const
+{
+	return data;
+}
+
+cv::Mat& ModelImage::accept(Models accepted)
+{
+	convertTo(choose(current, accepted));
+	return data;
+}
+
+void ModelImage::convertTo(Model target)
+{
+	if (target == current)
+		return;
+
+	if (buffers != nullptr)
+	{
+		cv::Mat& buffer = (*buffers)[slot(target)];
+		convert(data, current, buffer, target);
+		data = buffer;
+	}
+	else
+		convert(data, current, data, target);
+
+	current = target;
+}
+
+void ModelImage::useBuffers(Buffers* buffers)
+{
+	this->buffers = buffers;
+}
+
+ModelImage::Model ModelImage::choose(Model current, Models accepted)
+{
+	CV_Assert((accepted & (Gray | Bgr | Bgra | Hsv)) != 0);
+
+	if (current & accepted)
+		return current;
+
+	for (Model target : { Bgr, Bgra, Gray, Hsv })
+		if (accepted & target)
+			return target;
+
+	return current;
+}
+
+int ModelImage::slot(Model model)
+{
+	switch (model)
+	{
+	case Gray:
+		return 0;
+	case Bgr:
+		return 1;
+	case Bgra:
+		return 2;
+	default:
+		return 3;
+	}
+}
+
+int ModelImage::channels(Model model)
+{
+	switch (model)
+	{
+	case Gray:
+		return 1;
+	case Bgra:
+		return 4;
+	default:
+		return 3;
+	}
+}
+
+void ModelImage::convert(const cv::Mat& src, Model from, cv::Mat& dst, Model to)
+{
+	if (from == to)
+	{
+		dst = src;
+		return;
+	}
+
+	if (from == Hsv)
+	{
+		cv::Mat bgr;
+		HsvConverter::hsvToBgr(src, bgr);
+		convert(bgr, Bgr, dst, to);
+	}
+	else if (to == Hsv)
+	{
+		cv::Mat bgr = src, hsv;
+		if (from == Gray)
+			cv::cvtColor(src, bgr, cv::COLOR_GRAY2BGR);
+
+		HsvConverter::bgrToHsv(bgr, hsv);
+		dst = hsv;
+	}
+	else
+		cv::cvtColor(src, dst, conversionCode(from, to));
+}
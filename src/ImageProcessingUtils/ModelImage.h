@@ -0,0 +1,125 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <array>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief An image that knows its colour model.
+ * @details The stages of ProcessingAlgorithms::applyingAlgorithms() declare the models they accept through accept(),
+ which converts the image only when its current model is not one of them, and write their result in the model they were given.
+ A chain of grayscale stages therefore converts a colour frame to grayscale once, keeps working on a single channel
+ and is converted back to colour once, when the result is displayed.
+ Gray, Bgr and Bgra images may be 8-bit, 16-bit or float, and conversions between them keep the depth.
+ The HSV layout only exists in 8 bits.
+ */
+class IMAGEPROCESSINGUTILS_API ModelImage
+{
+public:
+	/**
+	 * @brief The colour models. They are bit flags, so that a stage can accept several of them.
+	 */
+	enum Model
+	{
+		Gray = 1,
+		Bgr = 2,
+		Bgra = 4,
+		Hsv = 8	// the layout of HsvConverter: H in [0, 180), S and V in [0, 255]
+	};
+
+	/**
+	 * @brief A set of models, as a combination of Model flags.
+	 */
+	typedef int Models;
+
+	/**
+	 * @brief One image buffer per model, indexed by slot(), that conversions write into instead of allocating.
+	 */
+	typedef std::array<cv::Mat, 4> Buffers;
+
+	/**
+	 * @brief Wraps an image, taking its model from its number of channels: Gray, Bgr or Bgra.
+	 * @param[in] mat The 1, 3 or 4 channel CV_8U, CV_16U or CV_32F image. Its data is shared, not copied.
+	 */
+	explicit ModelImage(const cv::Mat& mat);
+
+	/**
+	 * @brief Wraps an image in the given model.
+	 * @param[in] mat The image, with as many channels as the model has, and 8 bits for Hsv. Its data is shared, not copied.
+	 * @param[in] model The model of the image.
+	 */
+	ModelImage(const cv::Mat& mat, Model model);
+
+	/**
+	 * @brief Gets the current model of the image.
+	 */
+	Model model() const;
+
+	/**
+	 * @brief Gets the image data, in the current model.
+	 */
+	const cv::Mat& mat() const;
+
+	/**
+	 * @brief Brings the image into one of the models a stage accepts.
+	 * @details Nothing is converted when the image already is in one of them. Otherwise it is converted to the first
+	 of Bgr, Bgra, Gray and Hsv that is accepted, which loses the least of the image.
+	 * @param[in] accepted The models the stage accepts.
+	 * @return The image data, which the stage may replace in place with a result in the same model.
+	 */
+	cv::Mat& accept(Models accepted);
+
+	/**
+	 * @brief Converts the image to a model.
+	 * @details With buffers, the result is written into the buffer of the target model,
+	 which is only reallocated when it does not already have the size and type of the result.
+	 * @param[in] target The model.
+	 */
+	void convertTo(Model target);
+
+	/**
+	 * @brief Makes the conversions write into planned buffers.
+	 * @details The buffers must outlive the conversions, and the buffer of a model must not be in use
+	 when the image is converted to that model.
+	 * @param[in] buffers The buffers, or nullptr to allocate a new image for every conversion.
+	 */
+	void useBuffers(Buffers* buffers);
+
+	/**
+	 * @brief Gets the model accept() converts an image to.
+	 * @param[in] current The current model of the image.
+	 * @param[in] accepted The models the stage accepts.
+	 * @return current if it is accepted, otherwise the first of Bgr, Bgra, Gray and Hsv that is.
+	 */
+	static Model choose(Model current, Models accepted);
+
+	/**
+	 * @brief Gets the index of a model in Buffers.
+	 */
+	static int slot(Model model);
+
+	/**
+	 * @brief Gets the number of channels of a model.
+	 */
+	static int channels(Model model);
+
+	/**
+	 * @brief Converts an image between two models.
+	 * @details Conversions between Hsv and the other models go through Bgr.
+	 * @param[in] src The source image.
+	 * @param[in] from The model of the source image.
+	 * @param[out] dst The converted image. It may be the source image.
+	 * @param[in] to The model of the converted image.
+	 */
+	static void convert(const cv::Mat& src, Model from, cv::Mat& dst, Model to);
+
+private:
+	cv::Mat data;
+	Model current;
+	Buffers* buffers = nullptr;
+};
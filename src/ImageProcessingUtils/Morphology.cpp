@@ -0,0 +1,351 @@
+#include "Morphology.h"
+#include "Kernels.h"
+#include "PixelDepth.h"
+#include "RowBands.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+	// width, in bytes, of the column strips the vertical pass works on
+	const int STRIP = 256;
+
+	template<typename T>
+	using RowKernel = void (*)(const T* a, const T* b, T* out, int length);
+
+	// the row kernels of every depth
+	RowKernel<uchar> extremumKernel(bool max, uchar)
+	{
+		return max ? Kernels::active().maxRow : Kernels::active().minRow;
+	}
+
+	RowKernel<ushort> extremumKernel(bool max, ushort)
+	{
+		return max ? Kernels::active().maxRow16 : Kernels::active().minRow16;
+	}
+
+	RowKernel<float> extremumKernel(bool max, float)
+	{
+		return max ? Kernels::active().maxRow32f : Kernels::active().minRow32f;
+	}
+
+	RowKernel<uchar> differenceKernel(uchar)
+	{
+		return Kernels::active().differenceRow;
+	}
+
+	RowKernel<ushort> differenceKernel(ushort)
+	{
+		return Kernels::active().differenceRow16;
+	}
+
+	RowKernel<float> differenceKernel(float)
+	{
+		return Kernels::active().differenceRow32f;
+	}
+
+	// the value that never wins: the padding of the lines
+	template<bool Max, typename T>
+	T identity()
+	{
+		return Max ? std::numeric_limits<T>::lowest() : std::numeric_limits<T>::max();
+	}
+
+	template<bool Max, typename T>
+	inline typename std::enable_if<std::is_arithmetic<T>::value, T>::type extremum(T a, T b)
+	{
+		return Max ? (a > b ? a : b) : (a < b ? a : b);
+	}
+
+#ifdef IPU_SSE2
+	template<bool Max>
+	inline __m128i extremum(__m128i a, __m128i b)
+	{
+		return Max ? _mm_max_epu8(a, b) : _mm_min_epu8(a, b);
+	}
+
+	// Transposes a 16 x 16 byte tile: out[k] receives byte k of every in[r], in the order of r.
+	// Four perfect shuffles of the sixteen registers move every byte to its transposed place.
+	inline void transpose16(const __m128i* in, __m128i* out)
+	{
+		__m128i a[16], b[16];
+		std::copy(in, in + 16, a);
+
+		for (int stage = 0; stage < 4; stage++)
+		{
+			for (int i = 0; i < 8; i++)
+			{
+				b[2 * i] = _mm_unpacklo_epi8(a[i], a[i + 8]);
+				b[2 * i + 1] = _mm_unpackhi_epi8(a[i], a[i + 8]);
+			}
+			std::copy(b, b + 16, a);
+		}
+
+		std::copy(a, a + 16, out);
+	}
+#endif
+
+	template<typename T>
+	void difference(const cv::Mat& a, const cv::Mat& b, cv::Mat& dst)
+	{
+		dst.create(a.size(), a.type());
+		const int length = a.cols * a.channels();
+
+		RowBands::Traits traits;
+		traits.rowBytes = 3 * length * sizeof(T);
+		const RowKernel<T> subtract = differenceKernel(T());
+
+		RowBands::run(a.rows, traits, [&](const cv::Range& range) {
+			for (int y = range.start; y < range.end; y++)
+				subtract(a.ptr<T>(y), b.ptr<T>(y), dst.ptr<T>(y), length);
+			});
+	}
+
+	// The window of output i covers the padded positions [i, i + window - 1]: `before` identity values go before the line
+	// and the padding after it completes the last block.
+	int paddedBlocks(int length, int window)
+	{
+		return (length + 2 * window - 2) / window;
+	}
+
+	// Scans the padded lines of one row, or of sixteen rows transposed into one register per position, block by block.
+	// backward[i] then holds the extremum from i to the end of its block and forward[i] the one from the start of its block to i.
+	template<bool Max, typename Lane>
+	void scanBlocks(const Lane* line, Lane* forward, Lane* backward, int blocks, int block, int cn)
+	{
+		for (int b = 0; b < blocks; b++)
+		{
+			const int start = b * block;
+			const int end = start + block;
+
+			for (int i = start; i < start + cn; i++)
+				forward[i] = line[i];
+			for (int i = start + cn; i < end; i++)
+				forward[i] = extremum<Max>(forward[i - cn], line[i]);
+
+			for (int i = end - cn; i < end; i++)
+				backward[i] = line[i];
+			for (int i = end - cn - 1; i >= start; i--)
+				backward[i] = extremum<Max>(backward[i + cn], line[i]);
+		}
+	}
+
+	// Every row is copied to a padded line before its result is written, so src and dst may be the same image.
+	// The scans are serial along a row, so with SSE2 sixteen 8-bit rows are transposed and scanned together, one row per byte lane.
+	// Deeper rows are scanned one at a time.
+	template<bool Max, typename T>
+	void horizontalPass(const cv::Mat& src, cv::Mat& dst, int window, int before)
+	{
+		const int cn = src.channels();
+		const int width = src.cols * cn;
+		const int offset = before * cn;
+		const int block = window * cn;
+		const int blocks = paddedBlocks(src.cols, window);
+		const int length = blocks * block;
+		const T padding = identity<Max, T>();
+
+		RowBands::Traits traits;
+		traits.rowBytes = (2 * width + 3 * length) * sizeof(T);
+		traits.granularity = 16;
+		const RowKernel<T> combine = extremumKernel(Max, T());
+
+		RowBands::run(src.rows, traits, [&](const cv::Range& range) {
+			int y = range.start;
+#ifdef IPU_SSE2
+			if (std::is_same<T, uchar>::value && range.end - y >= 16)
+			{
+				const __m128i fill = _mm_set1_epi8(static_cast<char>(identity<Max, uchar>()));
+				std::vector<__m128i> lines(length, fill), forward(length), backward(length);
+				const uchar* in[16];
+				uchar* out[16];
+
+				for (; y <= range.end - 16; y += 16)
+				{
+					for (int r = 0; r < 16; r++)
+					{
+						in[r] = src.ptr<uchar>(y + r);
+						out[r] = dst.ptr<uchar>(y + r);
+					}
+
+					int i = 0;
+					for (; i <= width - 16; i += 16)
+					{
+						__m128i tile[16];
+						for (int r = 0; r < 16; r++)
+							tile[r] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in[r] + i));
+						transpose16(tile, &lines[offset + i]);
+					}
+					for (; i < width; i++)
+					{
+						alignas(16) uchar column[16];
+						for (int r = 0; r < 16; r++)
+							column[r] = in[r][i];
+						lines[offset + i] = _mm_load_si128(reinterpret_cast<const __m128i*>(column));
+					}
+
+					scanBlocks<Max>(lines.data(), forward.data(), backward.data(), blocks, block, cn);
+
+					// the lines are scanned already: they receive the results
+					for (i = 0; i < width; i++)
+						lines[i] = extremum<Max>(backward[i], forward[i + block - cn]);
+
+					for (i = 0; i <= width - 16; i += 16)
+					{
+						__m128i tile[16];
+						transpose16(&lines[i], tile);
+						for (int r = 0; r < 16; r++)
+							_mm_storeu_si128(reinterpret_cast<__m128i*>(out[r] + i), tile[r]);
+					}
+					for (; i < width; i++)
+					{
+						alignas(16) uchar column[16];
+						_mm_store_si128(reinterpret_cast<__m128i*>(column), lines[i]);
+						for (int r = 0; r < 16; r++)
+							out[r][i] = column[r];
+					}
+
+					// restore the padding the results overwrote
+					std::fill(lines.begin(), lines.begin() + offset, fill);
+				}
+			}
+#endif
+			std::vector<T> line(length, padding), forward(length), backward(length);
+
+			for (; y < range.end; y++)
+			{
+				std::memcpy(line.data() + offset, src.ptr<T>(y), width * sizeof(T));
+				scanBlocks<Max>(line.data(), forward.data(), backward.data(), blocks, block, cn);
+				combine(backward.data(), forward.data() + block - cn, dst.ptr<T>(y), width);
+			}
+			});
+	}
+
+	// The blocks of a band start at its first row, so the band reads `before` rows above it and window - 1 - before below.
+	// Inside a band the columns are taken in strips, so that the block scans stay in cache however wide the image is.
+	template<bool Max, typename T>
+	void verticalPass(const cv::Mat& src, cv::Mat& dst, int window, int before)
+	{
+		const int rows = src.rows;
+		const int width = src.cols * src.channels();
+		// the strips keep their width in bytes, so they hold fewer deep pixels
+		const int strip = STRIP / static_cast<int>(sizeof(T));
+
+		RowBands::Traits traits;
+		traits.halo = std::max(before, window - 1 - before);
+		traits.rowBytes = 3 * STRIP;
+		const RowKernel<T> combine = extremumKernel(Max, T());
+
+		const cv::Mat input = RowBands::source(src, dst, traits);
+
+		RowBands::run(rows, traits, [&](const cv::Range& range) {
+			const int height = range.end - range.start;
+			const int blocks = paddedBlocks(height, window);
+			const std::vector<T> padding(strip, identity<Max, T>());
+			std::vector<T> forward(blocks * window * strip), backward(blocks * window * strip);
+
+			for (int x0 = 0; x0 < width; x0 += strip)
+			{
+				const int w = std::min(strip, width - x0);
+
+				auto line = [&](int i) {
+					const int y = range.start + i - before;
+					return y >= 0 && y < rows ? input.ptr<T>(y) + x0 : padding.data();
+				};
+
+				for (int b = 0; b < blocks; b++)
+				{
+					const int start = b * window;
+					const int end = start + window;
+
+					std::memcpy(&forward[start * strip], line(start), w * sizeof(T));
+					for (int i = start + 1; i < end; i++)
+						combine(&forward[(i - 1) * strip], line(i), &forward[i * strip], w);
+
+					std::memcpy(&backward[(end - 1) * strip], line(end - 1), w * sizeof(T));
+					for (int i = end - 2; i >= start; i--)
+						combine(&backward[(i + 1) * strip], line(i), &backward[i * strip], w);
+				}
+
+				for (int y = 0; y < height; y++)
+					combine(&backward[y * strip], &forward[(y + window - 1) * strip], dst.ptr<T>(range.start + y) + x0, w);
+			}
+			});
+	}
+
+	// The structuring element is centered on every pixel. For an even size the center is ambiguous:
+	// the reflected element is used by the second operation of an opening or a closing,
+	// so that the opening never exceeds the source and the closing never falls below it.
+	template<bool Max, typename T>
+	void morph(const cv::Mat& src, cv::Mat& dst, cv::Size kernel, bool reflected = false)
+	{
+		const cv::Mat source = src;
+		const int beforeX = reflected ? (kernel.width - 1) / 2 : kernel.width / 2;
+		const int beforeY = reflected ? (kernel.height - 1) / 2 : kernel.height / 2;
+
+		if (kernel.height == 1)
+		{
+			dst.create(source.size(), source.type());
+			if (kernel.width > 1)
+				horizontalPass<Max, T>(source, dst, kernel.width, beforeX);
+			else if (dst.data != source.data)
+				source.copyTo(dst);
+			return;
+		}
+
+		// the vertical pass reads the rows around the one it writes, so the horizontal result gets its own buffer
+		cv::Mat horizontal = source;
+		if (kernel.width > 1)
+		{
+			horizontal = cv::Mat(source.size(), source.type());
+			horizontalPass<Max, T>(source, horizontal, kernel.width, beforeX);
+		}
+
+		dst.create(source.size(), source.type());
+		verticalPass<Max, T>(horizontal, dst, kernel.height, beforeY);
+	}
+}
+
+void Morphology::apply(const cv::Mat& src, cv::Mat& dst, Operation operation, cv::Size kernel)
+{
+	CV_Assert(PixelDepth::supported(src.depth()) && kernel.width >= 1 && kernel.height >= 1);
+
+	const cv::Mat source = src;
+	cv::Mat other;
+
+	PixelDepth::dispatch(source.depth(), [&](auto pixel) {
+		typedef decltype(pixel) T;
+
+		switch (operation)
+		{
+		case Erode:
+			morph<false, T>(source, dst, kernel);
+			break;
+		case Dilate:
+			morph<true, T>(source, dst, kernel);
+			break;
+		case Open:
+			morph<false, T>(source, dst, kernel);
+			morph<true, T>(dst, dst, kernel, true);
+			break;
+		case Close:
+			morph<true, T>(source, dst, kernel);
+			morph<false, T>(dst, dst, kernel, true);
+			break;
+		case Gradient:
+			morph<false, T>(source, other, kernel);
+			morph<true, T>(source, dst, kernel);
+			difference<T>(dst, other, dst);
+			break;
+		case TopHat:
+			morph<false, T>(source, other, kernel);
+			morph<true, T>(other, other, kernel, true);
+			difference<T>(source, other, dst);
+			break;
+		}
+		});
+}
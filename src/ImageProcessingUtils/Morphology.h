@@ -0,0 +1,48 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief Grayscale morphology with rectangular structuring elements.
+ * @details Erosion and dilation are separable for a rectangle, so they run as a horizontal pass followed by a vertical pass.
+ Each pass uses the van Herk/Gil-Werman algorithm: the line is cut into blocks of the window length,
+ a running minimum (or maximum) is taken forward and backward inside every block, and every window is then
+ the combination of one backward and one forward value. That is three min/max per pixel whatever the kernel size.
+ The vertical pass works on whole rows with SSE2/AVX2 min/max, for 8-bit, 16-bit and float pixels alike. The horizontal scans are serial
+ along a row, so sixteen 8-bit rows are transposed into byte lanes and scanned together; deeper rows are scanned one by one.
+ Pixels outside the image never win the minimum or maximum.
+ */
+class IMAGEPROCESSINGUTILS_API Morphology
+{
+public:
+	enum Operation
+	{
+		Erode,
+		Dilate,
+		// dilation of the erosion
+		Open,
+		// erosion of the dilation
+		Close,
+		// dilation minus erosion
+		Gradient,
+		// source minus its opening
+		TopHat
+	};
+
+	/**
+	 * @brief Applies a morphological operation with a rectangular structuring element centered on every pixel.
+	 * @details Every operation costs at most two erosions or dilations plus, for Gradient and TopHat, a subtraction clamped at 0.
+	 Multi-channel images are processed channel by channel.
+	 * @param[in] src The CV_8U, CV_16U or CV_32F source image, with any number of channels.
+	 * @param[out] dst The destination image, of the same type as src. It may be the source image.
+	 * @param[in] operation The operation to apply.
+	 * @param[in] kernel The width and height of the structuring element.
+	 */
+	static void apply(const cv::Mat& src, cv::Mat& dst, Operation operation, cv::Size kernel);
+};
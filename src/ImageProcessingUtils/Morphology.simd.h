@@ -0,0 +1,181 @@
+#pragma once
+
+// The row kernels of Morphology, compiled once per CpuDispatch level through Kernels.simd.h.
+
+#include "Simd.h"
+
+#include <opencv2/core.hpp>
+
+namespace IPU_SIMD_NAMESPACE
+{
+	namespace
+	{
+		// out = max(a, b) (Max) or min(a, b), byte by byte
+		template<bool Max>
+		void extremumRow(const uchar* a, const uchar* b, uchar* out, int length)
+		{
+			int i = 0;
+#ifdef IPU_AVX512
+			for (; i <= length - 64; i += 64)
+			{
+				__m512i va = _mm512_loadu_si512(a + i);
+				__m512i vb = _mm512_loadu_si512(b + i);
+				_mm512_storeu_si512(out + i, Max ? _mm512_max_epu8(va, vb) : _mm512_min_epu8(va, vb));
+			}
+#endif
+#ifdef IPU_AVX2
+			for (; i <= length - 32; i += 32)
+			{
+				__m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+				__m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), Max ? _mm256_max_epu8(va, vb) : _mm256_min_epu8(va, vb));
+			}
+#endif
+#ifdef IPU_SSE2
+			for (; i <= length - 16; i += 16)
+			{
+				__m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+				__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), Max ? _mm_max_epu8(va, vb) : _mm_min_epu8(va, vb));
+			}
+#endif
+			for (; i < length; i++)
+				out[i] = (a[i] > b[i]) == Max ? a[i] : b[i];
+		}
+
+		// out = max(a - b, 0), byte by byte
+		void differenceRow(const uchar* a, const uchar* b, uchar* out, int length)
+		{
+			int i = 0;
+#ifdef IPU_AVX512
+			for (; i <= length - 64; i += 64)
+				_mm512_storeu_si512(out + i, _mm512_subs_epu8(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i)));
+#endif
+#ifdef IPU_AVX2
+			for (; i <= length - 32; i += 32)
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_subs_epu8(
+					_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i))));
+#endif
+#ifdef IPU_SSE2
+			for (; i <= length - 16; i += 16)
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_subs_epu8(
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i))));
+#endif
+			for (; i < length; i++)
+				out[i] = a[i] > b[i] ? static_cast<uchar>(a[i] - b[i]) : 0;
+		}
+
+		// The 16-bit minimum and maximum. SSE2 has neither, but it saturates: with d = a - b saturated to 0,
+		// min(a, b) = a - d and max(a, b) = b + d.
+		template<bool Max>
+		void extremumRow16(const ushort* a, const ushort* b, ushort* out, int length)
+		{
+			int i = 0;
+#ifdef IPU_AVX512
+			for (; i <= length - 32; i += 32)
+			{
+				__m512i va = _mm512_loadu_si512(a + i);
+				__m512i vb = _mm512_loadu_si512(b + i);
+				_mm512_storeu_si512(out + i, Max ? _mm512_max_epu16(va, vb) : _mm512_min_epu16(va, vb));
+			}
+#endif
+#ifdef IPU_AVX2
+			for (; i <= length - 16; i += 16)
+			{
+				__m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+				__m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), Max ? _mm256_max_epu16(va, vb) : _mm256_min_epu16(va, vb));
+			}
+#endif
+#ifdef IPU_SSE2
+			for (; i <= length - 8; i += 8)
+			{
+				__m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+				__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+				__m128i d = _mm_subs_epu16(va, vb);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), Max ? _mm_add_epi16(vb, d) : _mm_sub_epi16(va, d));
+			}
+#endif
+			for (; i < length; i++)
+				out[i] = (a[i] > b[i]) == Max ? a[i] : b[i];
+		}
+
+		// min_ps and max_ps return their second operand when either is NaN, and so does the scalar tail
+		template<bool Max>
+		void extremumRow32f(const float* a, const float* b, float* out, int length)
+		{
+			int i = 0;
+#ifdef IPU_AVX512
+			for (; i <= length - 16; i += 16)
+			{
+				__m512 va = _mm512_loadu_ps(a + i);
+				__m512 vb = _mm512_loadu_ps(b + i);
+				_mm512_storeu_ps(out + i, Max ? _mm512_max_ps(va, vb) : _mm512_min_ps(va, vb));
+			}
+#endif
+#ifdef IPU_AVX2
+			for (; i <= length - 8; i += 8)
+			{
+				__m256 va = _mm256_loadu_ps(a + i);
+				__m256 vb = _mm256_loadu_ps(b + i);
+				_mm256_storeu_ps(out + i, Max ? _mm256_max_ps(va, vb) : _mm256_min_ps(va, vb));
+			}
+#endif
+#ifdef IPU_SSE2
+			for (; i <= length - 4; i += 4)
+			{
+				__m128 va = _mm_loadu_ps(a + i);
+				__m128 vb = _mm_loadu_ps(b + i);
+				_mm_storeu_ps(out + i, Max ? _mm_max_ps(va, vb) : _mm_min_ps(va, vb));
+			}
+#endif
+			for (; i < length; i++)
+				out[i] = Max ? (a[i] > b[i] ? a[i] : b[i]) : (a[i] < b[i] ? a[i] : b[i]);
+		}
+
+		// out = max(a - b, 0), 16 bits at a time
+		void differenceRow16(const ushort* a, const ushort* b, ushort* out, int length)
+		{
+			int i = 0;
+#ifdef IPU_AVX512
+			for (; i <= length - 32; i += 32)
+				_mm512_storeu_si512(out + i, _mm512_subs_epu16(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i)));
+#endif
+#ifdef IPU_AVX2
+			for (; i <= length - 16; i += 16)
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_subs_epu16(
+					_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i))));
+#endif
+#ifdef IPU_SSE2
+			for (; i <= length - 8; i += 8)
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_subs_epu16(
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i))));
+#endif
+			for (; i < length; i++)
+				out[i] = a[i] > b[i] ? static_cast<ushort>(a[i] - b[i]) : 0;
+		}
+
+		// out = max(a - b, 0) on floats
+		void differenceRow32f(const float* a, const float* b, float* out, int length)
+		{
+			int i = 0;
+#ifdef IPU_AVX512
+			for (; i <= length - 16; i += 16)
+				_mm512_storeu_ps(out + i, _mm512_max_ps(_mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i)), _mm512_setzero_ps()));
+#endif
+#ifdef IPU_AVX2
+			for (; i <= length - 8; i += 8)
+				_mm256_storeu_ps(out + i, _mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)), _mm256_setzero_ps()));
+#endif
+#ifdef IPU_SSE2
+			for (; i <= length - 4; i += 4)
+				_mm_storeu_ps(out + i, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)), _mm_setzero_ps()));
+#endif
+			for (; i < length; i++)
+			{
+				const float d = a[i] - b[i];
+				out[i] = d > 0.0f ? d : 0.0f;
+			}
+		}
+	}
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "CacheLine.h"
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief A bounded lock-free queue between any number of producer and consumer threads.
+ * @details Every cell carries a sequence number that tells whether it is ready to be filled or emptied in the current lap
+ around the queue. A producer claims the next cell with a compare-and-swap on the enqueue position, fills it and publishes it
+ through its sequence; a consumer does the same on the dequeue position. A thread thus never waits for another one to
+ release a lock, only retries when another thread claimed the same cell first.
+ The two positions and every cell are on cache lines of their own, so the producers, the consumers and the threads working
+ on neighbouring cells do not invalidate each other's lines. popBatch() claims several cells with one compare-and-swap,
+ which spreads the cost of the contention on the dequeue position over the batch.
+ The items are moved in and out, so a SharedFrame or a std::shared_ptr travels as a handle and its pixels are never copied.
+ */
+template<typename T>
+class MpmcQueue
+{
+public:
+	/**
+	 * @brief Creates an empty queue.
+	 * @param[in] capacity The number of cells, at least 2, rounded up to a power of two.
+	 */
+	explicit MpmcQueue(size_t capacity)
+	{
+		CV_Assert(capacity >= 2);
+
+		size_t size = 2;
+		while (size < capacity)
+			size <<= 1;
+		cells.reset(new Cell[size]);
+		mask = size - 1;
+		for (size_t i = 0; i < size; i++)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	MpmcQueue(const MpmcQueue&) = delete;
+	MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+	/**
+	 * @brief Appends an item.
+	 * @return Returns false if the queue is full, in which case the item is not moved from.
+	 */
+	bool tryPush(T&& item)
+	{
+		size_t position = enqueuePosition.load(std::memory_order_relaxed);
+		Cell* cell;
+		for (;;)
+		{
+			cell = &cells[position & mask];
+			const intptr_t lap = static_cast<intptr_t>(cell->sequence.load(std::memory_order_acquire)) - static_cast<intptr_t>(position);
+			if (lap == 0)
+			{
+				if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					break;
+			}
+			// the cell still holds the item of the previous lap
+			else if (lap < 0)
+				return false;
+			else
+				position = enqueuePosition.load(std::memory_order_relaxed);
+		}
+
+		cell->value = std::move(item);
+		cell->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief Removes the oldest item.
+	 * @return Returns false if the queue is empty.
+	 */
+	bool tryPop(T& item)
+	{
+		return popBatch(&item, 1) == 1;
+	}
+
+	/**
+	 * @brief Removes up to count of the oldest items at once.
+	 * @param[out] out Where the items are moved to, in order, like a pointer or a std::back_insert_iterator.
+	 * @param[in] count The largest number of items to remove.
+	 * @return The number of items removed, 0 if the queue is empty.
+	 */
+	template<typename OutputIt>
+	size_t popBatch(OutputIt out, size_t count)
+	{
+		size_t position = dequeuePosition.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			// the cells that follow each other from the position and are filled
+			size_t ready = 0;
+			intptr_t lap = 0;
+			while (ready < count)
+			{
+				const size_t sequence = cells[(position + ready) & mask].sequence.load(std::memory_order_acquire);
+				lap = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + ready + 1);
+				if (lap != 0)
+					break;
+				ready++;
+			}
+
+			if (ready == 0)
+			{
+				// the first cell is not filled yet
+				if (lap < 0)
+					return 0;
+				position = dequeuePosition.load(std::memory_order_relaxed);
+				continue;
+			}
+
+			// once claimed, the cells stay filled: no other consumer can claim them and no producer can fill them again
+			if (dequeuePosition.compare_exchange_weak(position, position + ready, std::memory_order_relaxed))
+			{
+				for (size_t i = 0; i < ready; i++)
+				{
+					Cell& cell = cells[(position + i) & mask];
+					*out = std::move(cell.value);
+					++out;
+					cell.sequence.store(position + i + mask + 1, std::memory_order_release);
+				}
+				return ready;
+			}
+		}
+	}
+
+	/**
+	 * @brief Gets the number of cells.
+	 */
+	size_t capacity() const
+	{
+		return mask + 1;
+	}
+
+private:
+	struct alignas(CACHE_LINE_SIZE) Cell
+	{
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	std::unique_ptr<Cell[]> cells;
+	size_t mask = 0;
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueuePosition{ 0 };
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeuePosition{ 0 };
+};
@@ -58,6 +58,42 @@ void OptionsHistory::add(revertable_options prop, short value) {
 	case OPENING:
 		currentStatus.setOpening(value);
 		break;
+	case ADAPTIVE_BLOCK_SIZE:
+		currentStatus.setAdaptiveBlockSize(value);
+		break;
+	case ADAPTIVE_C:
+		currentStatus.setAdaptiveC(value);
+		break;
+	case CLAHE:
+		currentStatus.setClahe(value);
+		break;
+	case CLAHE_TILES:
+		currentStatus.setClaheTiles(value);
+		break;
+	case CLAHE_CLIP_LIMIT:
+		currentStatus.setClaheClipLimit(value);
+		break;
+	case AUTO_THRESHOLDING:
+		currentStatus.setAutoThresholding(value);
+		break;
+	case AUTO_THRESHOLD_METHOD:
+		currentStatus.setAutoThresholdMethod(value);
+		break;
+	case AUTO_THRESHOLD_PERCENTILE:
+		currentStatus.setAutoThresholdPercentile(value);
+		break;
+	case AUTO_THRESHOLD_SMOOTHING:
+		currentStatus.setAutoThresholdSmoothing(value);
+		break;
+	case EQUALIZATION_STRIDE:
+		currentStatus.setEqualizationStride(value);
+		break;
+	case EQUALIZATION_DRIFT:
+		currentStatus.setEqualizationDrift(value);
+		break;
+	case DETECTION_INTERVAL:
+		currentStatus.setDetectionInterval(value);
+		break;
 	default:
 		return;
 	}
@@ -138,6 +174,30 @@ std::string OptionsHistory::lastChange() {
 		return "canny";
 	case OPENING:
 		return "opening";
+	case ADAPTIVE_BLOCK_SIZE:
+		return "adaptive thresholding block size";
+	case ADAPTIVE_C:
+		return "adaptive thresholding constant";
+	case CLAHE:
+		return "CLAHE";
+	case CLAHE_TILES:
+		return "CLAHE tiles";
+	case CLAHE_CLIP_LIMIT:
+		return "CLAHE clip limit";
+	case AUTO_THRESHOLDING:
+		return "auto thresholding";
+	case AUTO_THRESHOLD_METHOD:
+		return "auto thresholding method";
+	case AUTO_THRESHOLD_PERCENTILE:
+		return "auto thresholding percentile";
+	case AUTO_THRESHOLD_SMOOTHING:
+		return "auto thresholding smoothing";
+	case EQUALIZATION_STRIDE:
+		return "equalization sampling stride";
+	case EQUALIZATION_DRIFT:
+		return "equalization drift";
+	case DETECTION_INTERVAL:
+		return "detection interval";
 	default:
 		return "last action";
 	}
@@ -0,0 +1,26 @@
+#include "PixelDepth.h"
+
+bool PixelDepth::supported(int depth)
+{
+	return depth == CV_8U || depth == CV_16U || depth == CV_32F;
+}
+
+double PixelDepth::maxValue(int depth)
+{
+	switch (depth)
+	{
+	case CV_8U:
+		return Traits<uchar>::MAX;
+	case CV_16U:
+		return Traits<ushort>::MAX;
+	case CV_32F:
+		return Traits<float>::MAX;
+	default:
+		CV_Error(cv::Error::StsUnsupportedFormat, "only CV_8U, CV_16U and CV_32F images are supported");
+	}
+}
+
+double PixelDepth::fromByte(double value, int depth)
+{
+	return value * maxValue(depth) / 255;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief The pixel depths the algorithms support: CV_8U, CV_16U and CV_32F.
+ * @details 8-bit and 16-bit pixels span their whole range, float pixels are in [0, 1], as in cv::imshow().
+ A 12-bit camera frame packed in 16-bit words therefore only uses the low values of its range; ToneMap brightens it for display.
+ The parameters of the menu and of the processing graphs (thresholds, maximum values) stay on the 8-bit scale whatever
+ the depth of the frame: ProcessingAlgorithms brings them to the depth of the image with fromByte(), so that a threshold
+ of 128 splits every image at the same fraction of its range.
+ */
+class IMAGEPROCESSINGUTILS_API PixelDepth
+{
+public:
+	/**
+	 * @brief The properties of a pixel type.
+	 */
+	template<typename T>
+	struct Traits;
+
+	/**
+	 * @brief Gets whether the algorithms support a depth.
+	 */
+	static bool supported(int depth);
+
+	/**
+	 * @brief Gets the value of a white pixel: 255, 65535 or 1.
+	 * @param[in] depth CV_8U, CV_16U or CV_32F.
+	 */
+	static double maxValue(int depth);
+
+	/**
+	 * @brief Brings a value on the 8-bit scale to the scale of a depth.
+	 * @details The 8-bit values map to themselves, to 257 times themselves in 16 bits, and to a 255th of themselves in float.
+	 * @param[in] value The value, from 0 to 255 for the values inside the range.
+	 * @param[in] depth CV_8U, CV_16U or CV_32F.
+	 */
+	static double fromByte(double value, int depth);
+
+	/**
+	 * @brief Calls a generic function with a value of the pixel type of a depth.
+	 * @details The function is typically a generic lambda that takes the type with decltype, so one template serves every depth:
+	 PixelDepth::dispatch(src.depth(), [&](auto pixel) { process<decltype(pixel)>(src); }).
+	 * @param[in] depth CV_8U, CV_16U or CV_32F. The other depths raise cv::Error::StsUnsupportedFormat.
+	 * @param[in] function The function.
+	 */
+	template<typename Function>
+	static void dispatch(int depth, Function&& function)
+	{
+		switch (depth)
+		{
+		case CV_8U:
+			function(uchar());
+			break;
+		case CV_16U:
+			function(ushort());
+			break;
+		case CV_32F:
+			function(float());
+			break;
+		default:
+			CV_Error(cv::Error::StsUnsupportedFormat, "only CV_8U, CV_16U and CV_32F images are supported");
+		}
+	}
+};
+
+template<>
+struct PixelDepth::Traits<uchar>
+{
+	static const int DEPTH = CV_8U;
+	static constexpr float MAX = 255;
+};
+
+template<>
+struct PixelDepth::Traits<ushort>
+{
+	static const int DEPTH = CV_16U;
+	static constexpr float MAX = 65535;
+};
+
+template<>
+struct PixelDepth::Traits<float>
+{
+	static const int DEPTH = CV_32F;
+	static constexpr float MAX = 1;
+};
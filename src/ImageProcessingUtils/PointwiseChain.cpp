@@ -0,0 +1,153 @@
+#include "PointwiseChain.h"
+#include "Kernels.h"
+#include "RowBands.h"
+
+#include <numeric>
+
+namespace
+{
+	PointwiseChain::Table identity()
+	{
+		PointwiseChain::Table table;
+		std::iota(table.begin(), table.end(), 0);
+		return table;
+	}
+}
+
+PointwiseChain::PointwiseChain(ModelImage& image)
+	: image(image), table(identity())
+{
+}
+
+bool PointwiseChain::empty() const
+{
+	return stages == 0;
+}
+
+Histogram::Bins PointwiseChain::histogram()
+{
+	if (!histogramKnown)
+	{
+		grayHistogram = Histogram::compute(image.accept(ModelImage::Gray));
+		histogramKnown = true;
+	}
+
+	return Histogram::remap(grayHistogram, table.data());
+}
+
+void PointwiseChain::useHistogram(const Histogram::Bins& histogram)
+{
+	grayHistogram = histogram;
+	histogramKnown = true;
+}
+
+bool PointwiseChain::knownHistogram(Histogram::Bins& histogram) const
+{
+	if (!histogramKnown)
+		return false;
+
+	histogram = grayHistogram;
+	return true;
+}
+
+void PointwiseChain::compose(const Table& next)
+{
+	image.accept(ModelImage::Gray);
+
+	for (uchar& entry : table)
+		entry = next[entry];
+
+	stages++;
+}
+
+void PointwiseChain::threshold(ThresholdingEngine::Type type, short threshold)
+{
+	CV_Assert(type != ThresholdingEngine::Truncate || image.model() == ModelImage::Gray);
+
+	const Table ramp = identity();
+	Table next;
+	ThresholdingEngine::thresholdRow(ramp.data(), next.data(), Histogram::BINS, type, threshold);
+
+	compose(next);
+}
+
+void PointwiseChain::equalize()
+{
+	Table next;
+	Histogram::equalizationLut(Histogram::cumulative(histogram()), next.data());
+
+	compose(next);
+}
+
+void PointwiseChain::triangleThreshold()
+{
+	autoThreshold(AutoThreshold::Triangle, 0);
+}
+
+void PointwiseChain::autoThreshold(AutoThreshold::Method method, short percentile, AutoThreshold* temporal, short smoothing)
+{
+	const Histogram::Bins current = histogram();
+	const int value = AutoThreshold::find(temporal != nullptr ? temporal->smooth(current, smoothing) : current, method, percentile);
+	threshold(ThresholdingEngine::Binary, static_cast<short>(value));
+}
+
+void PointwiseChain::flush()
+{
+	if (stages == 0)
+		return;
+
+	cv::Mat& gray = image.accept(ModelImage::Gray);
+	apply(gray, table, gray);
+
+	histogramKnown = false;
+	table = identity();
+	stages = 0;
+}
+
+void PointwiseChain::apply(const cv::Mat& src, const Table& table, cv::Mat& dst)
+{
+	CV_Assert(src.type() == CV_8UC1);
+
+	const cv::Mat source = src;
+	dst.create(source.size(), CV_8UC1);
+
+	RowBands::Traits traits;
+	traits.rowBytes = 2 * source.cols;
+	const Kernels& kernels = Kernels::active();
+
+	RowBands::run(source.rows, traits, [&](const cv::Range& range) {
+		for (int y = range.start; y < range.end; y++)
+			kernels.lookupRow(source.ptr<uchar>(y), table.data(), dst.ptr<uchar>(y), source.cols);
+		});
+}
+
+void PointwiseChain::apply(const cv::Mat& src, const WideTable& table, cv::Mat& dst)
+{
+	CV_Assert((src.type() == CV_16UC1 || src.type() == CV_32FC1) && table.size() == Histogram::WIDE_BINS);
+
+	const cv::Mat source = src;
+	dst.create(source.size(), source.type());
+
+	RowBands::Traits traits;
+	traits.rowBytes = 2 * source.cols * source.elemSize();
+
+	RowBands::run(source.rows, traits, [&](const cv::Range& range) {
+		for (int y = range.start; y < range.end; y++)
+		{
+			if (source.depth() == CV_16U)
+			{
+				const ushort* in = source.ptr<ushort>(y);
+				ushort* out = dst.ptr<ushort>(y);
+				for (int x = 0; x < source.cols; x++)
+					out[x] = table[in[x]];
+			}
+			else
+			{
+				const float* in = source.ptr<float>(y);
+				float* out = dst.ptr<float>(y);
+				for (int x = 0; x < source.cols; x++)
+					out[x] = table[Histogram::wideBin(in[x])] * (1.0f / 65535);
+			}
+		}
+		});
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "AutoThreshold.h"
+#include "Histogram.h"
+#include "ModelImage.h"
+#include "Thresholding.h"
+
+#include <opencv2/core.hpp>
+#include <array>
+#include <vector>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief A run of consecutive pointwise stages of applyingAlgorithms(), composed into a single lookup table.
+ * @details Fixed thresholds, grayscale equalization and the automatic thresholds all map every grayscale intensity
+ to a new one, so any sequence of them is a single 256-entry table: each stage only composes its own table
+ with the ones before it. The stages that depend on the histogram compute it once, on the grayscale image the run starts from,
+ and carry it through the tables of the earlier stages. The image is converted to grayscale when the first stage is added,
+ and flush() applies the composed table in place in one vectorized pass, however many stages the run holds.
+ The result is the grayscale image the stages return as BGR, one after the other.
+ */
+class IMAGEPROCESSINGUTILS_API PointwiseChain
+{
+public:
+	typedef std::array<uchar, Histogram::BINS> Table;
+	typedef std::vector<ushort> WideTable;
+
+	/**
+	 * @brief Starts an empty run.
+	 * @param[in,out] image The image the stages apply to. flush() replaces it with the result.
+	 */
+	explicit PointwiseChain(ModelImage& image);
+
+	/**
+	 * @brief Gets whether the run holds no stage.
+	 */
+	bool empty() const;
+
+	/**
+	 * @brief Adds a fixed threshold, as ProcessingAlgorithms::binaryThresholding(), zeroThresholding() or truncate() apply it.
+	 * @details Truncation keeps the colours of a colour image, so it can only be added to a grayscale image.
+	 * @param[in] type The thresholding operation.
+	 * @param[in] threshold The threshold value.
+	 */
+	void threshold(ThresholdingEngine::Type type, short threshold);
+
+	/**
+	 * @brief Adds a grayscale histogram equalization, as ProcessingAlgorithms::grayscaleHistogramEqualization() applies it.
+	 */
+	void equalize();
+
+	/**
+	 * @brief Adds a binary threshold at the triangle threshold, as ProcessingAlgorithms::triangleThresholding() applies it.
+	 */
+	void triangleThreshold();
+
+	/**
+	 * @brief Adds a binary threshold at an automatic threshold, as ProcessingAlgorithms::autoThresholding() applies it.
+	 * @details The threshold is found on the histogram the earlier stages of the run give the image.
+	 * @param[in] method The method.
+	 * @param[in] percentile The percentage of black pixels of AutoThreshold::Percentile.
+	 * @param[in,out] temporal If not null, the histograms of the previous frames, as AutoThreshold::compute() blends them.
+	 * @param[in] smoothing The weight of the previous frames in the blend, in percent.
+	 */
+	void autoThreshold(AutoThreshold::Method method, short percentile, AutoThreshold* temporal = nullptr, short smoothing = 0);
+
+	/**
+	 * @brief Supplies the histogram of the grayscale image the run starts from, when it is already known.
+	 * @details applyingAlgorithms() keeps the histogram in its StageCache, so that a run whose thresholds change
+	 does not count the pixels of the same image again. Truncation of a colour image, which replaces the image a run starts from,
+	 must not be applied afterwards.
+	 * @param[in] histogram The histogram of the image, once converted to grayscale.
+	 */
+	void useHistogram(const Histogram::Bins& histogram);
+
+	/**
+	 * @brief Gets the histogram of the grayscale image the run starts from, if a stage has needed it.
+	 * @param[out] histogram The histogram, left untouched when it is not known.
+	 * @return Returns true if the histogram is known.
+	 */
+	bool knownHistogram(Histogram::Bins& histogram) const;
+
+	/**
+	 * @brief Applies the composed table to the image and starts a new run.
+	 */
+	void flush();
+
+	/**
+	 * @brief Maps a single-channel 8-bit image through a table.
+	 * @param[in] src The CV_8UC1 image.
+	 * @param[in] table The table.
+	 * @param[out] dst The CV_8UC1 result. It may be the source image.
+	 */
+	static void apply(const cv::Mat& src, const Table& table, cv::Mat& dst);
+
+	/**
+	 * @brief Maps a single-channel 16-bit or float image through a table of Histogram::WIDE_BINS entries.
+	 * @details A 16-bit pixel is replaced by the entry of its value. A float pixel is replaced by the entry of its Histogram::wideBin(),
+	 divided by 65535. The table is far too large for the in-register lookups of the 8-bit tables and a gather saves
+	 nothing over scalar loads, so the lookups are scalar, in parallel row bands.
+	 * @param[in] src The CV_16UC1 or CV_32FC1 image.
+	 * @param[in] table The table, from 0 to 65535.
+	 * @param[out] dst The result, of the type of src. It may be the source image.
+	 */
+	static void apply(const cv::Mat& src, const WideTable& table, cv::Mat& dst);
+
+private:
+	// the histogram of the grayscale image the run starts from, computed when a stage first needs it
+	Histogram::Bins histogram();
+
+	void compose(const Table& next);
+
+	ModelImage& image;
+	Histogram::Bins grayHistogram;
+	bool histogramKnown = false;
+	Table table;
+	int stages = 0;
+};
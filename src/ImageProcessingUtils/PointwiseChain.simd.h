@@ -0,0 +1,123 @@
+#pragma once
+
+// The table lookup of PointwiseChain, compiled once per CpuDispatch level through Kernels.simd.h.
+
+#include "Simd.h"
+
+#include <opencv2/core.hpp>
+
+namespace IPU_SIMD_NAMESPACE
+{
+	namespace
+	{
+		// A 256-entry byte table is held as sixteen 16-byte rows, one per high nibble of a pixel, copied into every
+		// 128-bit lane: a byte shuffle on the low nibble picks the entry of each row, and the high nibble picks the row.
+#ifdef IPU_AVX512
+		struct ShuffleTable512
+		{
+			__m512i rows[16];
+
+			explicit ShuffleTable512(const uchar* table)
+			{
+				for (int k = 0; k < 16; k++)
+					rows[k] = _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table + 16 * k)));
+			}
+
+			__m512i lookup(__m512i v) const
+			{
+				const __m512i nibble = _mm512_set1_epi8(0x0F);
+				const __m512i low = _mm512_and_si512(v, nibble);
+				const __m512i high = _mm512_and_si512(_mm512_srli_epi16(v, 4), nibble);
+
+				__m512i result = _mm512_setzero_si512();
+				for (int k = 0; k < 16; k++)
+					result = _mm512_mask_shuffle_epi8(result, _mm512_cmpeq_epi8_mask(high, _mm512_set1_epi8(static_cast<char>(k))), rows[k], low);
+				return result;
+			}
+		};
+#endif
+
+#ifdef IPU_AVX2
+		struct ShuffleTable256
+		{
+			__m256i rows[16];
+
+			explicit ShuffleTable256(const uchar* table)
+			{
+				for (int k = 0; k < 16; k++)
+					rows[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table + 16 * k)));
+			}
+
+			__m256i lookup(__m256i v) const
+			{
+				const __m256i nibble = _mm256_set1_epi8(0x0F);
+				const __m256i low = _mm256_and_si256(v, nibble);
+				const __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+
+				__m256i result = _mm256_setzero_si256();
+				for (int k = 0; k < 16; k++)
+				{
+					__m256i selected = _mm256_cmpeq_epi8(high, _mm256_set1_epi8(static_cast<char>(k)));
+					result = _mm256_or_si256(result, _mm256_and_si256(selected, _mm256_shuffle_epi8(rows[k], low)));
+				}
+				return result;
+			}
+		};
+#endif
+
+#ifdef IPU_SSE42
+		struct ShuffleTable128
+		{
+			__m128i rows[16];
+
+			explicit ShuffleTable128(const uchar* table)
+			{
+				for (int k = 0; k < 16; k++)
+					rows[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table + 16 * k));
+			}
+
+			__m128i lookup(__m128i v) const
+			{
+				const __m128i nibble = _mm_set1_epi8(0x0F);
+				const __m128i low = _mm_and_si128(v, nibble);
+				const __m128i high = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+
+				__m128i result = _mm_setzero_si128();
+				for (int k = 0; k < 16; k++)
+					result = _mm_blendv_epi8(result, _mm_shuffle_epi8(rows[k], low), _mm_cmpeq_epi8(high, _mm_set1_epi8(static_cast<char>(k))));
+				return result;
+			}
+		};
+#endif
+
+		// The shuffle tables only pay off on rows long enough to amortize their setup.
+		void lookupRow(const uchar* src, const uchar* table, uchar* dst, int cols)
+		{
+			int x = 0;
+#if defined(IPU_AVX512)
+			if (cols >= 64)
+			{
+				const ShuffleTable512 shuffled(table);
+				for (; x <= cols - 64; x += 64)
+					_mm512_storeu_si512(dst + x, shuffled.lookup(_mm512_loadu_si512(src + x)));
+			}
+#elif defined(IPU_AVX2)
+			if (cols >= 32)
+			{
+				const ShuffleTable256 shuffled(table);
+				for (; x <= cols - 32; x += 32)
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), shuffled.lookup(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x))));
+			}
+#elif defined(IPU_SSE42)
+			if (cols >= 16)
+			{
+				const ShuffleTable128 shuffled(table);
+				for (; x <= cols - 16; x += 16)
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), shuffled.lookup(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x))));
+			}
+#endif
+			for (; x < cols; x++)
+				dst[x] = table[src[x]];
+		}
+	}
+}
@@ -0,0 +1,595 @@
+#include "ProcessingGraph.h"
+#include "AutoThreshold.h"
+#include "VideoState.h"
+#include "ImageProcessingUtils.h"
+#include "PointwiseChain.h"
+#include "Thresholding.h"
+#include "Histogram.h"
+#include "BinomialFilter.h"
+#include "PixelDepth.h"
+#include "Clahe.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using cv::Mat;
+
+namespace
+{
+	// tags of the intermediate phases a stage caches under the key of its input, past the values of revertable_options
+	const uint64_t GRADIENT_PHASE = 0x100;
+	const uint64_t HISTOGRAM_PHASE = 0x101;
+
+	/**
+	 * @brief What the graph knows about a stage: its name in the YAML files, the models it works in and its parameters.
+	 */
+	struct StageSpec
+	{
+		revertable_options stage;
+		const char* name;
+		ModelImage::Models accepted;
+		int count;
+		const char* parameters[ProcessingGraph::MAX_PARAMETERS];
+		int minimum[ProcessingGraph::MAX_PARAMETERS];
+		int maximum[ProcessingGraph::MAX_PARAMETERS];
+	};
+
+	// the ranges are the ones the algorithms support, wider than the ones of the menu sliders. The graph does not know the depth
+	// of the frames it will run on, so CLAHE takes the grid of the deep frames
+	const StageSpec SPECS[] = {
+		{ GRAYSCALE_HISTOGRAM_EQUALIZATION, "GRAYSCALE_HISTOGRAM_EQUALIZATION", ModelImage::Gray, 0, {}, {}, {} },
+		{ COLOR_HISTOGRAM_EQUALIZATION, "COLOR_HISTOGRAM_EQUALIZATION", ModelImage::Bgr, 0, {}, {}, {} },
+		{ CLAHE, "CLAHE", ModelImage::Gray | ModelImage::Bgr, 2, { "tiles", "clipLimit" }, { 1, 0 }, { Clahe::MAX_DEEP_TILES, 1000 } },
+		{ BINARY_THRESHOLDING, "BINARY_THRESHOLDING", ModelImage::Gray, 1, { "threshold" }, { 0 }, { 255 } },
+		{ ADAPTIVE_THRESHOLDING, "ADAPTIVE_THRESHOLDING", ModelImage::Gray, 3, { "maxValue", "blockSize", "C" }, { 0, 1, -255 }, { 255, 255, 255 } },
+		{ ZERO_THRESHOLDING, "ZERO_THRESHOLDING", ModelImage::Gray, 1, { "threshold" }, { 0 }, { 255 } },
+		{ SOBEL, "SOBEL", ModelImage::Gray, 1, { "kernelSize" }, { 1 }, { BinomialFilter::MAX_KERNEL_SIZE } },
+		{ TRUNC_THRESHOLDING, "TRUNC_THRESHOLDING", ModelImage::Gray | ModelImage::Bgr, 1, { "threshold" }, { 0 }, { 255 } },
+		{ TRIANGLE_THRESHOLDING, "TRIANGLE_THRESHOLDING", ModelImage::Gray, 0, {}, {}, {} },
+		{ AUTO_THRESHOLDING, "AUTO_THRESHOLDING", ModelImage::Gray, 3, { "method", "percentile", "smoothing" }, { 0, 0, 0 }, { AutoThreshold::METHODS - 1, 100, 99 } },
+		{ BINOMIAL, "BINOMIAL", ModelImage::Gray | ModelImage::Bgr, 1, { "kernelSize" }, { 1 }, { BinomialFilter::MAX_KERNEL_SIZE } },
+		{ CANNY, "CANNY", ModelImage::Gray, 3, { "threshold1", "threshold2", "kernelSize" }, { 0, 0, 1 }, { 1024, 1024, BinomialFilter::MAX_KERNEL_SIZE } },
+		{ OPENING, "OPENING", ModelImage::Gray | ModelImage::Bgr, 1, { "kernelSize" }, { 1 }, { 255 } }
+	};
+
+	const StageSpec* findSpec(revertable_options stage)
+	{
+		for (const StageSpec& spec : SPECS)
+			if (spec.stage == stage)
+				return &spec;
+		return nullptr;
+	}
+
+	const StageSpec* findSpec(const std::string& name)
+	{
+		for (const StageSpec& spec : SPECS)
+			if (name == spec.name)
+				return &spec;
+		return nullptr;
+	}
+
+	void checkParameter(const StageSpec& spec, int index, int value, const std::string& where)
+	{
+		if (value < spec.minimum[index] || value > spec.maximum[index])
+			throw std::runtime_error(where + ": " + spec.parameters[index] + " = " + std::to_string(value) + " is out of range ["
+				+ std::to_string(spec.minimum[index]) + ", " + std::to_string(spec.maximum[index]) + "]");
+	}
+
+	bool isPointwise(revertable_options stage)
+	{
+		switch (stage)
+		{
+		case GRAYSCALE_HISTOGRAM_EQUALIZATION:
+		case BINARY_THRESHOLDING:
+		case ZERO_THRESHOLDING:
+		case TRUNC_THRESHOLDING:
+		case TRIANGLE_THRESHOLDING:
+		case AUTO_THRESHOLDING:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	/**
+	 * @brief Groups the nodes into the stages that are cached: every run of consecutive pointwise nodes
+	 is composed into one table by a PointwiseChain, so it forms a single stage.
+	 */
+	std::vector<std::vector<ProcessingGraph::Node>> groupStages(const std::vector<ProcessingGraph::Node>& nodes)
+	{
+		std::vector<std::vector<ProcessingGraph::Node>> stages;
+
+		for (const ProcessingGraph::Node& node : nodes)
+		{
+			if (isPointwise(node.stage) && !stages.empty() && isPointwise(stages.back().back().stage))
+				stages.back().push_back(node);
+			else
+				stages.push_back({ node });
+		}
+
+		return stages;
+	}
+
+	StageCache::Key stageKey(StageCache::Key input, const std::vector<ProcessingGraph::Node>& stage)
+	{
+		StageCache::Key key = input;
+
+		for (const ProcessingGraph::Node& node : stage)
+		{
+			key = StageCache::combine(key, node.stage);
+			for (short parameter : node.parameters)
+				key = StageCache::combine(key, static_cast<uint16_t>(parameter));
+		}
+
+		return key;
+	}
+
+	// the histogram the run starts from, when the cache has it
+	void seedHistogram(PointwiseChain& pointwise, StageCache* cache, StageCache::Key key)
+	{
+		Histogram::Bins histogram;
+		std::vector<Mat> cached;
+
+		if (cache == nullptr || pointwise.knownHistogram(histogram) || !cache->find(key, cached))
+			return;
+
+		std::copy(cached[0].ptr<uint32_t>(), cached[0].ptr<uint32_t>() + Histogram::BINS, histogram.begin());
+		pointwise.useHistogram(histogram);
+	}
+
+	// PointwiseChain composes tables of 256 entries, which only 8-bit frames have: the stages of a deeper frame run one by one,
+	// each as its ProcessingAlgorithms function would apply it, without keeping a histogram
+	void runPointwiseDeep(const std::vector<ProcessingGraph::Node>& nodes, ModelImage& frame, VideoState* video)
+	{
+		for (const ProcessingGraph::Node& node : nodes)
+		{
+			const short value = node.parameters[0];
+
+			if (node.stage == TRUNC_THRESHOLDING && frame.model() != ModelImage::Gray)
+			{
+				Mat& bgr = frame.accept(ModelImage::Bgr);
+				ThresholdingEngine::truncateColor(bgr, bgr, PixelDepth::fromByte(value, bgr.depth()));
+				continue;
+			}
+
+			Mat& gray = frame.accept(ModelImage::Gray);
+			const double scaled = PixelDepth::fromByte(value, gray.depth());
+
+			switch (node.stage)
+			{
+			case GRAYSCALE_HISTOGRAM_EQUALIZATION:
+			{
+				if (video != nullptr)
+				{
+					video->grayEqualizer.apply(gray, gray);
+					break;
+				}
+				PointwiseChain::WideTable lut(Histogram::WIDE_BINS);
+				Histogram::equalizationLut(Histogram::cumulative(Histogram::computeWide(gray)), lut.data());
+				PointwiseChain::apply(gray, lut, gray);
+				break;
+			}
+			case BINARY_THRESHOLDING:
+				ThresholdingEngine::apply(gray, gray, ThresholdingEngine::Binary, scaled);
+				break;
+			case ZERO_THRESHOLDING:
+				ThresholdingEngine::apply(gray, gray, ThresholdingEngine::ToZero, scaled);
+				break;
+			case TRUNC_THRESHOLDING:
+				ThresholdingEngine::apply(gray, gray, ThresholdingEngine::Truncate, scaled);
+				break;
+			case TRIANGLE_THRESHOLDING:
+				ThresholdingEngine::apply(gray, gray, ThresholdingEngine::Binary,
+					Histogram::wideBinValue(Histogram::triangleThreshold(Histogram::computeWide(gray)), gray.depth()));
+				break;
+			case AUTO_THRESHOLDING:
+				AutoThreshold::apply(gray, gray, static_cast<AutoThreshold::Method>(value), node.parameters[1],
+					video != nullptr ? &video->threshold : nullptr, node.parameters[2]);
+				break;
+			default:
+				CV_Error(cv::Error::StsBadArg, "not a pointwise stage");
+			}
+		}
+	}
+
+	void runPointwise(const std::vector<ProcessingGraph::Node>& nodes, ModelImage& frame, StageCache* cache, StageCache::Key input, VideoState* video)
+	{
+		if (frame.mat().depth() != CV_8U)
+		{
+			runPointwiseDeep(nodes, frame, video);
+			return;
+		}
+
+		PointwiseChain pointwise(frame);
+
+		// the key of the histogram of the image the run starts from, which truncation of a colour image replaces
+		StageCache::Key histogramKey = StageCache::combine(input, HISTOGRAM_PHASE);
+
+		for (const ProcessingGraph::Node& node : nodes)
+		{
+			const short value = node.parameters[0];
+
+			switch (node.stage)
+			{
+			case GRAYSCALE_HISTOGRAM_EQUALIZATION:
+				// the table of a video follows the running histogram of its equalizer, which samples the image itself,
+				// so the stages before it are applied first
+				if (video != nullptr)
+				{
+					pointwise.flush();
+					Mat& gray = frame.accept(ModelImage::Gray);
+					video->grayEqualizer.apply(gray, gray);
+					break;
+				}
+				seedHistogram(pointwise, cache, histogramKey);
+				pointwise.equalize();
+				break;
+			case BINARY_THRESHOLDING:
+				pointwise.threshold(ThresholdingEngine::Binary, value);
+				break;
+			case ZERO_THRESHOLDING:
+				pointwise.threshold(ThresholdingEngine::ToZero, value);
+				break;
+			case TRUNC_THRESHOLDING:
+				// truncation keeps the colours of a colour image, so it is only a table on gray pixels
+				if (frame.model() == ModelImage::Gray)
+					pointwise.threshold(ThresholdingEngine::Truncate, value);
+				else
+				{
+					Mat& bgr = frame.accept(ModelImage::Bgr);
+					ThresholdingEngine::truncateColor(bgr, bgr, value);
+					histogramKey = StageCache::combine(StageCache::combine(histogramKey, TRUNC_THRESHOLDING), static_cast<uint16_t>(value));
+				}
+				break;
+			case TRIANGLE_THRESHOLDING:
+				seedHistogram(pointwise, cache, histogramKey);
+				pointwise.triangleThreshold();
+				break;
+			case AUTO_THRESHOLDING:
+				seedHistogram(pointwise, cache, histogramKey);
+				pointwise.autoThreshold(static_cast<AutoThreshold::Method>(value), node.parameters[1],
+					video != nullptr ? &video->threshold : nullptr, node.parameters[2]);
+				break;
+			default:
+				CV_Error(cv::Error::StsBadArg, "not a pointwise stage");
+			}
+		}
+
+		Histogram::Bins histogram;
+		if (cache != nullptr && pointwise.knownHistogram(histogram) && !cache->contains(histogramKey))
+			cache->store(histogramKey, { Mat(1, Histogram::BINS, CV_32SC1, histogram.data()).clone() });
+
+		pointwise.flush();
+	}
+
+	/**
+	 * @brief Runs one stage on the frame, in one of the models it accepts.
+	 * @param[in] input The cache key of the frame, under which the stage keeps its intermediate phases.
+	 * @param[in,out] video The state the stages of a video keep between its frames, or nullptr.
+	 */
+	void runStage(const std::vector<ProcessingGraph::Node>& stage, ModelImage& frame, StageCache* cache, StageCache::Key input, VideoState* video)
+	{
+		const ProcessingGraph::Node& node = stage.front();
+		const std::array<short, ProcessingGraph::MAX_PARAMETERS>& p = node.parameters;
+
+		if (isPointwise(node.stage))
+		{
+			runPointwise(stage, frame, cache, input, video);
+			return;
+		}
+
+		Mat& mat = frame.accept(findSpec(node.stage)->accepted);
+
+		switch (node.stage)
+		{
+		case COLOR_HISTOGRAM_EQUALIZATION:
+			if (video != nullptr)
+				video->colorEqualizer.apply(mat, mat);
+			else
+				ProcessingAlgorithms::colorHistogramEqualization(mat, mat);
+			break;
+		case CLAHE:
+			ProcessingAlgorithms::clahe(mat, mat, p[0], p[1]);
+			break;
+		case ADAPTIVE_THRESHOLDING:
+			ThresholdingEngine::adaptive(mat, mat, PixelDepth::fromByte(p[0], mat.depth()), p[1], p[2]);
+			break;
+		case SOBEL:
+			ProcessingAlgorithms::sobelMagnitude(mat, mat, p[0]);
+			break;
+		case BINOMIAL:
+			BinomialFilter::apply(mat, mat, p[0]);
+			break;
+		case CANNY:
+			// the gradient does not depend on the thresholds, so moving them only redoes the suppression and the tracking
+			ProcessingAlgorithms::cannyEdges(mat, mat, p[0], p[1], p[2], cache,
+				StageCache::combine(StageCache::combine(input, GRADIENT_PHASE), static_cast<uint16_t>(p[2])));
+			break;
+		case OPENING:
+			ProcessingAlgorithms::opening(mat, mat, p[0]);
+			break;
+		default:
+			CV_Error(cv::Error::StsBadArg, "not a processing stage");
+		}
+	}
+
+	// the stages of the menu options, in the order of the menu
+	std::vector<ProcessingGraph::Node> optionNodes(const FrameOptions& options, short value1, short value2, short kernel)
+	{
+		std::vector<ProcessingGraph::Node> nodes;
+
+		if (options.getGrayscaleHistogramEqualization())
+			nodes.push_back({ GRAYSCALE_HISTOGRAM_EQUALIZATION, {} });
+		if (options.getColorHistogramEqualization())
+			nodes.push_back({ COLOR_HISTOGRAM_EQUALIZATION, {} });
+		if (options.getClahe())
+			nodes.push_back({ CLAHE, { options.getClaheTiles(), options.getClaheClipLimit() } });
+		if (options.getBinaryThresholdingValue())
+			nodes.push_back({ BINARY_THRESHOLDING, { value1 } });
+		if (options.getAdaptiveThresholdingValue())
+			nodes.push_back({ ADAPTIVE_THRESHOLDING, { value1, options.getAdaptiveBlockSize(), options.getAdaptiveC() } });
+		if (options.getZeroThresholdingValue())
+			nodes.push_back({ ZERO_THRESHOLDING, { value1 } });
+		if (options.getSobel())
+			nodes.push_back({ SOBEL, { kernel } });
+		if (options.getTruncThresholdingValue())
+			nodes.push_back({ TRUNC_THRESHOLDING, { value1 } });
+		if (options.getTriangleThresholding())
+			nodes.push_back({ TRIANGLE_THRESHOLDING, {} });
+		if (options.getAutoThresholding())
+			nodes.push_back({ AUTO_THRESHOLDING, { options.getAutoThresholdMethod(), options.getAutoThresholdPercentile(), options.getAutoThresholdSmoothing() } });
+		if (options.getBinomial())
+			nodes.push_back({ BINOMIAL, { kernel } });
+		if (options.getCanny())
+			nodes.push_back({ CANNY, { value1, value2, kernel } });
+		if (options.getOpening())
+			nodes.push_back({ OPENING, { kernel } });
+
+		return nodes;
+	}
+
+	// the model the result is displayed in: a colour frame is shown in colour
+	ModelImage::Model displayModel(ModelImage::Model model, ModelImage::Model source)
+	{
+		if (model == ModelImage::Hsv || (model == ModelImage::Gray && source != ModelImage::Gray))
+			return ModelImage::Bgr;
+		return model;
+	}
+}
+
+ProcessingGraph::ProcessingGraph(const std::vector<Node>& nodes)
+{
+	for (const Node& node : nodes)
+		validate(node);
+
+	stages = nodes;
+}
+
+ProcessingGraph ProcessingGraph::fromOptions(const FrameOptions& options, short value1, short value2, short kernel)
+{
+	return ProcessingGraph(optionNodes(options, value1, value2, kernel));
+}
+
+bool ProcessingGraph::updateFromOptions(const FrameOptions& options, short value1, short value2, short kernel)
+{
+	const std::vector<Node> nodes = optionNodes(options, value1, value2, kernel);
+	const bool same = std::equal(nodes.begin(), nodes.end(), stages.begin(), stages.end(), [](const Node& a, const Node& b) {
+		return a.stage == b.stage && a.parameters == b.parameters;
+		});
+	if (same)
+		return false;
+
+	for (const Node& node : nodes)
+		validate(node);
+
+	// the buffers stay, since the next run creates them again only if the frames changed size or type
+	stages = nodes;
+	serializationFilePath.clear();
+	return true;
+}
+
+const std::vector<ProcessingGraph::Node>& ProcessingGraph::nodes() const
+{
+	return stages;
+}
+
+void ProcessingGraph::serialize(const std::string& filePath) const
+{
+	cv::FileStorage fs(filePath, cv::FileStorage::WRITE);
+	if (!fs.isOpened())
+		throw std::runtime_error("Failed to open file for writing: " + filePath);
+
+	fs << "type" << "PROCESSING_GRAPH";
+	fs << "stages" << "[";
+	for (const Node& node : stages)
+	{
+		const StageSpec* spec = findSpec(node.stage);
+
+		fs << "{:";
+		fs << "stage" << spec->name;
+		for (int i = 0; i < spec->count; i++)
+			fs << spec->parameters[i] << static_cast<int>(node.parameters[i]);
+		fs << "}";
+	}
+	fs << "]";
+	fs.release();
+}
+
+void ProcessingGraph::deserialize(const std::string& filePath)
+{
+	cv::FileStorage fs(filePath, cv::FileStorage::READ);
+	if (!fs.isOpened())
+		throw std::runtime_error("Failed to open file for reading: " + filePath);
+
+	std::string type;
+	fs["type"] >> type;
+	if (type != "PROCESSING_GRAPH")
+		throw std::runtime_error(filePath + ": not a processing graph");
+
+	const cv::FileNode list = fs["stages"];
+	if (!list.isSeq())
+		throw std::runtime_error(filePath + ": invalid or missing list of stages");
+
+	// the graph is built aside, so that it is left unchanged by an invalid file
+	std::vector<Node> nodes;
+	for (const cv::FileNode& item : list)
+	{
+		const std::string where = filePath + ": stage " + std::to_string(nodes.size() + 1);
+		if (!item.isMap())
+			throw std::runtime_error(where + ": not a map");
+
+		std::string name;
+		if (item["stage"].isString())
+			item["stage"] >> name;
+
+		const StageSpec* spec = findSpec(name);
+		if (spec == nullptr)
+			throw std::runtime_error(where + ": unknown stage \"" + name + "\"");
+
+		for (const std::string& key : item.keys())
+			if (key != "stage" && std::find(spec->parameters, spec->parameters + spec->count, key) == spec->parameters + spec->count)
+				throw std::runtime_error(where + " (" + name + "): unknown parameter " + key);
+
+		Node node = { spec->stage, {} };
+		for (int i = 0; i < spec->count; i++)
+		{
+			const cv::FileNode value = item[spec->parameters[i]];
+			if (!value.isInt())
+				throw std::runtime_error(where + " (" + name + "): missing or non-integer parameter " + spec->parameters[i]);
+
+			checkParameter(*spec, i, static_cast<int>(value), where + " (" + name + ")");
+			node.parameters[i] = static_cast<short>(static_cast<int>(value));
+		}
+		nodes.push_back(node);
+	}
+	fs.release();
+
+	stages = nodes;
+	serializationFilePath = filePath;
+}
+
+std::string ProcessingGraph::getSerializationFile() const
+{
+	return serializationFilePath;
+}
+
+void ProcessingGraph::setVideoState(VideoState* state)
+{
+	video = state;
+}
+
+bool ProcessingGraph::run(Mat& image, StageCache* cache, StageCache::Key imageKey, const std::atomic<bool>* cancelled)
+{
+	// the result of a video frame depends on the frames before it, which the keys do not identify
+	if (video != nullptr)
+		cache = nullptr;
+
+	// consecutive pointwise stages are composed into one table, and every stage declares the colour models it works in
+	// and returns its result in the model it was given
+	const std::vector<std::vector<Node>> groups = groupStages(stages);
+	const ModelImage::Model source = ModelImage(image).model();
+
+	// keys[i] identifies the frame after the first i groups
+	std::vector<StageCache::Key> keys(1, imageKey);
+	for (const std::vector<Node>& group : groups)
+		keys.push_back(stageKey(keys.back(), group));
+
+	// the input buffer serves as the buffer of its model, so that a frame converted away and back is written into it
+	// rather than into a new image. The other buffers keep their memory from the previous run
+	buffers[ModelImage::slot(source)] = image;
+	const std::vector<ModelImage::Model> models = plan(source);
+	for (ModelImage::Model model : models)
+		buffers[ModelImage::slot(model)].create(image.size(), CV_MAKETYPE(image.depth(), ModelImage::channels(model)));
+
+	// resume from the longest prefix of groups whose result is cached. Every stage leaves the frame in Gray or Bgr,
+	// so its model is known from its channels
+	size_t done = 0;
+	std::vector<Mat> cached;
+	if (cache != nullptr)
+		for (size_t i = groups.size(); i > 0; i--)
+			if (cache->find(keys[i], cached))
+			{
+				done = i;
+				break;
+			}
+
+	ModelImage frame(image);
+	if (done > 0)
+	{
+		// the cached result is shared with the cache, so it is copied into the buffer of its model before being written into
+		Mat& buffer = buffers[ModelImage::slot(ModelImage(cached[0]).model())];
+		cached[0].copyTo(buffer);
+		frame = ModelImage(buffer);
+	}
+	frame.useBuffers(&buffers);
+
+	for (size_t i = done; i < groups.size(); i++)
+	{
+		if (cancelled != nullptr && *cancelled)
+		{
+			buffers[ModelImage::slot(source)] = Mat();
+			return false;
+		}
+
+		runStage(groups[i], frame, cache, keys[i], video);
+
+		// the next stages write into the frame, so the cache keeps its own copy
+		if (cache != nullptr)
+			cache->store(keys[i + 1], { frame.mat().clone() });
+	}
+
+	// the single conversion back to colour, for display
+	frame.convertTo(displayModel(frame.model(), source));
+	image = frame.mat();
+
+	// the result now belongs to the caller and the input to nobody, so the graph lets go of both
+	for (Mat& buffer : buffers)
+		if (buffer.data == image.data)
+			buffer = Mat();
+	buffers[ModelImage::slot(source)] = Mat();
+
+	return true;
+}
+
+std::vector<ModelImage::Model> ProcessingGraph::plan(ModelImage::Model source) const
+{
+	std::vector<ModelImage::Model> models;
+	ModelImage::Model model = source;
+
+	for (const Node& node : stages)
+	{
+		// a pointwise colour truncation stays in colour, and every other pointwise stage works on gray pixels
+		model = ModelImage::choose(model, findSpec(node.stage)->accepted);
+		models.push_back(model);
+	}
+
+	if (displayModel(model, source) != model)
+		models.push_back(displayModel(model, source));
+
+	return models;
+}
+
+std::string ProcessingGraph::stageName(revertable_options stage)
+{
+	const StageSpec* spec = findSpec(stage);
+	return spec != nullptr ? spec->name : std::string();
+}
+
+std::vector<std::string> ProcessingGraph::parameterNames(revertable_options stage)
+{
+	const StageSpec* spec = findSpec(stage);
+	if (spec == nullptr)
+		return {};
+
+	return std::vector<std::string>(spec->parameters, spec->parameters + spec->count);
+}
+
+void ProcessingGraph::validate(const Node& node)
+{
+	const StageSpec* spec = findSpec(node.stage);
+	if (spec == nullptr)
+		throw std::runtime_error("option " + std::to_string(node.stage) + " is not a processing stage");
+
+	for (int i = 0; i < spec->count; i++)
+		checkParameter(*spec, i, node.parameters[i], spec->name);
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "FrameOptions.h"
+#include "ModelImage.h"
+#include "StageCache.h"
+#include "VideoState.h"
+
+#include <opencv2/core.hpp>
+#include <array>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief An ordered list of processing stages, each with its own parameters.
+ * @details applyingAlgorithms() builds the graph of the menu options with fromOptions(), in the fixed order of the menu,
+ or updates the one a caller keeps for a video with updateFromOptions().
+ A graph can also be written in any order, with a stage used any number of times, and saved to or loaded from a YAML file
+ with cv::FileStorage, like the detectors in data/detector_paths:
+
+	type: PROCESSING_GRAPH
+	stages:
+	   - { stage: CLAHE, tiles: 8, clipLimit: 20 }
+	   - { stage: CANNY, threshold1: 50, threshold2: 150, kernelSize: 3 }
+
+ Every stage is checked when the graph is built or loaded, so a graph that loads can always run.
+ Consecutive pointwise stages of an 8-bit frame run as a single PointwiseChain table, those of a 16-bit or float frame one by one.
+ Before a run, the colour model every stage works in is planned from the model of the input, and the graph keeps one buffer
+ per model it converts to, at the depth of the input, reused by every stage
+ and, for a graph run on many frames, by every frame. Only the final result, when it is not in the input buffer, is handed over
+ to the caller and allocated again on the next run.
+ */
+class IMAGEPROCESSINGUTILS_API ProcessingGraph
+{
+public:
+	static const int MAX_PARAMETERS = 3;
+
+	/**
+	 * @brief A stage of the graph.
+	 */
+	struct Node
+	{
+		// the algorithm, named by its menu option
+		revertable_options stage;
+		// the parameters, in the order of parameterNames(stage); the unused ones are 0
+		std::array<short, MAX_PARAMETERS> parameters;
+	};
+
+	/**
+	 * @brief Creates an empty graph, which leaves the image unchanged.
+	 */
+	ProcessingGraph() = default;
+
+	/**
+	 * @brief Creates a graph from its stages.
+	 * @param[in] nodes The stages, in the order they are applied.
+	 * @throws std::runtime_error If a stage is not a processing algorithm or one of its parameters is out of range.
+	 */
+	explicit ProcessingGraph(const std::vector<Node>& nodes);
+
+	/**
+	 * @brief Builds the graph of the menu options, in the order of the menu.
+	 * @param[in] options The options that enable the stages.
+	 * @param[in] value1 The threshold, and the first Canny threshold.
+	 * @param[in] value2 The second Canny threshold.
+	 * @param[in] kernel The kernel size.
+	 */
+	static ProcessingGraph fromOptions(const FrameOptions& options, short value1, short value2, short kernel);
+
+	/**
+	 * @brief Replaces the stages with the ones of the menu options, unless they are the same already.
+	 * @details The graph of a video is kept from one frame to the next and updated with this, so it keeps its buffers
+	 for as long as the options do not change. The parameters are the ones of fromOptions().
+	 * @return Returns true if the stages changed.
+	 */
+	bool updateFromOptions(const FrameOptions& options, short value1, short value2, short kernel);
+
+	/**
+	 * @brief Gets the stages, in the order they are applied.
+	 */
+	const std::vector<Node>& nodes() const;
+
+	/**
+	 * @brief Saves the graph to a YAML file.
+	 * @param[in] filePath The path of the file.
+	 * @throws std::runtime_error If the file cannot be opened.
+	 */
+	void serialize(const std::string& filePath) const;
+
+	/**
+	 * @brief Loads the graph from a YAML file.
+	 * @details The file must have the PROCESSING_GRAPH type and every stage must name a processing algorithm and give it
+	 exactly its parameters, within their ranges. The graph is left unchanged when the file is not valid.
+	 * @param[in] filePath The path of the file.
+	 * @throws std::runtime_error If the file cannot be read or is not valid. The message names the faulty stage.
+	 */
+	void deserialize(const std::string& filePath);
+
+	/**
+	 * @brief Runs the graph on the frames of a video.
+	 * @details The AUTO_THRESHOLDING stages then blend the histogram of every frame with the ones of the frames before it,
+	 by the weight of their smoothing parameter, and the histogram equalization stages go through the VideoEqualizer of the state.
+	 The state outlives the graph, which is replaced when the options change.
+	 While it is set, run() caches nothing, since the result of a frame depends on the ones before it.
+	 * @param[in,out] state The state of the video, or nullptr to process every frame on its own.
+	 */
+	void setVideoState(VideoState* state);
+
+	/**
+	 * @brief Gets the file the graph was last loaded from.
+	 */
+	std::string getSerializationFile() const;
+
+	/**
+	 * @brief Applies the stages to an image.
+	 * @details The image is converted between colour models only when a stage needs it, and back to BGR at the end
+	 when the source is in colour, as applyingAlgorithms() describes. The cache works as there as well.
+	 * @param[in,out] image The CV_8UC1, CV_8UC3 or CV_8UC4 image, replaced with the result. Its buffer may be written into.
+	 * @param[in,out] cache The cache of the stage results, or nullptr to compute every stage.
+	 * @param[in] imageKey The identity of the input image in the cache.
+	 * @param[in] cancelled If not null, checked before every stage.
+	 * @return Returns false if the run was cancelled, in which case image must be discarded.
+	 */
+	bool run(cv::Mat& image, StageCache* cache = nullptr, StageCache::Key imageKey = 0, const std::atomic<bool>* cancelled = nullptr);
+
+	/**
+	 * @brief Plans the colour model every stage works in.
+	 * @param[in] source The model of the input image.
+	 * @return The model of the frame after every stage, in order.
+	 */
+	std::vector<ModelImage::Model> plan(ModelImage::Model source) const;
+
+	/**
+	 * @brief Gets the name of a stage in the YAML files.
+	 * @return The name, or an empty string if the option is not a processing algorithm.
+	 */
+	static std::string stageName(revertable_options stage);
+
+	/**
+	 * @brief Gets the names of the parameters of a stage in the YAML files, in the order of Node::parameters.
+	 */
+	static std::vector<std::string> parameterNames(revertable_options stage);
+
+	/**
+	 * @brief Checks that a node names a processing algorithm and that its parameters are in range.
+	 * @throws std::runtime_error If it does not.
+	 */
+	static void validate(const Node& node);
+
+private:
+	std::vector<Node> stages;
+	std::string serializationFilePath;
+	// what the stages keep between the frames of a video, when the graph runs on one
+	VideoState* video = nullptr;
+	// one planned buffer per colour model, indexed by ModelImage::slot()
+	ModelImage::Buffers buffers;
+};
@@ -1,3 +1,4 @@
+#pragma once
 #ifdef IMAGEPROCESSINGUTILS_EXPORTS
 #define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
 #else
@@ -21,5 +22,17 @@ enum IMAGEPROCESSINGUTILS_API revertable_options {
 	TRIANGLE_THRESHOLDING,
 	BINOMIAL,
 	CANNY,
-	OPENING
+	OPENING,
+	ADAPTIVE_BLOCK_SIZE,
+	ADAPTIVE_C,
+	CLAHE,
+	CLAHE_TILES,
+	CLAHE_CLIP_LIMIT,
+	AUTO_THRESHOLDING,
+	AUTO_THRESHOLD_METHOD,
+	AUTO_THRESHOLD_PERCENTILE,
+	AUTO_THRESHOLD_SMOOTHING,
+	EQUALIZATION_STRIDE,
+	EQUALIZATION_DRIFT,
+	DETECTION_INTERVAL
 };
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "RowBands.h"
+
+#include <algorithm>
+
+namespace
+{
+	bool overlap(const cv::Mat& a, const cv::Mat& b)
+	{
+		if (a.empty() || b.empty())
+			return false;
+
+		const uchar* aEnd = a.ptr<uchar>(a.rows - 1) + a.cols * a.elemSize();
+		const uchar* bEnd = b.ptr<uchar>(b.rows - 1) + b.cols * b.elemSize();
+		return a.data < bEnd && b.data < aEnd;
+	}
+}
+
+std::vector<cv::Range> RowBands::split(int rows, const Traits& traits)
+{
+	CV_Assert(traits.halo >= 0 && traits.granularity >= 1);
+
+	std::vector<cv::Range> bands;
+	if (rows <= 0)
+		return bands;
+
+	const int threads = std::max(cv::getNumThreads(), 1);
+	const long long cacheRows = traits.rowBytes > 0 ? static_cast<long long>(CACHE_BYTES / traits.rowBytes) : rows;
+
+	long long height = cacheRows - 2 * traits.halo;
+	height = std::min<long long>(height, (rows + threads - 1) / threads);
+	height = std::max<long long>({ height, 2LL * traits.halo, 1LL });
+	height = (height + traits.granularity - 1) / traits.granularity * traits.granularity;
+
+	for (long long start = 0; start < rows; start += height)
+		bands.push_back(cv::Range(static_cast<int>(start), static_cast<int>(std::min<long long>(start + height, rows))));
+
+	return bands;
+}
+
+void RowBands::forEachBand(const std::vector<cv::Range>& bands, const std::function<void(int)>& body)
+{
+	const int count = static_cast<int>(bands.size());
+
+	if (count == 1)
+	{
+		body(0);
+		return;
+	}
+
+	cv::parallel_for_(cv::Range(0, count), [&](const cv::Range& range) {
+		for (int band = range.start; band < range.end; band++)
+			body(band);
+		}, count);
+}
+
+void RowBands::run(int rows, const Traits& traits, const std::function<void(const cv::Range&)>& body)
+{
+	const std::vector<cv::Range> bands = split(rows, traits);
+
+	forEachBand(bands, [&](int band) {
+		body(bands[band]);
+		});
+}
+
+cv::Mat RowBands::source(const cv::Mat& src, const cv::Mat& dst, const Traits& traits)
+{
+	if ((traits.halo > 0 || !traits.inPlace) && overlap(src, dst))
+		return src.clone();
+
+	return src;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <functional>
+#include <vector>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief The parallel execution layer shared by the image kernels of the library.
+ * @details A kernel declares the rows it reads around every output row (its halo), the bytes a row costs it
+ and whether it may write over the rows it reads. The image is then cut into row bands small enough for a band
+ and its halo to stay in the cache of one core, never shorter than twice the halo so that the halo rows are not read
+ more often than the band's own, and numerous enough to keep every thread busy.
+ Every band is a separate stripe of the OpenCV thread pool, so threads that finish early take the remaining bands
+ (the TBB backend steals them) and the bands do not have to cost the same.
+ */
+class IMAGEPROCESSINGUTILS_API RowBands
+{
+public:
+	/**
+	 * @brief The per-core cache budget of a band, halo rows included.
+	 */
+	static const size_t CACHE_BYTES = 256 * 1024;
+
+	/**
+	 * @brief What a kernel declares about its rows.
+	 */
+	struct Traits
+	{
+		// source rows read above and below every output row
+		int halo = 0;
+		// bytes read and written for every row, scratch buffers included
+		size_t rowBytes = 0;
+		// whether an output row may be written over the source row it reads; a kernel with a halo never can
+		bool inPlace = true;
+		// band heights are multiples of this, for kernels that process several rows together
+		int granularity = 1;
+	};
+
+	/**
+	 * @brief Cuts rows [0, rows) into bands for a kernel.
+	 * @param[in] rows The number of output rows.
+	 * @param[in] traits The kernel traits.
+	 * @return The bands, in order, covering every row once.
+	 */
+	static std::vector<cv::Range> split(int rows, const Traits& traits);
+
+	/**
+	 * @brief Runs a function once for every band, in parallel.
+	 * @details Kernels that reduce their bands, like a histogram, keep one partial result per band index.
+	 * @param[in] bands The bands, usually from split().
+	 * @param[in] body The function, called with the index of a band.
+	 */
+	static void forEachBand(const std::vector<cv::Range>& bands, const std::function<void(int)>& body);
+
+	/**
+	 * @brief Runs a kernel over rows [0, rows), one band at a time.
+	 * @param[in] rows The number of output rows.
+	 * @param[in] traits The kernel traits.
+	 * @param[in] body The kernel, called with the rows of a band.
+	 */
+	static void run(int rows, const Traits& traits, const std::function<void(const cv::Range&)>& body);
+
+	/**
+	 * @brief Gets the image a kernel reads to produce dst.
+	 * @details When the kernel cannot run in place and dst shares memory with src, the bands would read rows
+	 that other bands have already written, so the kernel gets a copy of src instead.
+	 * @param[in] src The image the kernel reads.
+	 * @param[in] dst The image the kernel writes, already allocated.
+	 * @param[in] traits The kernel traits.
+	 * @return src, or a copy of it.
+	 */
+	static cv::Mat source(const cv::Mat& src, const cv::Mat& dst, const Traits& traits);
+};
@@ -0,0 +1,225 @@
+#include "SharedFrame.h"
+#include "PixelDepth.h"
+#include "ToneMap.h"
+
+#include <opencv2/imgproc.hpp>
+
+namespace
+{
+	/**
+	 * @brief The allocator of the cv::Mats that wrap a QImage.
+	 * @details It never allocates pixels: its UMatData points into the QImage and holds a copy of it as userdata,
+	 so the QImage, and with it the buffer, lives until the last cv::Mat that shares the UMatData is released.
+	 This is how the Python bindings of OpenCV tie a cv::Mat to a numpy array.
+	 */
+	class QImageAllocator : public cv::MatAllocator
+	{
+	public:
+		cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+			cv::AccessFlag flags, cv::UMatUsageFlags usage) const override
+		{
+			// a cv::Mat that is created again gets an ordinary buffer
+			return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usage);
+		}
+
+		bool allocate(cv::UMatData* u, cv::AccessFlag flags, cv::UMatUsageFlags usage) const override
+		{
+			return u != nullptr;
+		}
+
+		void deallocate(cv::UMatData* u) const override
+		{
+			if (u == nullptr)
+				return;
+
+			CV_Assert(u->urefcount >= 0 && u->refcount >= 0);
+			if (u->refcount == 0)
+			{
+				delete static_cast<QImage*>(u->userdata);
+				delete u;
+			}
+		}
+	};
+
+	// never destroyed, since a cv::Mat may release its image after the static objects are gone, as cv::Mat::getStdAllocator() does
+	const QImageAllocator* qimageAllocator()
+	{
+		static const QImageAllocator* allocator = new QImageAllocator();
+		return allocator;
+	}
+
+	// the QImage a cv::Mat wraps, or null if OpenCV owns its pixels
+	QImage* ownerOf(const cv::Mat& mat)
+	{
+		return mat.u != nullptr && mat.u->currAllocator == qimageAllocator() ? static_cast<QImage*>(mat.u->userdata) : nullptr;
+	}
+
+	// the type of the cv::Mat that reads a QImage in place, or -1 if the format must be converted
+	int typeOf(QImage::Format format)
+	{
+		switch (format)
+		{
+		case QImage::Format_ARGB32:
+		case QImage::Format_ARGB32_Premultiplied:
+			return CV_8UC4;
+		case QImage::Format_BGR888:
+			return CV_8UC3;
+		case QImage::Format_Indexed8:
+		case QImage::Format_Grayscale8:
+			return CV_8UC1;
+		case QImage::Format_Grayscale16:
+			return CV_16UC1;
+		default:
+			return -1;
+		}
+	}
+
+	// a cv::Mat header over the pixels of a QImage, which it does not keep alive
+	cv::Mat headerOf(const QImage& image, int type)
+	{
+		return cv::Mat(image.height(), image.width(), type, const_cast<uchar*>(image.constBits()), static_cast<size_t>(image.bytesPerLine()));
+	}
+
+	// a cv::Mat over the pixels of a QImage, which it keeps alive
+	cv::Mat wrap(const QImage& image, int type)
+	{
+		cv::Mat mat = headerOf(image, type);
+
+		cv::UMatData* u = new cv::UMatData(qimageAllocator());
+		u->data = u->origdata = mat.data;
+		u->size = mat.step[0] * mat.rows;
+		u->userdata = new QImage(image);
+		mat.u = u;
+		mat.addref();
+		return mat;
+	}
+
+	void releaseMat(void* mat)
+	{
+		delete static_cast<cv::Mat*>(mat);
+	}
+}
+
+SharedFrame::SharedFrame(const cv::Mat& mat)
+	: buffer(mat.u != nullptr || mat.empty() ? mat : mat.clone())
+{
+}
+
+SharedFrame::SharedFrame(const QImage& image)
+{
+	if (image.isNull())
+		return;
+
+	const int type = typeOf(image.format());
+	if (type != -1)
+	{
+		buffer = wrap(image, type);
+		return;
+	}
+
+	switch (image.format())
+	{
+	case QImage::Format_RGB32:
+		cv::cvtColor(headerOf(image, CV_8UC4), buffer, cv::COLOR_BGRA2BGR);   // drop the all-white alpha channel
+		break;
+	case QImage::Format_RGB888:
+		cv::cvtColor(headerOf(image, CV_8UC3), buffer, cv::COLOR_RGB2BGR);
+		break;
+	case QImage::Format_RGBX64:
+	case QImage::Format_RGBA64:
+	case QImage::Format_RGBA64_Premultiplied:
+		cv::cvtColor(headerOf(image, CV_16UC4), buffer, cv::COLOR_RGBA2BGR);   // reorder the channels and drop alpha
+		break;
+	default:
+		break;
+	}
+}
+
+bool SharedFrame::empty() const
+{
+	return buffer.empty();
+}
+
+int SharedFrame::width() const
+{
+	return buffer.cols;
+}
+
+int SharedFrame::height() const
+{
+	return buffer.rows;
+}
+
+const cv::Mat& SharedFrame::mat() const
+{
+	return buffer;
+}
+
+cv::Mat& SharedFrame::writable()
+{
+	if (buffer.empty())
+		return buffer;
+
+	// another cv::Mat, or a QImage exported by image(), shares the pixels, or nothing tells whether one does
+	if (buffer.u == nullptr || buffer.u->refcount > 1)
+	{
+		buffer = buffer.clone();
+		return buffer;
+	}
+
+	// the copy on write of Qt: the QImage copies its pixels if another QImage shares them or they are read-only
+	if (QImage* owner = ownerOf(buffer))
+	{
+		owner->bits();
+		if (owner->constBits() != buffer.data)
+			buffer = wrap(QImage(*owner), buffer.type());
+	}
+
+	return buffer;
+}
+
+cv::Mat& SharedFrame::reuse()
+{
+	// the buffer of a QImage may be read-only, which only Qt knows
+	if (buffer.u == nullptr || buffer.u->refcount > 1 || ownerOf(buffer) != nullptr)
+		buffer.release();
+	return buffer;
+}
+
+QImage SharedFrame::image() const
+{
+	if (buffer.empty())
+		return QImage();
+
+	// an imported QImage keeps its own format while the frame still has its pixels
+	if (const QImage* owner = ownerOf(buffer))
+		if (owner->constBits() == buffer.data && typeOf(owner->format()) == buffer.type()
+			&& owner->width() == buffer.cols && owner->height() == buffer.rows && static_cast<size_t>(owner->bytesPerLine()) == buffer.step)
+			return *owner;
+
+	if (!PixelDepth::supported(buffer.depth()))
+		return QImage();
+
+	cv::Mat display;
+	ToneMap::apply(buffer, display);
+
+	QImage::Format format;
+	switch (display.type())
+	{
+	case CV_8UC4:
+		format = QImage::Format_ARGB32;
+		break;
+	case CV_8UC3:
+		format = QImage::Format_BGR888;
+		break;
+	case CV_8UC1:
+		format = QImage::Format_Grayscale8;
+		break;
+	default:
+		return QImage();
+	}
+
+	// the const data makes the image read-only, and the cv::Mat it holds is released with its last copy
+	return QImage(static_cast<const uchar*>(display.data), display.cols, display.rows, static_cast<qsizetype>(display.step), format,
+		releaseMat, new cv::Mat(display));
+}
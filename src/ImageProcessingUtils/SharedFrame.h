@@ -0,0 +1,93 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <QImage>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief A frame whose pixels are shared between cv::Mat and QImage, without copies.
+ * @details The frame holds one reference-counted buffer, and every cv::Mat and QImage it hands out is a reference to it:
+ - a QImage imported in a layout OpenCV reads directly is wrapped by a cv::Mat whose reference count keeps the QImage alive;
+ - a cv::Mat is exported as a read-only QImage that holds a reference to the cv::Mat, so the buffer lives as long as
+ either side uses it and Qt copies it before writing into it.
+ 3-channel frames are exported as QImage::Format_BGR888, which is the memory layout of OpenCV, so no channel swap is needed.
+ A camera frame thus crosses the boundary with no copy at all. The pixels are only copied by writable(), and only
+ when another cv::Mat or QImage still shares them. Copying a SharedFrame shares the buffer as well.
+ */
+class IMAGEPROCESSINGUTILS_API SharedFrame
+{
+public:
+	/**
+	 * @brief Creates an empty frame.
+	 */
+	SharedFrame() = default;
+
+	/**
+	 * @brief Shares the pixels of a cv::Mat.
+	 * @details A cv::Mat that wraps memory it does not own has no reference count to share, so its pixels are copied once.
+	 * @param[in] mat The image, of any type. Only the 8-bit, 16-bit and float ones with 1, 3 or 4 channels can be exported.
+	 */
+	explicit SharedFrame(const cv::Mat& mat);
+
+	/**
+	 * @brief Shares the pixels of a QImage.
+	 * @details Format_ARGB32, Format_ARGB32_Premultiplied, Format_BGR888, Format_Indexed8, Format_Grayscale8 and Format_Grayscale16
+	 images are shared as CV_8UC4, CV_8UC3, CV_8UC1 and CV_16UC1 pixels. Format_RGB32 and Format_RGB888 images are converted once to CV_8UC3,
+	 Format_RGBX64, Format_RGBA64 and Format_RGBA64_Premultiplied ones to CV_16UC3. The frame of any other format is empty.
+	 * @param[in] image The image.
+	 */
+	explicit SharedFrame(const QImage& image);
+
+	/**
+	 * @brief Gets whether the frame has no pixels.
+	 */
+	bool empty() const;
+
+	/**
+	 * @brief Gets the width of the frame, in pixels.
+	 */
+	int width() const;
+
+	/**
+	 * @brief Gets the height of the frame, in pixels.
+	 */
+	int height() const;
+
+	/**
+	 * @brief Gets the pixels, to read them.
+	 * @details The returned cv::Mat shares the buffer and must not be written into: see writable().
+	 */
+	const cv::Mat& mat() const;
+
+	/**
+	 * @brief Gets the pixels, to write them.
+	 * @details The buffer is copied first if any other cv::Mat or QImage shares it, so the writes are never seen by them.
+	 The reference may also be assigned another image, which replaces the pixels of the frame. It is valid until the frame is shared again.
+	 */
+	cv::Mat& writable();
+
+	/**
+	 * @brief Gets a cv::Mat to write a whole new frame into, like the one cv::VideoCapture::read() fills.
+	 * @details The buffer is kept if nothing else shares it, so a frame of the same size and type is written without allocating.
+	 Otherwise it is let go rather than copied, since its pixels are about to be replaced.
+	 */
+	cv::Mat& reuse();
+
+	/**
+	 * @brief Gets the frame as a QImage, for display.
+	 * @details 8-bit frames are shared: 4 channels as Format_ARGB32, 3 as Format_BGR888 and 1 as Format_Grayscale8.
+	 16-bit and float frames are brought to 8 bits by ToneMap into a new buffer. An imported QImage whose pixels are still
+	 the ones of the frame is returned as it is, in its own format.
+	 The QImage keeps the buffer alive and is read-only: Qt copies the pixels before any write.
+	 * @return The image, null if the frame is empty or of a type that cannot be displayed.
+	 */
+	QImage image() const;
+
+private:
+	cv::Mat buffer;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+// Compile-time SIMD availability for the hand written image kernels.
+// SSE2 is part of every x64 target and is the baseline of the whole library. The wider instruction sets are only
+// enabled in the kernel variants that Kernels.h dispatches to at runtime: their translation units are compiled with
+// the matching compiler flags (see CMakeLists.txt), so the same kernel source gains its SSE4.2, AVX2 or AVX-512 loops
+// there. Every kernel keeps a scalar tail so the library still builds for targets without any of them.
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IPU_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// MSVC has no flag that enables SSE4.2 alone, so its variant defines IPU_TARGET_SSE42 instead
+#if defined(__SSE4_2__) || defined(IPU_TARGET_SSE42) || defined(__AVX2__)
+#define IPU_SSE42 1
+#include <smmintrin.h>
+#include <tmmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define IPU_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+#define IPU_AVX512 1
+#include <immintrin.h>
+#endif
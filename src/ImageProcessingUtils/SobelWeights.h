@@ -0,0 +1,17 @@
+#pragma once
+
+// The weights of the derivative kernels of GradientEngine: the pixel at offset (i, j) weighs 2 * j / (i^2 + j^2)
+// horizontally and 2 * i / (i^2 + j^2) vertically, held as integers with SOBEL_WEIGHT_BITS fractional bits.
+// The kernel variants only evaluate them in constant expressions, so they never compile a copy of sobelWeight()
+// that the linker could pick for the baseline code.
+
+const int SOBEL_WEIGHT_BITS = 12;
+
+constexpr int sobelWeight(int i, int j, bool vertical)
+{
+	if (i == 0 && j == 0)
+		return 0;
+
+	double w = 2.0 * (vertical ? i : j) / (i * i + j * j) * (1 << SOBEL_WEIGHT_BITS);
+	return static_cast<int>(w >= 0 ? w + 0.5 : w - 0.5);
+}
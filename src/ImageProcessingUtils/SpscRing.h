@@ -0,0 +1,108 @@
+#pragma once
+
+#include "CacheLine.h"
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <vector>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief A bounded lock-free queue between exactly one producer thread and one consumer thread.
+ * @details The producer only writes the tail and the consumer only writes the head, each on its own cache line, so a push or a pop
+ is one release store and, most of the time, no read of the other side: each side keeps the last index it saw of the other one
+ and only reads it again when the queue looks full or empty. Neither side ever waits: a push into a full queue and a pop from an
+ empty one fail, and the caller decides whether to retry, drop or wait.
+ The items are moved in and out, so a SharedFrame or a std::shared_ptr travels as a handle and its pixels are never copied.
+ */
+template<typename T>
+class SpscRing
+{
+public:
+	/**
+	 * @brief Creates an empty ring.
+	 * @param[in] capacity The largest number of items, at least 1.
+	 */
+	explicit SpscRing(size_t capacity)
+		: limit(capacity)
+	{
+		CV_Assert(capacity >= 1);
+
+		// a power of two size turns the index into a mask
+		size_t size = 1;
+		while (size < capacity)
+			size <<= 1;
+		slots.resize(size);
+		mask = size - 1;
+	}
+
+	SpscRing(const SpscRing&) = delete;
+	SpscRing& operator=(const SpscRing&) = delete;
+
+	/**
+	 * @brief Appends an item, from the producer thread.
+	 * @return Returns false if the ring is full, in which case the item is not moved from.
+	 */
+	bool tryPush(T&& item)
+	{
+		const size_t position = tail.load(std::memory_order_relaxed);
+		if (position - headSeen == limit)
+		{
+			headSeen = head.load(std::memory_order_acquire);
+			if (position - headSeen == limit)
+				return false;
+		}
+
+		slots[position & mask] = std::move(item);
+		tail.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief Removes the oldest item, from the consumer thread.
+	 * @return Returns false if the ring is empty.
+	 */
+	bool tryPop(T& item)
+	{
+		const size_t position = head.load(std::memory_order_relaxed);
+		if (position == tailSeen)
+		{
+			tailSeen = tail.load(std::memory_order_acquire);
+			if (position == tailSeen)
+				return false;
+		}
+
+		item = std::move(slots[position & mask]);
+		head.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief Gets the number of items, which is only a snapshot while the other thread works.
+	 */
+	size_t size() const
+	{
+		return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+	}
+
+	size_t capacity() const
+	{
+		return limit;
+	}
+
+private:
+	// written by the producer: the next slot to fill, and the head it last saw
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail{ 0 };
+	size_t headSeen = 0;
+	// written by the consumer: the next slot to empty, and the tail it last saw
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> head{ 0 };
+	size_t tailSeen = 0;
+	alignas(CACHE_LINE_SIZE) std::vector<T> slots;
+	size_t mask = 0;
+	const size_t limit;
+};
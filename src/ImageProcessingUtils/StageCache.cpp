@@ -0,0 +1,105 @@
+#include "StageCache.h"
+
+namespace
+{
+	size_t bytesOf(const std::vector<cv::Mat>& mats)
+	{
+		size_t bytes = 0;
+		for (const cv::Mat& mat : mats)
+			bytes += mat.total() * mat.elemSize();
+		return bytes;
+	}
+}
+
+StageCache::StageCache(size_t capacity)
+	: limit(capacity)
+{
+}
+
+void StageCache::setCapacity(size_t bytes)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	limit = bytes;
+	evict(limit);
+}
+
+size_t StageCache::capacity() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return limit;
+}
+
+size_t StageCache::size() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return used;
+}
+
+bool StageCache::find(Key key, std::vector<cv::Mat>& mats)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	auto found = index.find(key);
+	if (found == index.end())
+		return false;
+
+	entries.splice(entries.begin(), entries, found->second);
+	mats = found->second->mats;
+	return true;
+}
+
+bool StageCache::contains(Key key) const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return index.count(key) != 0;
+}
+
+void StageCache::store(Key key, const std::vector<cv::Mat>& mats)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	auto found = index.find(key);
+	if (found != index.end())
+	{
+		used -= found->second->bytes;
+		entries.erase(found->second);
+		index.erase(found);
+	}
+
+	const size_t bytes = bytesOf(mats);
+	if (bytes > limit)
+		return;
+
+	// make room first, so the new entry is never the one evicted
+	evict(limit - bytes);
+
+	entries.push_front({ key, mats, bytes });
+	index[key] = entries.begin();
+	used += bytes;
+}
+
+void StageCache::clear()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	entries.clear();
+	index.clear();
+	used = 0;
+}
+
+StageCache::Key StageCache::combine(Key seed, uint64_t value)
+{
+	// the 64-bit variant of boost::hash_combine, with the value scrambled first so that small parameters spread out
+	value *= 0xff51afd7ed558ccdULL;
+	value ^= value >> 33;
+	return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+void StageCache::evict(size_t bytes)
+{
+	while (used > bytes && !entries.empty())
+	{
+		used -= entries.back().bytes;
+		index.erase(entries.back().key);
+		entries.pop_back();
+	}
+}
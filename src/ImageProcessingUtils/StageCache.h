@@ -0,0 +1,109 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief A memory-capped cache of the intermediate results of applyingAlgorithms().
+ * @details An entry is a list of images stored under a 64-bit key. applyingAlgorithms() keys the result of every stage
+ by the identity of its input image combined with the parameters of all the stages up to it, so a parameter change
+ only recomputes the stages from the first one it affects. Stages with several phases, like canny(), store their
+ intermediate phases under the key of their input as well.
+ The images of an entry share their data with the caller, who must not write into them once they are stored or found.
+ When the stored bytes exceed the capacity, the least recently used entries are dropped.
+ The cache may be shared between threads, so that a background run and the interactive one resume from the same results.
+ */
+class IMAGEPROCESSINGUTILS_API StageCache
+{
+public:
+	typedef uint64_t Key;
+
+	static const size_t DEFAULT_CAPACITY = 512 * 1024 * 1024;
+
+	/**
+	 * @brief Creates an empty cache.
+	 * @param[in] capacity The largest number of bytes the entries may hold.
+	 */
+	explicit StageCache(size_t capacity = DEFAULT_CAPACITY);
+
+	/**
+	 * @brief Changes the capacity, dropping the least recently used entries that no longer fit.
+	 * @param[in] bytes The largest number of bytes the entries may hold.
+	 */
+	void setCapacity(size_t bytes);
+
+	/**
+	 * @brief Gets the capacity, in bytes.
+	 */
+	size_t capacity() const;
+
+	/**
+	 * @brief Gets the number of bytes held by the entries.
+	 */
+	size_t size() const;
+
+	/**
+	 * @brief Looks an entry up and marks it as the most recently used.
+	 * @param[in] key The key of the entry.
+	 * @param[out] mats The images of the entry, left untouched when there is none.
+	 * @return Returns true if the entry was found.
+	 */
+	bool find(Key key, std::vector<cv::Mat>& mats);
+
+	/**
+	 * @brief Gets whether an entry is cached, without marking it as used.
+	 * @param[in] key The key of the entry.
+	 */
+	bool contains(Key key) const;
+
+	/**
+	 * @brief Stores an entry as the most recently used, replacing any entry with the same key.
+	 * @details An entry larger than the whole capacity is not stored.
+	 * @param[in] key The key of the entry.
+	 * @param[in] mats The images. Their data is shared, not copied.
+	 */
+	void store(Key key, const std::vector<cv::Mat>& mats);
+
+	/**
+	 * @brief Drops every entry.
+	 */
+	void clear();
+
+	/**
+	 * @brief Mixes a value into a key.
+	 * @details Keys are built by folding the identity of the input image and then the identifier and the parameters
+	 of every stage into a seed, so that the key of a stage depends on the whole prefix of stages before it.
+	 * @param[in] seed The key so far.
+	 * @param[in] value The value to mix in.
+	 * @return The new key.
+	 */
+	static Key combine(Key seed, uint64_t value);
+
+private:
+	struct Entry
+	{
+		Key key;
+		std::vector<cv::Mat> mats;
+		size_t bytes;
+	};
+
+	// drops the least recently used entries until at most bytes are held
+	void evict(size_t bytes);
+
+	// the most recently used entry first
+	std::list<Entry> entries;
+	std::unordered_map<Key, std::list<Entry>::iterator> index;
+	size_t limit;
+	size_t used = 0;
+	mutable std::mutex lock;
+};
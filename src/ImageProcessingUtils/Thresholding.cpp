@@ -0,0 +1,284 @@
+#include "Thresholding.h"
+#include "Kernels.h"
+#include "PixelDepth.h"
+#include "RowBands.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+	// The running column sums of a depth: 8-bit and 16-bit images sum on integers, float images in double precision.
+	template<typename T>
+	struct AdaptiveSums
+	{
+		typedef int Column;
+		typedef long long Total;
+	};
+
+	template<>
+	struct AdaptiveSums<float>
+	{
+		typedef double Column;
+		typedef double Total;
+	};
+
+	// Adds (Sign = 1) or subtracts (Sign = -1) a row of pixels to the column sums. 8-bit rows go through the vector kernels.
+	template<int Sign, typename T, typename Column>
+	void accumulate(const Kernels& kernels, Column* sums, const T* row, int width)
+	{
+		if constexpr (std::is_same<T, uchar>::value)
+			(Sign > 0 ? kernels.addColumns : kernels.subtractColumns)(sums, row, width);
+		else
+			for (int x = 0; x < width; x++)
+				sums[x] += Sign * static_cast<Column>(row[x]);
+	}
+
+	// Thresholds the rows [range.start, range.end) of src. The column sums are seeded once for the first row
+	// of the band and then slid down one row at a time, the row sums are slid along each row.
+	template<typename T>
+	void adaptiveBand(const cv::Mat& src, cv::Mat& dst, const cv::Range& range, int radius, T maxValue, int C)
+	{
+		typedef typename AdaptiveSums<T>::Column Column;
+		typedef typename AdaptiveSums<T>::Total Total;
+
+		const int rows = src.rows;
+		const int cols = src.cols;
+		const Kernels& kernels = Kernels::active();
+		std::vector<Column> colSum(cols, 0);
+
+		for (int y = std::max(0, range.start - radius); y <= std::min(rows - 1, range.start + radius); y++)
+			accumulate<1>(kernels, colSum.data(), src.ptr<T>(y), cols);
+
+		// src > mean * (100 - C) / 100  <=>  100 * src * area > (100 - C) * sum
+		const Total scale = 100 - C;
+
+		for (int y = range.start; y < range.end; y++)
+		{
+			const T* in = src.ptr<T>(y);
+			T* out = dst.ptr<T>(y);
+			const Total height = std::min(rows - 1, y + radius) - std::max(0, y - radius) + 1;
+
+			Total sum = 0;
+			for (int x = 0; x <= std::min(cols - 1, radius); x++)
+				sum += colSum[x];
+
+			for (int x = 0; x < cols; x++)
+			{
+				const Total width = std::min(cols - 1, x + radius) - std::max(0, x - radius) + 1;
+				out[x] = 100 * static_cast<Total>(in[x]) * height * width > scale * sum ? maxValue : 0;
+
+				if (x + radius + 1 < cols)
+					sum += colSum[x + radius + 1];
+				if (x - radius >= 0)
+					sum -= colSum[x - radius];
+			}
+
+			if (y + radius + 1 < rows)
+				accumulate<1>(kernels, colSum.data(), src.ptr<T>(y + radius + 1), cols);
+			if (y - radius >= 0)
+				accumulate<-1>(kernels, colSum.data(), src.ptr<T>(y - radius), cols);
+		}
+	}
+
+	// An integer image compares its pixels with the next integer, and truncates to the integer part.
+	double integerThreshold(double threshold, ThresholdingEngine::Type type)
+	{
+		return type == ThresholdingEngine::Truncate ? std::floor(threshold) : std::ceil(threshold);
+	}
+
+	void thresholdRow16(const ushort* src, ushort* dst, int width, ThresholdingEngine::Type type, double threshold)
+	{
+		const double t = integerThreshold(threshold, type);
+
+		// thresholds above the 16-bit range turn every pixel off for the binary and to-zero operations
+		if (t > 65535 && type != ThresholdingEngine::Truncate)
+		{
+			std::memset(dst, 0, width * sizeof(ushort));
+			return;
+		}
+
+		const ushort value = static_cast<ushort>(std::clamp(t, 0.0, 65535.0));
+		const Kernels& kernels = Kernels::active();
+
+		switch (type)
+		{
+		case ThresholdingEngine::Binary:
+			kernels.binaryRow16(src, dst, width, value);
+			break;
+		case ThresholdingEngine::ToZero:
+			kernels.toZeroRow16(src, dst, width, value);
+			break;
+		case ThresholdingEngine::Truncate:
+			kernels.truncateRow16(src, dst, width, value);
+			break;
+		}
+	}
+
+	void thresholdRow32f(const float* src, float* dst, int width, ThresholdingEngine::Type type, float threshold)
+	{
+		const Kernels& kernels = Kernels::active();
+
+		switch (type)
+		{
+		case ThresholdingEngine::Binary:
+			kernels.binaryRow32f(src, dst, width, threshold);
+			break;
+		case ThresholdingEngine::ToZero:
+			kernels.toZeroRow32f(src, dst, width, threshold);
+			break;
+		case ThresholdingEngine::Truncate:
+			kernels.truncateRow32f(src, dst, width, threshold);
+			break;
+		}
+	}
+
+	// The luminance test of the deep images: with the integer weights of truncateColorRow() for 16 bits, whose 10000 * 65535
+	// still fits in an int, and with the floating point formula for floats.
+	template<typename T>
+	void truncateColorRowDeep(const T* src, T* dst, int width, double threshold)
+	{
+		const T value = static_cast<T>(threshold);
+
+		for (int x = 0; x < width; x++, src += 3, dst += 3)
+		{
+			bool above;
+			if constexpr (std::is_same<T, float>::value)
+				above = 0.0722 * src[0] + 0.7152 * src[1] + 0.2126 * src[2] >= threshold;
+			else
+				above = 722 * src[0] + 7152 * src[1] + 2126 * src[2] >= 10000 * static_cast<int>(value);
+
+			dst[0] = above ? value : src[0];
+			dst[1] = above ? value : src[1];
+			dst[2] = above ? value : src[2];
+		}
+	}
+}
+
+void ThresholdingEngine::thresholdRow(const uchar* src, uchar* dst, int width, Type type, short threshold)
+{
+	// thresholds above the 8-bit range turn every pixel off for the binary and to-zero operations
+	if (threshold > 255 && type != Truncate)
+	{
+		std::memset(dst, 0, width);
+		return;
+	}
+
+	uchar t = static_cast<uchar>(std::clamp<short>(threshold, 0, 255));
+	const Kernels& kernels = Kernels::active();
+
+	switch (type)
+	{
+	case Binary:
+		kernels.binaryRow(src, dst, width, t);
+		break;
+	case ToZero:
+		kernels.toZeroRow(src, dst, width, t);
+		break;
+	case Truncate:
+		kernels.truncateRow(src, dst, width, t);
+		break;
+	}
+}
+
+void ThresholdingEngine::apply(const cv::Mat& src, cv::Mat& dst, Type type, double threshold)
+{
+	CV_Assert(src.type() == CV_8UC1 || src.type() == CV_16UC1 || src.type() == CV_32FC1);
+
+	const cv::Mat source = src;
+	dst.create(source.size(), source.type());
+
+	RowBands::Traits traits;
+	traits.rowBytes = 2 * source.cols * source.elemSize();
+
+	// the 8-bit threshold saturates to the range of a short, which thresholdRow() then clamps to the 8-bit range
+	const short byteThreshold = static_cast<short>(std::clamp(integerThreshold(threshold, type), -1.0, 256.0));
+
+	RowBands::run(source.rows, traits, [&](const cv::Range& range) {
+		for (int y = range.start; y < range.end; y++)
+		{
+			switch (source.depth())
+			{
+			case CV_8U:
+				thresholdRow(source.ptr<uchar>(y), dst.ptr<uchar>(y), source.cols, type, byteThreshold);
+				break;
+			case CV_16U:
+				thresholdRow16(source.ptr<ushort>(y), dst.ptr<ushort>(y), source.cols, type, threshold);
+				break;
+			default:
+				thresholdRow32f(source.ptr<float>(y), dst.ptr<float>(y), source.cols, type, static_cast<float>(threshold));
+				break;
+			}
+		}
+		});
+}
+
+void ThresholdingEngine::truncateColor(const cv::Mat& src, cv::Mat& dst, double threshold)
+{
+	CV_Assert(src.type() == CV_8UC3 || src.type() == CV_16UC3 || src.type() == CV_32FC3);
+
+	const cv::Mat source = src;
+	dst.create(source.size(), source.type());
+
+	RowBands::Traits traits;
+	traits.rowBytes = 6 * source.cols * source.elemSize1();
+
+	if (source.depth() != CV_8U)
+	{
+		const double t = source.depth() == CV_16U ? std::clamp(std::floor(threshold), 0.0, 65535.0) : threshold;
+
+		PixelDepth::dispatch(source.depth(), [&](auto pixel) {
+			typedef decltype(pixel) T;
+			RowBands::run(source.rows, traits, [&](const cv::Range& range) {
+				for (int y = range.start; y < range.end; y++)
+					truncateColorRowDeep(source.ptr<T>(y), dst.ptr<T>(y), source.cols, t);
+				});
+			});
+		return;
+	}
+
+	// no 8-bit pixel reaches a luminance above 255
+	if (threshold > 255)
+	{
+		if (dst.data != source.data)
+			source.copyTo(dst);
+		return;
+	}
+
+	short t = static_cast<short>(std::max(std::floor(threshold), 0.0));
+	int limit = 10000 * t;
+
+	const Kernels& kernels = Kernels::active();
+
+	RowBands::run(source.rows, traits, [&](const cv::Range& range) {
+		for (int y = range.start; y < range.end; y++)
+			kernels.truncateColorRow(source.ptr<uchar>(y), dst.ptr<uchar>(y), source.cols, limit, static_cast<uchar>(t));
+		});
+}
+
+void ThresholdingEngine::adaptive(const cv::Mat& src, cv::Mat& dst, double maxValue, short blockSize, short C)
+{
+	CV_Assert(src.type() == CV_8UC1 || src.type() == CV_16UC1 || src.type() == CV_32FC1);
+
+	const int radius = std::max(1, blockSize / 2);
+
+	// every band seeds its column sums with its halo rows
+	RowBands::Traits traits;
+	traits.halo = radius;
+	traits.rowBytes = 2 * src.cols * src.elemSize();
+
+	dst.create(src.size(), src.type());
+	const cv::Mat source = RowBands::source(src, dst, traits);
+
+	PixelDepth::dispatch(source.depth(), [&](auto pixel) {
+		typedef decltype(pixel) T;
+		const T value = cv::saturate_cast<T>(maxValue);
+
+		RowBands::run(source.rows, traits, [&](const cv::Range& range) {
+			adaptiveBand<T>(source, dst, range, radius, value, C);
+			});
+		});
+}
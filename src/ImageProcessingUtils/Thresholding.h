@@ -0,0 +1,68 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+class IMAGEPROCESSINGUTILS_API ThresholdingEngine
+{
+public:
+	enum Type { Binary, ToZero, Truncate };
+
+	/**
+	 * @brief Applies a fixed threshold to a single-channel image.
+	 * @details The image is processed in parallel row bands, one row at a time with SSE2/AVX2/AVX-512 kernels, without any per-pixel branches.
+	 Binary sets the pixels below the threshold to 0 and the others to the white of the depth (255, 65535 or 1),
+	 ToZero sets the pixels below the threshold to 0 and leaves the others unchanged,
+	 Truncate clamps the pixels above the threshold to the threshold value.
+	 dst is only reallocated if it does not already have the size and type of src,
+	 so passing the source image (or a view of its buffer) as dst thresholds it in place.
+	 * @param[in] src The CV_8UC1, CV_16UC1 or CV_32FC1 source image.
+	 * @param[out] dst The destination image, of the type of src. May share its buffer with src.
+	 * @param[in] type The thresholding operation.
+	 * @param[in] threshold The threshold value, on the scale of the depth of src (see PixelDepth::fromByte()).
+	 Integer images compare their pixels with it, so a fractional threshold behaves as the next integer, and truncates them to its integer part.
+	 */
+	static void apply(const cv::Mat& src, cv::Mat& dst, Type type, double threshold);
+
+	/**
+	 * @brief Applies luminance-based truncation to a BGR image.
+	 * @details Every pixel whose luminance (0.2126 R + 0.7152 G + 0.0722 B) reaches the threshold
+	 has all of its channels set to the threshold value. The luminance test is done with exact integer weights,
+	 which gives the same decision as the floating point formula for every 8-bit and 16-bit input.
+	 As for apply(), dst may share its buffer with src.
+	 * @param[in] src The CV_8UC3, CV_16UC3 or CV_32FC3 source image.
+	 * @param[out] dst The destination image, of the type of src.
+	 * @param[in] threshold The threshold value, on the scale of the depth of src. Integer images truncate it to its integer part.
+	 */
+	static void truncateColor(const cv::Mat& src, cv::Mat& dst, double threshold);
+
+	/**
+	 * @brief Applies mean-based adaptive thresholding to a single-channel image.
+	 * @details A pixel is set to maxValue when it is brighter than the mean of its blockSize x blockSize neighbourhood
+	 lowered by C percent, and to 0 otherwise. The neighbourhood is clamped to the image borders.
+	 The image is split into row bands that are processed in parallel. Each band keeps a running sum per column,
+	 so the box sum costs O(1) per pixel for any block size and no full-frame integral image is needed.
+	 The arithmetic is done on integers for 8-bit and 16-bit images, and in double precision for float images.
+	 * @param[in] src The CV_8UC1, CV_16UC1 or CV_32FC1 source image.
+	 * @param[out] dst The destination image, of the type of src. It may be the source image, which is then copied first.
+	 * @param[in] maxValue The value given to the pixels that pass the test, on the scale of the depth of src.
+	 * @param[in] blockSize The side of the neighbourhood. Even sizes behave as the next larger odd size.
+	 * @param[in] C The percentage by which the local mean is lowered before the comparison.
+	 */
+	static void adaptive(const cv::Mat& src, cv::Mat& dst, double maxValue, short blockSize, short C);
+
+	/**
+	 * @brief Thresholds a single row of 8-bit pixels.
+	 * @param[in] src The source pixels.
+	 * @param[out] dst The destination pixels. May be equal to src.
+	 * @param[in] width The number of pixels in the row.
+	 * @param[in] type The thresholding operation.
+	 * @param[in] threshold The threshold value.
+	 */
+	static void thresholdRow(const uchar* src, uchar* dst, int width, Type type, short threshold);
+};
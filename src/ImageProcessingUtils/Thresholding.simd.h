@@ -0,0 +1,337 @@
+#pragma once
+
+// The row kernels of ThresholdingEngine, compiled once per CpuDispatch level through Kernels.simd.h.
+
+#include "Simd.h"
+
+#include <opencv2/core.hpp>
+
+namespace IPU_SIMD_NAMESPACE
+{
+	namespace
+	{
+		// v >= t is computed as max(v, t) == v, since SSE2 has no unsigned byte comparison.
+		void binaryRow(const uchar* src, uchar* dst, int width, uchar t)
+		{
+			int x = 0;
+#ifdef IPU_AVX512
+			const __m512i t64 = _mm512_set1_epi8(static_cast<char>(t));
+			for (; x <= width - 64; x += 64)
+			{
+				__m512i v = _mm512_loadu_si512(src + x);
+				_mm512_storeu_si512(dst + x, _mm512_movm_epi8(_mm512_cmpge_epu8_mask(v, t64)));
+			}
+#endif
+#ifdef IPU_AVX2
+			const __m256i t32 = _mm256_set1_epi8(static_cast<char>(t));
+			for (; x <= width - 32; x += 32)
+			{
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x));
+				__m256i mask = _mm256_cmpeq_epi8(_mm256_max_epu8(v, t32), v);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), mask);
+			}
+#endif
+#ifdef IPU_SSE2
+			const __m128i t16 = _mm_set1_epi8(static_cast<char>(t));
+			for (; x <= width - 16; x += 16)
+			{
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+				__m128i mask = _mm_cmpeq_epi8(_mm_max_epu8(v, t16), v);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), mask);
+			}
+#endif
+			for (; x < width; x++)
+				dst[x] = static_cast<uchar>(-(src[x] >= t));
+		}
+
+		void toZeroRow(const uchar* src, uchar* dst, int width, uchar t)
+		{
+			int x = 0;
+#ifdef IPU_AVX512
+			const __m512i t64 = _mm512_set1_epi8(static_cast<char>(t));
+			for (; x <= width - 64; x += 64)
+			{
+				__m512i v = _mm512_loadu_si512(src + x);
+				_mm512_storeu_si512(dst + x, _mm512_maskz_mov_epi8(_mm512_cmpge_epu8_mask(v, t64), v));
+			}
+#endif
+#ifdef IPU_AVX2
+			const __m256i t32 = _mm256_set1_epi8(static_cast<char>(t));
+			for (; x <= width - 32; x += 32)
+			{
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x));
+				__m256i mask = _mm256_cmpeq_epi8(_mm256_max_epu8(v, t32), v);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm256_and_si256(v, mask));
+			}
+#endif
+#ifdef IPU_SSE2
+			const __m128i t16 = _mm_set1_epi8(static_cast<char>(t));
+			for (; x <= width - 16; x += 16)
+			{
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+				__m128i mask = _mm_cmpeq_epi8(_mm_max_epu8(v, t16), v);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_and_si128(v, mask));
+			}
+#endif
+			for (; x < width; x++)
+				dst[x] = src[x] & static_cast<uchar>(-(src[x] >= t));
+		}
+
+		// On a single channel the luminance of a pixel is the pixel itself, so truncation is a plain minimum.
+		void truncateRow(const uchar* src, uchar* dst, int width, uchar t)
+		{
+			int x = 0;
+#ifdef IPU_AVX512
+			const __m512i t64 = _mm512_set1_epi8(static_cast<char>(t));
+			for (; x <= width - 64; x += 64)
+				_mm512_storeu_si512(dst + x, _mm512_min_epu8(_mm512_loadu_si512(src + x), t64));
+#endif
+#ifdef IPU_AVX2
+			const __m256i t32 = _mm256_set1_epi8(static_cast<char>(t));
+			for (; x <= width - 32; x += 32)
+			{
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm256_min_epu8(v, t32));
+			}
+#endif
+#ifdef IPU_SSE2
+			const __m128i t16 = _mm_set1_epi8(static_cast<char>(t));
+			for (; x <= width - 16; x += 16)
+			{
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_min_epu8(v, t16));
+			}
+#endif
+			for (; x < width; x++)
+				dst[x] = src[x] < t ? src[x] : t;
+		}
+
+		// The 16-bit thresholds. SSE2 has neither an unsigned 16-bit comparison nor an unsigned 16-bit minimum, but it saturates:
+		// v >= t exactly when t - v saturates to 0, and min(v, t) = v - (v - t saturated).
+		void binaryRow16(const ushort* src, ushort* dst, int width, ushort t)
+		{
+			int x = 0;
+#ifdef IPU_AVX512
+			const __m512i t32 = _mm512_set1_epi16(static_cast<short>(t));
+			for (; x <= width - 32; x += 32)
+			{
+				__m512i v = _mm512_loadu_si512(src + x);
+				_mm512_storeu_si512(dst + x, _mm512_movm_epi16(_mm512_cmpge_epu16_mask(v, t32)));
+			}
+#endif
+#ifdef IPU_AVX2
+			const __m256i t16 = _mm256_set1_epi16(static_cast<short>(t));
+			for (; x <= width - 16; x += 16)
+			{
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x));
+				__m256i mask = _mm256_cmpeq_epi16(_mm256_max_epu16(v, t16), v);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), mask);
+			}
+#endif
+#ifdef IPU_SSE2
+			const __m128i t8 = _mm_set1_epi16(static_cast<short>(t));
+			const __m128i zero = _mm_setzero_si128();
+			for (; x <= width - 8; x += 8)
+			{
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+				__m128i mask = _mm_cmpeq_epi16(_mm_subs_epu16(t8, v), zero);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), mask);
+			}
+#endif
+			for (; x < width; x++)
+				dst[x] = static_cast<ushort>(-(src[x] >= t));
+		}
+
+		void toZeroRow16(const ushort* src, ushort* dst, int width, ushort t)
+		{
+			int x = 0;
+#ifdef IPU_AVX512
+			const __m512i t32 = _mm512_set1_epi16(static_cast<short>(t));
+			for (; x <= width - 32; x += 32)
+			{
+				__m512i v = _mm512_loadu_si512(src + x);
+				_mm512_storeu_si512(dst + x, _mm512_maskz_mov_epi16(_mm512_cmpge_epu16_mask(v, t32), v));
+			}
+#endif
+#ifdef IPU_AVX2
+			const __m256i t16 = _mm256_set1_epi16(static_cast<short>(t));
+			for (; x <= width - 16; x += 16)
+			{
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x));
+				__m256i mask = _mm256_cmpeq_epi16(_mm256_max_epu16(v, t16), v);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm256_and_si256(v, mask));
+			}
+#endif
+#ifdef IPU_SSE2
+			const __m128i t8 = _mm_set1_epi16(static_cast<short>(t));
+			const __m128i zero = _mm_setzero_si128();
+			for (; x <= width - 8; x += 8)
+			{
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+				__m128i mask = _mm_cmpeq_epi16(_mm_subs_epu16(t8, v), zero);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_and_si128(v, mask));
+			}
+#endif
+			for (; x < width; x++)
+				dst[x] = src[x] & static_cast<ushort>(-(src[x] >= t));
+		}
+
+		void truncateRow16(const ushort* src, ushort* dst, int width, ushort t)
+		{
+			int x = 0;
+#ifdef IPU_AVX512
+			const __m512i t32 = _mm512_set1_epi16(static_cast<short>(t));
+			for (; x <= width - 32; x += 32)
+				_mm512_storeu_si512(dst + x, _mm512_min_epu16(_mm512_loadu_si512(src + x), t32));
+#endif
+#ifdef IPU_AVX2
+			const __m256i t16 = _mm256_set1_epi16(static_cast<short>(t));
+			for (; x <= width - 16; x += 16)
+			{
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm256_min_epu16(v, t16));
+			}
+#endif
+#ifdef IPU_SSE2
+			const __m128i t8 = _mm_set1_epi16(static_cast<short>(t));
+			for (; x <= width - 8; x += 8)
+			{
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_sub_epi16(v, _mm_subs_epu16(v, t8)));
+			}
+#endif
+			for (; x < width; x++)
+				dst[x] = src[x] < t ? src[x] : t;
+		}
+
+		// The float thresholds. A binary pixel is 1, the white of float images. NaN fails every comparison,
+		// so it gives 0 for the binary and to-zero thresholds and t once truncated, like the scalar tails.
+		void binaryRow32f(const float* src, float* dst, int width, float t)
+		{
+			int x = 0;
+#ifdef IPU_AVX512
+			const __m512 t16 = _mm512_set1_ps(t);
+			const __m512 one16 = _mm512_set1_ps(1.0f);
+			for (; x <= width - 16; x += 16)
+				_mm512_storeu_ps(dst + x, _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(_mm512_loadu_ps(src + x), t16, _CMP_GE_OQ), one16));
+#endif
+#ifdef IPU_AVX2
+			const __m256 t8 = _mm256_set1_ps(t);
+			const __m256 one8 = _mm256_set1_ps(1.0f);
+			for (; x <= width - 8; x += 8)
+				_mm256_storeu_ps(dst + x, _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(src + x), t8, _CMP_GE_OQ), one8));
+#endif
+#ifdef IPU_SSE2
+			const __m128 t4 = _mm_set1_ps(t);
+			const __m128 one4 = _mm_set1_ps(1.0f);
+			for (; x <= width - 4; x += 4)
+				_mm_storeu_ps(dst + x, _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(src + x), t4), one4));
+#endif
+			for (; x < width; x++)
+				dst[x] = src[x] >= t ? 1.0f : 0.0f;
+		}
+
+		void toZeroRow32f(const float* src, float* dst, int width, float t)
+		{
+			int x = 0;
+#ifdef IPU_AVX512
+			const __m512 t16 = _mm512_set1_ps(t);
+			for (; x <= width - 16; x += 16)
+			{
+				__m512 v = _mm512_loadu_ps(src + x);
+				_mm512_storeu_ps(dst + x, _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(v, t16, _CMP_GE_OQ), v));
+			}
+#endif
+#ifdef IPU_AVX2
+			const __m256 t8 = _mm256_set1_ps(t);
+			for (; x <= width - 8; x += 8)
+			{
+				__m256 v = _mm256_loadu_ps(src + x);
+				_mm256_storeu_ps(dst + x, _mm256_and_ps(_mm256_cmp_ps(v, t8, _CMP_GE_OQ), v));
+			}
+#endif
+#ifdef IPU_SSE2
+			const __m128 t4 = _mm_set1_ps(t);
+			for (; x <= width - 4; x += 4)
+			{
+				__m128 v = _mm_loadu_ps(src + x);
+				_mm_storeu_ps(dst + x, _mm_and_ps(_mm_cmpge_ps(v, t4), v));
+			}
+#endif
+			for (; x < width; x++)
+				dst[x] = src[x] >= t ? src[x] : 0.0f;
+		}
+
+		// min_ps returns its second operand when either is NaN, as the scalar test does
+		void truncateRow32f(const float* src, float* dst, int width, float t)
+		{
+			int x = 0;
+#ifdef IPU_AVX512
+			const __m512 t16 = _mm512_set1_ps(t);
+			for (; x <= width - 16; x += 16)
+				_mm512_storeu_ps(dst + x, _mm512_min_ps(_mm512_loadu_ps(src + x), t16));
+#endif
+#ifdef IPU_AVX2
+			const __m256 t8 = _mm256_set1_ps(t);
+			for (; x <= width - 8; x += 8)
+				_mm256_storeu_ps(dst + x, _mm256_min_ps(_mm256_loadu_ps(src + x), t8));
+#endif
+#ifdef IPU_SSE2
+			const __m128 t4 = _mm_set1_ps(t);
+			for (; x <= width - 4; x += 4)
+				_mm_storeu_ps(dst + x, _mm_min_ps(_mm_loadu_ps(src + x), t4));
+#endif
+			for (; x < width; x++)
+				dst[x] = src[x] < t ? src[x] : t;
+		}
+
+		// 10000 * luminance, with the weights of the Rec. 709 formula. They add up to exactly 10000,
+		// so the comparison against 10000 * threshold matches the floating point test for every 8-bit pixel.
+		void truncateColorRow(const uchar* src, uchar* dst, int width, int limit, uchar value)
+		{
+			for (int x = 0; x < width; x++, src += 3, dst += 3)
+			{
+				int luminance = 722 * src[0] + 7152 * src[1] + 2126 * src[2];
+				uchar mask = static_cast<uchar>(-(luminance >= limit));
+				uchar b = src[0], g = src[1], r = src[2];
+				dst[0] = (b & ~mask) | (value & mask);
+				dst[1] = (g & ~mask) | (value & mask);
+				dst[2] = (r & ~mask) | (value & mask);
+			}
+		}
+
+		// Adds (Sign = 1) or subtracts (Sign = -1) a row of pixels to the column sums of adaptive thresholding.
+		template<int Sign>
+		void accumulateColumns(int* sums, const uchar* row, int width)
+		{
+			int x = 0;
+#ifdef IPU_AVX512
+			for (; x <= width - 16; x += 16)
+			{
+				__m512i s = _mm512_loadu_si512(sums + x);
+				__m512i v = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x)));
+				_mm512_storeu_si512(sums + x, Sign > 0 ? _mm512_add_epi32(s, v) : _mm512_sub_epi32(s, v));
+			}
+#endif
+#ifdef IPU_AVX2
+			for (; x <= width - 8; x += 8)
+			{
+				__m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sums + x));
+				__m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + x)));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(sums + x), Sign > 0 ? _mm256_add_epi32(s, v) : _mm256_sub_epi32(s, v));
+			}
+#endif
+#ifdef IPU_SSE2
+			const __m128i zero = _mm_setzero_si128();
+			for (; x <= width - 4; x += 4)
+			{
+				__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x));
+				__m128i v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int*>(row + x)), zero), zero);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(sums + x), Sign > 0 ? _mm_add_epi32(s, v) : _mm_sub_epi32(s, v));
+			}
+#endif
+			for (; x < width; x++)
+				sums[x] += Sign * row[x];
+		}
+	}
+}
@@ -0,0 +1,65 @@
+#include "ToneMap.h"
+#include "Kernels.h"
+#include "RowBands.h"
+
+void ToneMap::apply(const cv::Mat& src, cv::Mat& dst)
+{
+	switch (src.depth())
+	{
+	case CV_8U:
+		dst = src;
+		break;
+	case CV_16U:
+		apply(src, dst, whitePoint(src));
+		break;
+	case CV_32F:
+		src.convertTo(dst, CV_8U, 255);
+		break;
+	default:
+		CV_Error(cv::Error::StsUnsupportedFormat, "only CV_8U, CV_16U and CV_32F images can be tone mapped");
+	}
+}
+
+void ToneMap::apply(const cv::Mat& src, cv::Mat& dst, int white)
+{
+	CV_Assert(src.depth() == CV_16U && white >= 255 && white <= 65535);
+
+	const cv::Mat source = src;
+
+	// the 8-bit values of a 255 white are the 16-bit values themselves
+	if (white == 255)
+	{
+		source.convertTo(dst, CV_8U);
+		return;
+	}
+
+	// the smallest 16-bit factor that still takes white to 255: with white = 65535 it is 256, so v * 257 maps back to v exactly
+	const ushort scale = static_cast<ushort>((255u * 65536u + white - 1) / white);
+	const int length = source.cols * source.channels();
+	const Kernels& kernels = Kernels::active();
+
+	dst.create(source.size(), CV_8UC(source.channels()));
+
+	RowBands::Traits traits;
+	traits.rowBytes = 3 * length;
+
+	RowBands::run(source.rows, traits, [&](const cv::Range& range) {
+		for (int y = range.start; y < range.end; y++)
+			kernels.toneMapRow16(source.ptr<ushort>(y), dst.ptr<uchar>(y), length, scale);
+		});
+}
+
+int ToneMap::whitePoint(const cv::Mat& src)
+{
+	CV_Assert(src.depth() == CV_16U);
+
+	double brightest = 0;
+	if (!src.empty())
+		cv::minMaxLoc(src.reshape(1), nullptr, &brightest);
+
+	int white = 255;
+	while (white < brightest)
+		white = 2 * white + 1;
+
+	return white;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief Brings 16-bit and float images down to 8 bits for display.
+ * @details The algorithms work at the depth of the frame, and only the image that is displayed goes through the tone map.
+ A 16-bit image is scaled linearly so that its white point becomes 255: every pixel costs one unsigned 16-bit high multiply
+ and a saturating pack, run with SSE2/AVX2/AVX-512 through Kernels. The white point is the largest value of the bit depth
+ the image actually uses, so a 12-bit camera frame packed in 16-bit words is shown with its full contrast, and the 16-bit image
+ of an 8-bit one (every value multiplied by 257) maps back to exactly the 8-bit image.
+ */
+class IMAGEPROCESSINGUTILS_API ToneMap
+{
+public:
+	/**
+	 * @brief Brings an image of any supported depth to 8 bits.
+	 * @details 8-bit images are shared, not copied. 16-bit images are scaled to whitePoint(), float images from [0, 1] to [0, 255],
+	 both with saturation.
+	 * @param[in] src The CV_8U, CV_16U or CV_32F image, with any number of channels.
+	 * @param[out] dst The 8-bit image, with the channels of src. It may be the source image.
+	 */
+	static void apply(const cv::Mat& src, cv::Mat& dst);
+
+	/**
+	 * @brief Scales a 16-bit image so that a given value becomes 255.
+	 * @param[in] src The CV_16U image, with any number of channels.
+	 * @param[out] dst The 8-bit image. It may be the source image.
+	 * @param[in] white The value shown as white, at least 255. The values above it saturate.
+	 */
+	static void apply(const cv::Mat& src, cv::Mat& dst, int white);
+
+	/**
+	 * @brief Finds the white point of a 16-bit image.
+	 * @details It is the smallest 2^b - 1, with b from 8 to 16, that is not below the brightest value of the image:
+	 4095 for a 12-bit frame, 65535 for an image that uses the whole range. The point only moves when the brightest value
+	 crosses a power of two, so the frames of a camera keep the same brightness.
+	 * @param[in] src The CV_16U image.
+	 */
+	static int whitePoint(const cv::Mat& src);
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+// The row kernel of ToneMap, compiled once per CpuDispatch level through Kernels.simd.h.
+
+#include "Simd.h"
+
+#include <opencv2/core.hpp>
+
+namespace IPU_SIMD_NAMESPACE
+{
+	namespace
+	{
+		// out = min((v * scale) >> 16, 255): one unsigned high multiply per pixel, clamped before the signed pack.
+		// SSE2 has no unsigned 16-bit minimum, so the clamp is m - (m - 255 saturated).
+		void toneMapRow16(const ushort* src, uchar* dst, int length, ushort scale)
+		{
+			int i = 0;
+#ifdef IPU_AVX512
+			const __m512i k32 = _mm512_set1_epi16(static_cast<short>(scale));
+			const __m512i white32 = _mm512_set1_epi16(255);
+			for (; i <= length - 32; i += 32)
+			{
+				__m512i m = _mm512_min_epu16(_mm512_mulhi_epu16(_mm512_loadu_si512(src + i), k32), white32);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm512_cvtepi16_epi8(m));
+			}
+#endif
+#ifdef IPU_AVX2
+			const __m256i k16 = _mm256_set1_epi16(static_cast<short>(scale));
+			const __m256i white16 = _mm256_set1_epi16(255);
+			for (; i <= length - 32; i += 32)
+			{
+				__m256i a = _mm256_min_epu16(_mm256_mulhi_epu16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), k16), white16);
+				__m256i b = _mm256_min_epu16(_mm256_mulhi_epu16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 16)), k16), white16);
+				// the pack interleaves the 128-bit lanes of a and b, the permutation puts them back in order
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+			}
+#endif
+#ifdef IPU_SSE2
+			const __m128i k8 = _mm_set1_epi16(static_cast<short>(scale));
+			const __m128i white8 = _mm_set1_epi16(255);
+			for (; i <= length - 16; i += 16)
+			{
+				__m128i a = _mm_mulhi_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), k8);
+				__m128i b = _mm_mulhi_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8)), k8);
+				a = _mm_sub_epi16(a, _mm_subs_epu16(a, white8));
+				b = _mm_sub_epi16(b, _mm_subs_epu16(b, white8));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(a, b));
+			}
+#endif
+			for (; i < length; i++)
+			{
+				const unsigned m = (static_cast<unsigned>(src[i]) * scale) >> 16;
+				dst[i] = static_cast<uchar>(m < 255 ? m : 255);
+			}
+		}
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CacheLine.h"
+
+#include <atomic>
+#include <cstdint>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief A slot holding the latest value from one writer thread for one reader thread, without locks or waits.
+ * @details There are three buffers: the writer owns one, the reader owns another, and the third one is in between.
+ The writer fills its buffer and publishes it by exchanging it with the middle one; the reader takes the middle one by exchanging
+ it with its own, if it was published since. Each side thus always has a buffer to itself, the writer never waits for a slow
+ reader and the reader always gets the newest complete value: the values it was too slow for are overwritten in the middle.
+ The buffers are reused, so a value the writer fills again, like a cv::Mat of the same size, is not reallocated.
+ */
+template<typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() = default;
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	/**
+	 * @brief Gets the buffer of the writer, to fill it. It holds the value the writer published two times before, or the one the reader left.
+	 */
+	T& write()
+	{
+		return buffers[back].value;
+	}
+
+	/**
+	 * @brief Publishes the buffer of the writer, which gets the middle buffer in return.
+	 */
+	void publish()
+	{
+		back = middle.exchange(static_cast<uint8_t>(back | FRESH), std::memory_order_acq_rel) & INDEX;
+	}
+
+	/**
+	 * @brief Takes the value the writer published last, from the reader thread.
+	 * @return Returns false if nothing was published since the last update, in which case read() is the same value.
+	 */
+	bool update()
+	{
+		if (!(middle.load(std::memory_order_relaxed) & FRESH))
+			return false;
+		front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+		return true;
+	}
+
+	/**
+	 * @brief Gets the buffer of the reader, with the value of the last update. The reader may move the value out of it.
+	 */
+	T& read()
+	{
+		return buffers[front].value;
+	}
+
+private:
+	static constexpr uint8_t INDEX = 3;
+	static constexpr uint8_t FRESH = 4;
+
+	struct alignas(CACHE_LINE_SIZE) Buffer
+	{
+		T value{};
+	};
+
+	Buffer buffers[3];
+	// the buffer in between and whether it was published since the reader last took it
+	alignas(CACHE_LINE_SIZE) std::atomic<uint8_t> middle{ 2 };
+	// owned by the writer and the reader
+	alignas(CACHE_LINE_SIZE) uint8_t back = 0;
+	alignas(CACHE_LINE_SIZE) uint8_t front = 1;
+};
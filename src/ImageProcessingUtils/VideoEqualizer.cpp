@@ -0,0 +1,180 @@
+#include "VideoEqualizer.h"
+#include "Histogram.h"
+#include "HsvConverter.h"
+#include "PixelDepth.h"
+#include "RowBands.h"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+namespace
+{
+	// the running histogram is turned back into counts of this total to build the table
+	const double TABLE_PIXELS = 1 << 24;
+
+	// the bin a sampled pixel counts in: its value, or its HSV value in colour
+	template<typename T, bool Color>
+	int levelOf(const T* pixel, const uchar* valueTable)
+	{
+		T level = pixel[0];
+		if constexpr (Color)
+		{
+			level = std::max(std::max(pixel[0], pixel[1]), pixel[2]);
+			if constexpr (std::is_same<T, uchar>::value)
+				return valueTable[level];
+		}
+
+		if constexpr (std::is_same<T, float>::value)
+			return Histogram::wideBin(level);
+		else
+			return level;
+	}
+
+	template<typename T, bool Color>
+	void countSampled(const cv::Mat& src, int stride, const cv::Range& rows, uint32_t* counts)
+	{
+		const int cn = src.channels();
+		const uchar* valueTable = HsvConverter::tables().value;
+
+		for (int r = rows.start; r < rows.end; r++)
+		{
+			const T* row = src.ptr<T>(r * stride);
+			for (int x = 0; x < src.cols; x += stride)
+				counts[levelOf<T, Color>(row + x * cn, valueTable)]++;
+		}
+	}
+
+	// the counts of a table of the running histogram, which only needs its shape
+	template<typename Counts>
+	void countsOf(const std::vector<double>& fractions, Counts& counts)
+	{
+		for (size_t i = 0; i < fractions.size(); i++)
+			counts[i] = static_cast<uint32_t>(std::lround(fractions[i] * TABLE_PIXELS));
+	}
+}
+
+VideoEqualizer::VideoEqualizer(short stride, short drift)
+{
+	configure(stride, drift);
+}
+
+void VideoEqualizer::configure(short stride, short drift)
+{
+	CV_Assert(stride >= 1 && drift >= 0);
+	this->stride = stride;
+	this->drift = drift;
+}
+
+std::vector<uint32_t> VideoEqualizer::sample(const cv::Mat& src, int stride)
+{
+	const int cn = src.channels();
+	CV_Assert(stride >= 1 && PixelDepth::supported(src.depth()) && (cn == 1 || cn == 3 || cn == 4));
+
+	const int bins = src.depth() == CV_8U ? Histogram::BINS : Histogram::WIDE_BINS;
+	const int sampledRows = (src.rows + stride - 1) / stride;
+
+	RowBands::Traits traits;
+	traits.rowBytes = (src.cols + stride - 1) / stride * src.elemSize();
+
+	// every band counts into its own bins, as Histogram::compute() does
+	const std::vector<cv::Range> bands = RowBands::split(sampledRows, traits);
+	std::vector<std::vector<uint32_t>> partial(bands.size(), std::vector<uint32_t>(bins, 0));
+
+	RowBands::forEachBand(bands, [&](int band) {
+		PixelDepth::dispatch(src.depth(), [&](auto pixel) {
+			typedef decltype(pixel) T;
+			if (cn == 1)
+				countSampled<T, false>(src, stride, bands[band], partial[band].data());
+			else
+				countSampled<T, true>(src, stride, bands[band], partial[band].data());
+			});
+		});
+
+	std::vector<uint32_t> result(bins, 0);
+	for (const std::vector<uint32_t>& counts : partial)
+		for (int i = 0; i < bins; i++)
+			result[i] += counts[i];
+
+	return result;
+}
+
+void VideoEqualizer::apply(const cv::Mat& src, cv::Mat& dst)
+{
+	if (src.empty())
+	{
+		dst.create(src.size(), src.type());
+		return;
+	}
+
+	const std::vector<uint32_t> counts = sample(src, stride);
+	const int bins = static_cast<int>(counts.size());
+
+	uint64_t pixels = 0;
+	for (uint32_t count : counts)
+		pixels += count;
+
+	// blend the estimate of the frame into the running histogram, or start it
+	const bool restart = src.type() != type;
+	const double weight = restart ? 1 : BLEND_PERCENT / 100.0;
+	if (restart)
+	{
+		type = src.type();
+		running.assign(bins, 0);
+	}
+	for (int i = 0; i < bins; i++)
+		running[i] += weight * (static_cast<double>(counts[i]) / pixels - running[i]);
+
+	// the total variation distance from the histogram of the table
+	double distance = 0;
+	if (!restart)
+	{
+		for (int i = 0; i < bins; i++)
+			distance += std::abs(running[i] - built[i]);
+		distance /= 2;
+	}
+
+	lastRebuilt = restart || distance * 1000 > drift;
+	if (lastRebuilt)
+	{
+		built = running;
+		if (bins == Histogram::BINS)
+		{
+			Histogram::Bins shape;
+			countsOf(running, shape);
+			Histogram::equalizationLut(Histogram::cumulative(shape), table.data());
+		}
+		else
+		{
+			Histogram::WideBins shape(Histogram::WIDE_BINS);
+			countsOf(running, shape);
+			wideTable.resize(Histogram::WIDE_BINS);
+			Histogram::equalizationLut(Histogram::cumulative(shape), wideTable.data());
+		}
+	}
+
+	if (src.channels() == 1)
+	{
+		if (src.depth() == CV_8U)
+			PointwiseChain::apply(src, table, dst);
+		else
+			PointwiseChain::apply(src, wideTable, dst);
+	}
+	else if (src.depth() == CV_8U)
+		HsvConverter::remapValue(src, table.data(), dst);
+	else
+		HsvConverter::remapValue(src, wideTable.data(), dst);
+}
+
+bool VideoEqualizer::rebuilt() const
+{
+	return lastRebuilt;
+}
+
+void VideoEqualizer::reset()
+{
+	type = -1;
+	running.clear();
+	built.clear();
+	lastRebuilt = false;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "PointwiseChain.h"
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <vector>
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief Histogram equalization of a video, with a table that follows the frames rather than being rebuilt for each of them.
+ * @details Consecutive frames have nearly the same histogram, so counting every pixel of every frame is wasted work
+ and rebuilding the table from each count makes it flicker with the noise of the sensor. Instead, every frame:
+ - estimates its histogram from one pixel in stride x stride, a strided grid over the whole frame;
+ - blends the estimate into a running histogram, which the new frame weighs BLEND_PERCENT percent of;
+ - rebuilds the equalization table from the running histogram only when the running histogram has drifted
+ from the one the table was built from by more than the drift threshold (their total variation distance);
+ - maps the frame through the table in one pass.
+ A colour frame is equalized on its HSV value: the estimate reads max(B, G, R) at the sampled pixels and the table is applied
+ by HsvConverter::remapValue(), so the value plane is never written out, where ProcessingAlgorithms::colorHistogramEqualization()
+ writes it, counts it and maps the frame. The object keeps the state of one stream of frames.
+ */
+class IMAGEPROCESSINGUTILS_API VideoEqualizer
+{
+public:
+	// the weight of a new frame in the running histogram, in percent
+	static const int BLEND_PERCENT = 25;
+
+	/**
+	 * @brief Starts with an empty running histogram.
+	 * @param[in] stride The sampling stride, see configure().
+	 * @param[in] drift The drift threshold, see configure().
+	 */
+	explicit VideoEqualizer(short stride = 4, short drift = 10);
+
+	/**
+	 * @brief Changes the sampling rate and the drift threshold, keeping the running histogram.
+	 * @param[in] stride One pixel in stride x stride is counted, along the rows and the columns. 1 counts every pixel.
+	 * @param[in] drift The total variation distance between the running histogram and the one of the table
+	 that rebuilds the table, in tenths of a percent. 0 rebuilds it whenever the running histogram changes.
+	 */
+	void configure(short stride, short drift);
+
+	/**
+	 * @brief Equalizes the next frame of the stream.
+	 * @details The first frame, and a frame of another type than the previous one, start the running histogram again.
+	 * @param[in] src The CV_8U, CV_16U or CV_32F frame, with 1, 3 or 4 channels.
+	 * @param[out] dst The equalized frame: of the type of src for a single-channel frame, BGR otherwise. It may be the source image.
+	 */
+	void apply(const cv::Mat& src, cv::Mat& dst);
+
+	/**
+	 * @brief Gets whether the last frame rebuilt the table.
+	 */
+	bool rebuilt() const;
+
+	/**
+	 * @brief Forgets the previous frames, so that the next one starts the running histogram again.
+	 */
+	void reset();
+
+	/**
+	 * @brief Counts the pixels of a strided grid of a frame.
+	 * @details Single-channel frames count their pixels, colour frames their HSV value. 8-bit frames have Histogram::BINS bins,
+	 16-bit and float frames Histogram::WIDE_BINS, a float pixel counting in Histogram::wideBin() of its value.
+	 The sampled rows are counted in parallel bands.
+	 * @param[in] src The CV_8U, CV_16U or CV_32F frame, with 1, 3 or 4 channels.
+	 * @param[in] stride The distance between the sampled rows, and between the sampled pixels of a row.
+	 * @return The counts.
+	 */
+	static std::vector<uint32_t> sample(const cv::Mat& src, int stride);
+
+private:
+	short stride;
+	short drift;
+
+	// the type of the frames of the stream, -1 before the first one
+	int type = -1;
+	// the running histogram, and the one the table was built from, as fractions of the pixels
+	std::vector<double> running;
+	std::vector<double> built;
+	PointwiseChain::Table table;
+	PointwiseChain::WideTable wideTable;
+	bool lastRebuilt = false;
+};
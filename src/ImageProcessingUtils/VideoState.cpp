@@ -0,0 +1,8 @@
+#include "VideoState.h"
+
+void VideoState::reset()
+{
+	threshold.reset();
+	grayEqualizer.reset();
+	colorEqualizer.reset();
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "AutoThreshold.h"
+#include "VideoEqualizer.h"
+
+#ifdef IMAGEPROCESSINGUTILS_EXPORTS
+#define IMAGEPROCESSINGUTILS_API __declspec(dllexport)
+#else
+#define IMAGEPROCESSINGUTILS_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief What the stages of a video keep from one frame to the next.
+ * @details The ProcessingGraph of a video is replaced whenever the options change, so the state of a stream lives here,
+ with the caller, and is handed to every run (see ProcessingGraph::setVideoState()).
+ */
+class IMAGEPROCESSINGUTILS_API VideoState
+{
+public:
+	// the histograms the automatic thresholds are smoothed with
+	AutoThreshold threshold;
+	// the running histograms of the grayscale and of the colour equalization
+	VideoEqualizer grayEqualizer;
+	VideoEqualizer colorEqualizer;
+
+	/**
+	 * @brief Forgets the previous frames, when a new stream starts.
+	 */
+	void reset();
+};
@@ -0,0 +1,108 @@
+#include "AsyncDetector.h"
+
+AsyncDetector::AsyncDetector(DetectFunction detect, int interval)
+	: detect(std::move(detect)), interval(interval) {
+	CV_Assert(interval >= 1);
+	worker = std::thread(&AsyncDetector::run, this);
+}
+
+AsyncDetector::~AsyncDetector() {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	wake.notify_all();
+	worker.join();
+}
+
+void AsyncDetector::setInterval(int frames) {
+	CV_Assert(frames >= 1);
+	std::lock_guard<std::mutex> guard(lock);
+	interval = frames;
+}
+
+DetectionMat AsyncDetector::process(const cv::Mat& frame, uint64_t sequence) {
+	std::unique_lock<std::mutex> guard(lock);
+	if (hasFinished) {
+		tracker.update(finished, finishedSequence);
+		finished = DetectionMat();
+		hasFinished = false;
+	}
+
+	// the detector keeps a reference to the frame instead of a copy
+	if (!working && !hasPending && (!everSubmitted || sequence >= lastSubmitted + interval)) {
+		pending = frame;
+		pendingSequence = sequence;
+		hasPending = true;
+		everSubmitted = true;
+		lastSubmitted = sequence;
+		wake.notify_one();
+	}
+
+	return tracker.predict(sequence);
+}
+
+bool AsyncDetector::takeError(std::string& message) {
+	std::lock_guard<std::mutex> guard(lock);
+	if (error.empty())
+		return false;
+	message = error;
+	error.clear();
+	return true;
+}
+
+void AsyncDetector::reset() {
+	std::lock_guard<std::mutex> guard(lock);
+	tracker.reset();
+	pending.release();
+	hasPending = false;
+	hasFinished = false;
+	everSubmitted = false;
+	generation++;
+}
+
+uint64_t AsyncDetector::detected() const {
+	std::lock_guard<std::mutex> guard(lock);
+	return detectedFrames;
+}
+
+void AsyncDetector::run() {
+	std::unique_lock<std::mutex> guard(lock);
+	for (;;) {
+		wake.wait(guard, [this] { return hasPending || stopping; });
+		if (stopping)
+			return;
+
+		cv::Mat image = pending;
+		pending.release();
+		const uint64_t sequence = pendingSequence;
+		const unsigned started = generation;
+		hasPending = false;
+		working = true;
+		guard.unlock();
+
+		DetectionMat result;
+		std::string failure;
+		try {
+			result = detect(image);
+		}
+		catch (const std::exception& e) {
+			failure = e.what();
+		}
+		image.release();
+
+		guard.lock();
+		working = false;
+		detectedFrames++;
+		// a detection of the detector that was replaced meanwhile is not tracked
+		if (started != generation)
+			continue;
+		if (!failure.empty())
+			error = failure;
+		else {
+			finished = result;
+			finishedSequence = sequence;
+			hasFinished = true;
+		}
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "DetectionTracker.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#ifdef OBJECTDETECTION_EXPORTS
+#define OBJECTDETECTION_API __declspec(dllexport)
+#else
+#define OBJECTDETECTION_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief Runs a detector on its own thread, on some of the frames of a video, and tracks the detections on all of them.
+ * @details process() is called for every frame and returns at once. It hands the frame to the detector when the detector is idle
+ and at least interval frames came since the one it detected last, so with an interval of 1 the detector runs whenever it is idle.
+ The detections it finished since are matched with a DetectionTracker, and every frame gets the tracked boxes, moved
+ to it along the velocity of the objects. The frames are thus not slowed down by the detector, whose detections arrive a few
+ frames late and are carried over to the frames in between.
+ The detector only reads the frame: a frame shared with a SharedFrame is copied by whoever writes into it while it is detected.
+ */
+class OBJECTDETECTION_API AsyncDetector {
+public:
+	// the detection of a frame; it may throw, and the message of its exception is reported by takeError()
+	typedef std::function<DetectionMat(const cv::Mat&)> DetectFunction;
+
+	AsyncDetector(DetectFunction detect, int interval = 1);
+	~AsyncDetector();
+
+	AsyncDetector(const AsyncDetector&) = delete;
+	AsyncDetector& operator=(const AsyncDetector&) = delete;
+
+	/**
+	 * @brief Sets the least number of frames from one detected frame to the next, at least 1.
+	 */
+	void setInterval(int frames);
+
+	/**
+	 * @brief Takes the detections finished since the last call, may start the detection of a frame and gets the tracks on it.
+	 * @param[in] frame The frame.
+	 * @param[in] sequence The number of the frame in the video, increasing from one call to the next.
+	 * @return The tracked detections on the frame, with their track ids.
+	 */
+	DetectionMat process(const cv::Mat& frame, uint64_t sequence);
+
+	/**
+	 * @brief Gets the error of the last detection that failed since the last call, if any.
+	 */
+	bool takeError(std::string& message);
+
+	/**
+	 * @brief Forgets the tracks and the detection in flight, when the detector changes. It may be called from any thread.
+	 */
+	void reset();
+
+	/**
+	 * @brief Gets the number of frames detected so far.
+	 */
+	uint64_t detected() const;
+
+private:
+	void run();
+
+	DetectFunction detect;
+	DetectionTracker tracker;
+	std::thread worker;
+	mutable std::mutex lock;
+	std::condition_variable wake;
+	int interval;
+	// the frame handed to the detector, and the sequence number of the last one
+	cv::Mat pending;
+	uint64_t pendingSequence = 0;
+	bool hasPending = false;
+	bool working = false;
+	bool everSubmitted = false;
+	uint64_t lastSubmitted = 0;
+	// the detections finished and not taken yet
+	DetectionMat finished;
+	uint64_t finishedSequence = 0;
+	bool hasFinished = false;
+	std::string error;
+	// incremented by reset(), so the detection in flight is discarded
+	unsigned generation = 0;
+	uint64_t detectedFrames = 0;
+	bool stopping = false;
+};
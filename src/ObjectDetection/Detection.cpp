@@ -10,6 +10,7 @@ Detection::Detection(const Detection& other) {
 	rect = other.getRect();
 	label = other.getLabel();
 	confidence = other.getConfidence();
+	trackId = other.getTrackId();
 	renderEnabled = true;
 	showConfidence = true;
 	shapeColor = cv::Scalar(0, 255, 0);
@@ -17,7 +18,7 @@ Detection::Detection(const Detection& other) {
 
 void Detection::render(cv::Mat& image) const {
 	if (shouldRender()) {
-		std::string text = label;
+		std::string text = trackId >= 0 ? label + " #" + std::to_string(trackId) : label;
 		cv::Size label_size = cv::getTextSize(text, cv::FONT_HERSHEY_SIMPLEX, 0.7, 1.5, 0);
 
 
@@ -72,3 +73,11 @@ cv::Rect Detection::getRect() const {
 void Detection::setRect(const cv::Rect& rect) {
 	this->rect = rect;
 }
+
+int Detection::getTrackId() const {
+	return trackId;
+}
+
+void Detection::setTrackId(int id) {
+	trackId = id;
+}
@@ -22,6 +22,9 @@ public:
 	void setColor(const cv::Scalar& color);
 	cv::Rect getRect() const;
 	void setRect(const cv::Rect& rect);
+	// the identity of the object across frames, given by a DetectionTracker; -1 if the detection is not tracked
+	int getTrackId() const;
+	void setTrackId(int id);
 
 	enum Shape { Rectangle, Circle };
 	Shape shape = Rectangle;
@@ -30,6 +33,7 @@ private:
 	cv::Rect rect;
 	std::string label;
 	double confidence;
+	int trackId = -1;
 	bool renderEnabled;
 	bool showConfidence;
 	cv::Scalar shapeColor;
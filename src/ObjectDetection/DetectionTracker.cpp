@@ -0,0 +1,124 @@
+#include "DetectionTracker.h"
+
+#include <algorithm>
+#include <tuple>
+
+// the variance of the detected boxes around the objects, in squared pixels
+static const float MEASUREMENT_NOISE = 16.f;
+// how much the velocity of an object may change in a frame, as a variance in squared pixels per frame
+static const float PROCESS_NOISE = 1.f;
+// the variance of the velocity of a new track, which is not known until its second detection
+static const float VELOCITY_UNCERTAINTY = 100.f;
+
+DetectionTracker::DetectionTracker(double minIou, int maxMisses)
+	: minIou(minIou), maxMisses(maxMisses) {
+	CV_Assert(minIou > 0 && minIou <= 1 && maxMisses >= 0);
+}
+
+void DetectionTracker::update(const DetectionMat& detections, uint64_t frame) {
+	// move every track to the frame that was detected
+	for (Track& track : tracks) {
+		const float frames = static_cast<float>(frame > track.frame ? frame - track.frame : 0);
+		cv::setIdentity(track.filter.transitionMatrix);
+		for (int i = 0; i < 4; i++)
+			track.filter.transitionMatrix.at<float>(i, i + 4) = frames;
+		cv::setIdentity(track.filter.processNoiseCov, cv::Scalar::all(PROCESS_NOISE * std::max(frames, 1.f)));
+		track.filter.predict();
+		track.frame = std::max(frame, track.frame);
+	}
+
+	// the pairs that overlap enough, the best ones first
+	const std::vector<Detection> found = detections.getAll();
+	std::vector<std::tuple<double, size_t, size_t>> pairs;
+	for (size_t t = 0; t < tracks.size(); t++) {
+		const cv::Rect2d box = boxAt(tracks[t], 0);
+		for (size_t d = 0; d < found.size(); d++) {
+			if (found[d].getLabel() != tracks[t].label)
+				continue;
+			const double iou = intersectionOverUnion(box, found[d].getRect());
+			if (iou >= minIou)
+				pairs.emplace_back(iou, t, d);
+		}
+	}
+	std::sort(pairs.begin(), pairs.end(), [](const auto& a, const auto& b) { return std::get<0>(a) > std::get<0>(b); });
+
+	std::vector<bool> trackMatched(tracks.size(), false);
+	std::vector<bool> detectionMatched(found.size(), false);
+	for (const auto& pair : pairs) {
+		const size_t t = std::get<1>(pair);
+		const size_t d = std::get<2>(pair);
+		if (trackMatched[t] || detectionMatched[d])
+			continue;
+		trackMatched[t] = detectionMatched[d] = true;
+
+		const cv::Rect rect = found[d].getRect();
+		const cv::Mat measurement = (cv::Mat_<float>(4, 1) <<
+			rect.x + rect.width / 2.f, rect.y + rect.height / 2.f, static_cast<float>(rect.width), static_cast<float>(rect.height));
+		tracks[t].filter.correct(measurement);
+		tracks[t].confidence = found[d].getConfidence();
+		tracks[t].misses = 0;
+	}
+
+	for (size_t t = 0; t < tracks.size(); t++)
+		if (!trackMatched[t])
+			tracks[t].misses++;
+	tracks.erase(std::remove_if(tracks.begin(), tracks.end(), [this](const Track& track) { return track.misses > maxMisses; }), tracks.end());
+
+	for (size_t d = 0; d < found.size(); d++)
+		if (!detectionMatched[d])
+			startTrack(found[d], frame);
+}
+
+DetectionMat DetectionTracker::predict(uint64_t frame) const {
+	DetectionMat result;
+	for (const Track& track : tracks) {
+		// a track the last detection did not confirm may have left the frame
+		if (track.misses > 0)
+			continue;
+
+		const cv::Rect2d box = boxAt(track, frame > track.frame ? static_cast<double>(frame - track.frame) : 0.0);
+		std::shared_ptr<Detection> detection = std::make_shared<Detection>(cv::Rect(box), track.label, track.confidence);
+		detection->setTrackId(track.id);
+		result.add(detection);
+	}
+	return result;
+}
+
+void DetectionTracker::reset() {
+	tracks.clear();
+}
+
+size_t DetectionTracker::size() const {
+	return tracks.size();
+}
+
+double DetectionTracker::intersectionOverUnion(const cv::Rect2d& a, const cv::Rect2d& b) {
+	const double intersection = (a & b).area();
+	const double united = a.area() + b.area() - intersection;
+	return united > 0 ? intersection / united : 0;
+}
+
+cv::Rect2d DetectionTracker::boxAt(const Track& track, double frames) {
+	const cv::Mat& state = track.filter.statePost;
+	const double x = state.at<float>(0) + state.at<float>(4) * frames;
+	const double y = state.at<float>(1) + state.at<float>(5) * frames;
+	const double width = std::max(1.0, state.at<float>(2) + state.at<float>(6) * frames);
+	const double height = std::max(1.0, state.at<float>(3) + state.at<float>(7) * frames);
+	return cv::Rect2d(x - width / 2, y - height / 2, width, height);
+}
+
+void DetectionTracker::startTrack(const Detection& detection, uint64_t frame) {
+	Track track{ nextId++, detection.getLabel(), detection.getConfidence(), cv::KalmanFilter(8, 4, 0, CV_32F), frame, 0 };
+
+	// the detections measure the box, not its velocity
+	cv::setIdentity(track.filter.measurementMatrix);
+	cv::setIdentity(track.filter.measurementNoiseCov, cv::Scalar::all(MEASUREMENT_NOISE));
+	cv::setIdentity(track.filter.errorCovPost, cv::Scalar::all(MEASUREMENT_NOISE));
+	for (int i = 4; i < 8; i++)
+		track.filter.errorCovPost.at<float>(i, i) = VELOCITY_UNCERTAINTY;
+
+	const cv::Rect rect = detection.getRect();
+	track.filter.statePost = (cv::Mat_<float>(8, 1) <<
+		rect.x + rect.width / 2.f, rect.y + rect.height / 2.f, static_cast<float>(rect.width), static_cast<float>(rect.height), 0, 0, 0, 0);
+	tracks.push_back(std::move(track));
+}
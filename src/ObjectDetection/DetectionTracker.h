@@ -0,0 +1,73 @@
+#pragma once
+#include "DetectionMat.h"
+
+#include <opencv2/video/tracking.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef OBJECTDETECTION_EXPORTS
+#define OBJECTDETECTION_API __declspec(dllexport)
+#else
+#define OBJECTDETECTION_API __declspec(dllimport)
+#endif
+
+/**
+ * @brief Follows the detected objects from one detection to the next, so they keep an identity and can be drawn on the frames in between.
+ * @details Every track has a constant velocity Kalman filter over the centre and the size of its box. When new detections arrive,
+ the tracks are predicted to the frame that was detected and matched to the detections of the same label greedily, by decreasing
+ intersection over union. A matched track is corrected by its detection, a detection no track matches starts a new track, and a
+ track that goes unmatched for more than maxMisses detections is forgotten. A track keeps its id for as long as it lives.
+ The frames are counted by their sequence numbers, so the detections may come from any frame and at any interval.
+ */
+class OBJECTDETECTION_API DetectionTracker {
+public:
+	/**
+	 * @param[in] minIou The smallest intersection over union of a track and a detection that are matched.
+	 * @param[in] maxMisses The number of detections in a row a track may go unmatched before it is forgotten.
+	 */
+	DetectionTracker(double minIou = 0.3, int maxMisses = 2);
+
+	/**
+	 * @brief Matches the detections of a frame with the tracks.
+	 * @param[in] detections The detections, whose boxes are in the coordinates of the frame.
+	 * @param[in] frame The sequence number of the frame that was detected, not before the one of the last update.
+	 */
+	void update(const DetectionMat& detections, uint64_t frame);
+
+	/**
+	 * @brief Gets the tracks matched by the last update, moved at their velocity to a frame, with their ids.
+	 * @param[in] frame The sequence number of the frame to draw the tracks on.
+	 */
+	DetectionMat predict(uint64_t frame) const;
+
+	/**
+	 * @brief Forgets every track, when the detections start over, like with another detector. The ids keep counting.
+	 */
+	void reset();
+
+	size_t size() const;
+
+	static double intersectionOverUnion(const cv::Rect2d& a, const cv::Rect2d& b);
+
+private:
+	struct Track {
+		int id;
+		std::string label;
+		double confidence;
+		// the state is the centre, the width and the height of the box, followed by their velocities in pixels per frame
+		cv::KalmanFilter filter;
+		// the frame the state is at
+		uint64_t frame;
+		int misses;
+	};
+
+	static cv::Rect2d boxAt(const Track& track, double frames);
+
+	void startTrack(const Detection& detection, uint64_t frame);
+
+	std::vector<Track> tracks;
+	int nextId = 0;
+	double minIou;
+	int maxMisses;
+};
@@ -0,0 +1,338 @@
+#include "CppUnitTest.h"
+#include "../src/ImageProcessingUtils/FrameRing.h"
+#include "../src/ImageProcessingUtils/FramePipeline.h"
+#include "../src/ImageProcessingUtils/SpscRing.h"
+#include "../src/ImageProcessingUtils/MpmcQueue.h"
+#include "../src/ImageProcessingUtils/TripleBuffer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+namespace DetectionAppTests
+{
+	TEST_CLASS(ConcurrencyTests)
+	{
+	public:
+		TEST_METHOD(FrameRing_test)
+		{
+			FrameRing ring(2);
+			FrameRing::Frame frame;
+			Assert::IsFalse(ring.takeLatest(frame));
+
+			auto capture = [&ring](int value) {
+				cv::Mat& image = ring.beginWrite().image.reuse();
+				image.create(4, 4, CV_8UC1);
+				image.setTo(cv::Scalar(value));
+				const uchar* data = image.data;
+				ring.publish();
+				return data;
+			};
+
+			// the consumer gets the newest frame, and the ones it skipped are dropped
+			for (int value = 1; value <= 5; value++)
+				capture(value);
+			Assert::IsTrue(ring.takeLatest(frame));
+			Assert::IsTrue(frame.sequence == 5);
+			Assert::AreEqual(5, static_cast<int>(frame.image.mat().at<uchar>(0, 0)));
+			Assert::IsTrue(ring.dropped() == 4);
+			Assert::IsFalse(ring.takeLatest(frame));
+
+			// the buffer the consumer hands back is captured into again, without allocating
+			const uchar* returned = frame.image.mat().data;
+			const std::chrono::steady_clock::time_point before = frame.timestamp;
+			capture(6);
+			Assert::IsTrue(ring.takeLatest(frame));
+			Assert::IsTrue(frame.timestamp >= before);
+			capture(7);
+			Assert::IsTrue(capture(8) == returned);
+
+			// a frame the consumer still shares is not written into
+			const SharedFrame kept = frame.image;
+			capture(9);
+			Assert::IsTrue(ring.takeLatest(frame));
+			capture(10);
+			Assert::IsTrue(capture(11) != kept.mat().data);
+			Assert::AreEqual(6, static_cast<int>(kept.mat().at<uchar>(0, 0)));
+
+			// with a producer thread, every frame is either taken or dropped
+			FrameRing threaded(3);
+			std::thread producer([&threaded] {
+				for (int value = 0; value < 1000; value++)
+				{
+					threaded.beginWrite().image.reuse().create(8, 8, CV_8UC1);
+					threaded.publish();
+				}
+				threaded.close();
+				});
+			uint64_t taken = 0;
+			for (;;)
+			{
+				if (threaded.waitLatest(frame, std::chrono::milliseconds(1000)))
+					taken++;
+				else if (threaded.closed())
+					break;
+			}
+			if (threaded.takeLatest(frame))
+				taken++;
+			producer.join();
+			Assert::IsTrue(taken + threaded.dropped() == threaded.published());
+			Assert::IsTrue(frame.sequence == 1000);
+		}
+
+		TEST_METHOD(FramePipeline_test)
+		{
+			// a full queue that drops keeps the newest items, one that blocks keeps them all
+			BoundedQueue<int> dropping(2, Backpressure::DropOldest);
+			for (int value = 1; value <= 5; value++)
+				Assert::IsTrue(dropping.push(value));
+			int value = 0;
+			Assert::IsTrue(dropping.tryPop(value));
+			Assert::AreEqual(4, value);
+			QueueMetrics metrics = dropping.metrics();
+			Assert::IsTrue(metrics.depth == 1 && metrics.peak == 2 && metrics.pushed == 5 && metrics.dropped == 3);
+
+			BoundedQueue<int> blocking(1, Backpressure::Block);
+			std::thread producer([&blocking] {
+				for (int value = 1; value <= 100; value++)
+					blocking.push(value);
+				blocking.close();
+				});
+			int sum = 0;
+			while (blocking.pop(value))
+				sum += value;
+			producer.join();
+			Assert::AreEqual(5050, sum);
+			Assert::IsTrue(blocking.metrics().dropped == 0);
+			Assert::IsFalse(blocking.push(1));
+
+			// the stages run in order on every item, and a stage that drops an item stops it
+			FramePipeline<std::vector<int>> pipeline;
+			pipeline.addStage("first", [](std::vector<int>& item) {
+				item.push_back(1);
+				return item.front() % 2 == 0;
+				}, 1, 2, Backpressure::Block);
+			pipeline.addStage("second", [](std::vector<int>& item) {
+				item.push_back(2);
+				return true;
+				}, 2, 2, Backpressure::Block);
+			pipeline.setOutput(100, Backpressure::Block);
+			pipeline.start();
+			for (int value = 0; value < 20; value++)
+				Assert::IsTrue(pipeline.submit({ value }));
+
+			int taken = 0;
+			std::vector<int> item;
+			while (taken < 10 && pipeline.take(item, std::chrono::milliseconds(1000)))
+			{
+				Assert::IsTrue(item.size() == 3 && item[0] % 2 == 0 && item[1] == 1 && item[2] == 2);
+				taken++;
+			}
+			Assert::AreEqual(10, taken);
+
+			// the items still queued when the pipeline stops are discarded, and counted as dropped
+			pipeline.stop();
+			const std::vector<FramePipeline<std::vector<int>>::StageMetrics> stages = pipeline.metrics();
+			Assert::IsTrue(stages.size() == 3);
+			Assert::IsTrue(stages[0].name == "first" && stages[0].queue.pushed == 20 && stages[0].queue.depth == 0);
+			Assert::IsTrue(stages[0].processed + stages[0].queue.dropped == 20);
+			Assert::IsTrue(stages[2].name == "output" && stages[2].queue.pushed >= 10);
+			Assert::IsFalse(pipeline.submit({ 0 }));
+
+			// a stage busy with an item when the pipeline stops finishes it, but starts on none of the items behind it
+			std::mutex latchLock;
+			std::condition_variable latchChanged;
+			bool started = false, released = false;
+			FramePipeline<int> blocked;
+			blocked.addStage("slow", [&](int&) {
+				std::unique_lock<std::mutex> guard(latchLock);
+				started = true;
+				latchChanged.notify_all();
+				latchChanged.wait(guard, [&] { return released; });
+				return true;
+				}, 1, 4, Backpressure::Block);
+			blocked.start();
+			for (int value = 0; value < 3; value++)
+				Assert::IsTrue(blocked.submit(value));
+			{
+				std::unique_lock<std::mutex> guard(latchLock);
+				latchChanged.wait(guard, [&] { return started; });
+			}
+
+			std::thread stopper([&blocked] { blocked.stop(); });
+			while (blocked.metrics()[0].queue.depth != 0)
+				std::this_thread::yield();
+			{
+				std::lock_guard<std::mutex> guard(latchLock);
+				released = true;
+			}
+			latchChanged.notify_all();
+			stopper.join();
+
+			const std::vector<FramePipeline<int>::StageMetrics> slow = blocked.metrics();
+			Assert::IsTrue(slow[0].processed == 1 && slow[0].queue.dropped == 2);
+		}
+
+		TEST_METHOD(SpscRing_test)
+		{
+			SpscRing<SharedFrame> ring(3);
+			SharedFrame frame(cv::Mat(4, 4, CV_8UC3, cv::Scalar::all(7)));
+			const uchar* pixels = frame.mat().data;
+
+			// the frame travels as a handle, and a full ring leaves the item with the caller
+			for (int i = 0; i < 3; i++)
+			{
+				SharedFrame copy = frame;
+				Assert::IsTrue(ring.tryPush(std::move(copy)));
+			}
+			Assert::IsFalse(ring.tryPush(std::move(frame)));
+			Assert::IsFalse(frame.empty());
+			Assert::IsTrue(ring.size() == 3);
+
+			SharedFrame popped;
+			Assert::IsTrue(ring.tryPop(popped));
+			Assert::IsTrue(popped.mat().data == pixels);
+			while (ring.tryPop(popped));
+			Assert::IsTrue(ring.size() == 0);
+
+			// a producer and a consumer hand over every item, in order, with no lock
+			const int count = 1000000;
+			SpscRing<int> numbers(64);
+			std::thread producer([&numbers] {
+				for (int value = 0; value < count; value++)
+					while (!numbers.tryPush(std::move(value)))
+						std::this_thread::yield();
+				});
+			bool ordered = true;
+			for (int expected = 0; expected < count; )
+			{
+				int value;
+				if (!numbers.tryPop(value))
+				{
+					std::this_thread::yield();
+					continue;
+				}
+				ordered = ordered && value == expected;
+				expected++;
+			}
+			producer.join();
+			Assert::IsTrue(ordered);
+		}
+
+		TEST_METHOD(MpmcQueue_test)
+		{
+			MpmcQueue<int> small(3);
+			Assert::IsTrue(small.capacity() == 4);
+			for (int value = 0; value < 4; value++)
+				Assert::IsTrue(small.tryPush(std::move(value)));
+			int extra = 4;
+			Assert::IsFalse(small.tryPush(std::move(extra)));
+
+			// a batch takes the oldest items in order, as many as there are
+			std::vector<int> batch;
+			Assert::IsTrue(small.popBatch(std::back_inserter(batch), 3) == 3);
+			Assert::IsTrue(batch == std::vector<int>({ 0, 1, 2 }));
+			Assert::IsTrue(small.popBatch(std::back_inserter(batch), 3) == 1);
+			Assert::IsTrue(small.popBatch(std::back_inserter(batch), 3) == 0);
+
+			// several producers and consumers, some of them popping in batches: every item comes out exactly once,
+			// and the items of one producer come out in the order it pushed them
+			const int producers = 4, consumers = 4, count = 200000;
+			MpmcQueue<int> queue(256);
+			std::vector<std::vector<int>> received(consumers);
+			std::atomic<int> remaining{ producers * count };
+			std::vector<std::thread> threads;
+			for (int p = 0; p < producers; p++)
+				threads.emplace_back([&queue, p] {
+					for (int i = 0; i < count; i++)
+					{
+						int value = p * count + i;
+						while (!queue.tryPush(std::move(value)))
+							std::this_thread::yield();
+					}
+					});
+			for (int c = 0; c < consumers; c++)
+				threads.emplace_back([&queue, &received, &remaining, c] {
+					int items[16];
+					while (remaining > 0)
+					{
+						const size_t taken = c % 2 ? queue.popBatch(items, 16) : queue.tryPop(items[0]);
+						if (taken == 0)
+							std::this_thread::yield();
+						received[c].insert(received[c].end(), items, items + taken);
+						remaining -= static_cast<int>(taken);
+					}
+					});
+			for (std::thread& thread : threads)
+				thread.join();
+
+			std::vector<int> seen(producers * count, 0);
+			bool ordered = true;
+			for (const std::vector<int>& items : received)
+			{
+				std::vector<int> last(producers, -1);
+				for (int value : items)
+				{
+					seen[value]++;
+					ordered = ordered && value % count > last[value / count];
+					last[value / count] = value % count;
+				}
+			}
+			Assert::IsTrue(ordered);
+			Assert::IsTrue(std::all_of(seen.begin(), seen.end(), [](int times) { return times == 1; }));
+		}
+
+		TEST_METHOD(TripleBuffer_test)
+		{
+			TripleBuffer<cv::Mat> slot;
+			Assert::IsFalse(slot.update());
+
+			// the reader gets the newest value, and a buffer the writer fills again keeps its memory
+			slot.write().create(4, 4, CV_8UC1);
+			const uchar* first = slot.write().data;
+			slot.write().setTo(1);
+			slot.publish();
+			slot.write().create(4, 4, CV_8UC1);
+			slot.write().setTo(2);
+			slot.publish();
+			Assert::IsTrue(slot.update());
+			Assert::AreEqual(2, static_cast<int>(slot.read().at<uchar>(0, 0)));
+			Assert::IsFalse(slot.update());
+			slot.write().create(4, 4, CV_8UC1);
+			Assert::IsTrue(slot.write().data == first);
+
+			// with a writer thread, the reader sees complete values that never go back in time
+			TripleBuffer<std::vector<int>> values;
+			std::atomic<bool> done{ false };
+			std::thread writer([&values, &done] {
+				for (int value = 1; value <= 200000; value++)
+				{
+					values.write().assign(16, value);
+					values.publish();
+				}
+				done = true;
+				});
+			bool consistent = true;
+			int latest = 0;
+			for (;;)
+			{
+				const bool finished = done;
+				if (values.update())
+				{
+					const std::vector<int>& value = values.read();
+					consistent = consistent && std::all_of(value.begin(), value.end(), [&value](int v) { return v == value.front(); })
+						&& value.front() > latest;
+					latest = value.front();
+				}
+				else if (finished)
+					break;
+			}
+			writer.join();
+			Assert::IsTrue(consistent);
+			Assert::AreEqual(200000, latest);
+		}
+	};
+}
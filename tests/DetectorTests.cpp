@@ -1,7 +1,12 @@
 #include "CppUnitTest.h"
 #include "../src/ObjectDetection/FaceDetector.h"
 #include "../src/ObjectDetection/ObjectDetector.h"
+#include "../src/ObjectDetection/AsyncDetector.h"
 #include "TestUtils.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 namespace DetectionAppTests
@@ -40,5 +45,149 @@ namespace DetectionAppTests
 			int result = detector.init();
 			Assert::AreEqual(1, result);
 		}
+
+		TEST_METHOD(DetectionTracker_test)
+		{
+			// a person walking 4 pixels per frame and a parked car, detected every 5 frames
+			auto detectAt = [](int frame, bool car) {
+				DetectionMat detections;
+				std::shared_ptr<Detection> person = std::make_shared<Detection>(cv::Rect(100 + 4 * frame, 100, 50, 100), "person", 0.9);
+				detections.add(person);
+				if (car) {
+					std::shared_ptr<Detection> parked = std::make_shared<Detection>(cv::Rect(300, 300, 80, 40), "car", 0.8);
+					detections.add(parked);
+				}
+				return detections;
+			};
+			auto find = [](const DetectionMat& tracked, const std::string& label) {
+				for (const Detection& detection : tracked.getAll())
+					if (detection.getLabel() == label)
+						return detection;
+				return Detection(cv::Rect(), "", 0);
+			};
+
+			DetectionTracker tracker(0.3, 2);
+			for (int frame = 0; frame <= 15; frame += 5)
+				tracker.update(detectAt(frame, true), frame);
+
+			// the tracks keep their ids, and the frames in between get the boxes moved along the velocity of the objects
+			const DetectionMat between = tracker.predict(18);
+			Assert::AreEqual(0, find(between, "person").getTrackId());
+			Assert::AreEqual(1, find(between, "car").getTrackId());
+			Assert::IsTrue(std::abs(find(between, "person").getRect().x - (100 + 4 * 18)) <= 2);
+			Assert::IsTrue(find(between, "car").getRect().x == 300);
+
+			// a track the detections miss is no longer drawn, and forgotten after maxMisses detections
+			tracker.update(detectAt(20, false), 20);
+			Assert::IsTrue(tracker.predict(20).getAll().size() == 1 && tracker.size() == 2);
+			tracker.update(detectAt(25, true), 25);
+			Assert::AreEqual(1, find(tracker.predict(25), "car").getTrackId());
+			for (int frame = 30; frame <= 40; frame += 5)
+				tracker.update(detectAt(frame, false), frame);
+			Assert::IsTrue(tracker.size() == 1);
+			tracker.update(detectAt(45, true), 45);
+			Assert::AreEqual(2, find(tracker.predict(45), "car").getTrackId());
+			Assert::AreEqual(0, find(tracker.predict(45), "person").getTrackId());
+
+			// a detection of another label does not continue a track
+			DetectionMat other;
+			std::shared_ptr<Detection> truck = std::make_shared<Detection>(cv::Rect(300, 300, 80, 40), "truck", 0.8);
+			other.add(truck);
+			tracker.update(other, 50);
+			Assert::AreEqual(3, find(tracker.predict(50), "truck").getTrackId());
+		}
+
+		TEST_METHOD(AsyncDetector_test)
+		{
+			// the detector finds a person at the column the frame holds, 2 pixels further on every frame
+			std::atomic<int> calls{ 0 };
+			AsyncDetector detector([&calls](const cv::Mat& image) {
+				calls++;
+				DetectionMat detections;
+				std::shared_ptr<Detection> person = std::make_shared<Detection>(cv::Rect(static_cast<int>(image.at<float>(0)), 50, 40, 80), "person", 0.9);
+				detections.add(person);
+				return detections;
+				}, 4);
+
+			for (uint64_t sequence = 0; sequence < 40; sequence++) {
+				cv::Mat frame(1, 1, CV_32F);
+				frame.at<float>(0) = 100.f + 2 * sequence;
+				const std::vector<Detection> tracked = detector.process(frame, sequence).getAll();
+				if (sequence > 0) {
+					Assert::IsTrue(tracked.size() == 1 && tracked[0].getTrackId() == 0);
+					if (sequence > 8)
+						Assert::IsTrue(std::abs(tracked[0].getRect().x - (100 + 2 * static_cast<int>(sequence))) <= 2);
+				}
+				// every 4th frame is detected: wait for it, so the test does not depend on the speed of the threads
+				while (detector.detected() < sequence / 4 + 1)
+					std::this_thread::yield();
+			}
+			Assert::AreEqual(10, calls.load());
+
+			detector.reset();
+			cv::Mat frame(1, 1, CV_32F);
+			frame.at<float>(0) = 0;
+			Assert::IsTrue(detector.process(frame, 40).empty());
+
+			// the error of the detector is reported once
+			AsyncDetector failing([](const cv::Mat&) -> DetectionMat { throw std::runtime_error("no model"); }, 1);
+			failing.process(frame, 0);
+			while (failing.detected() < 1)
+				std::this_thread::yield();
+			std::string error;
+			Assert::IsTrue(failing.takeError(error));
+			Assert::IsTrue(error == "no model");
+			Assert::IsFalse(failing.takeError(error));
+		}
+
+		TEST_METHOD(AsyncDetector_slow_detector_test)
+		{
+			// every detection blocks until the test releases it, so the frames that come meanwhile find the detector busy
+			std::mutex latchLock;
+			std::condition_variable latchChanged;
+			int started = 0, released = 0;
+			AsyncDetector detector([&](const cv::Mat&) {
+				std::unique_lock<std::mutex> guard(latchLock);
+				const int call = ++started;
+				latchChanged.notify_all();
+				latchChanged.wait(guard, [&] { return released >= call; });
+				return DetectionMat();
+				}, 1);
+
+			auto waitStarted = [&](int calls) {
+				std::unique_lock<std::mutex> guard(latchLock);
+				latchChanged.wait(guard, [&] { return started >= calls; });
+			};
+			auto release = [&](int calls) {
+				std::lock_guard<std::mutex> guard(latchLock);
+				released = calls;
+				latchChanged.notify_all();
+			};
+
+			cv::Mat frame(1, 1, CV_32F);
+			detector.process(frame, 0);
+			waitStarted(1);
+
+			// process() returns while the detection is blocked, and submits none of these frames
+			for (uint64_t sequence = 1; sequence < 30; sequence++)
+				detector.process(frame, sequence);
+			Assert::IsTrue(detector.detected() == 0);
+			{
+				std::lock_guard<std::mutex> guard(latchLock);
+				Assert::AreEqual(1, started);
+			}
+
+			release(1);
+			while (detector.detected() < 1)
+				std::this_thread::yield();
+
+			// the detector is idle again, so the next frame is detected
+			detector.process(frame, 30);
+			waitStarted(2);
+			release(2);
+			while (detector.detected() < 2)
+				std::this_thread::yield();
+			Assert::AreEqual(2, started);
+		}
 	};
 }
\ No newline at end of file
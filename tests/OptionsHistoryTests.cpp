@@ -50,5 +50,24 @@ namespace DetectionAppTests
 			options = history.get();
 			Assert::AreEqual(false, options->getFlipH());
 		}
+
+		TEST_METHOD(AdaptiveParameters_test)
+		{
+			OptionsHistory history;
+			FrameOptions* options = history.get();
+			Assert::AreEqual<short>(11, options->getAdaptiveBlockSize());
+			Assert::AreEqual<short>(2, options->getAdaptiveC());
+
+			history.add(ADAPTIVE_BLOCK_SIZE, 31);
+			history.add(ADAPTIVE_C, 5);
+			options = history.get();
+			Assert::AreEqual<short>(31, options->getAdaptiveBlockSize());
+			Assert::AreEqual<short>(5, options->getAdaptiveC());
+
+			history.undo();
+			options = history.get();
+			Assert::AreEqual<short>(31, options->getAdaptiveBlockSize());
+			Assert::AreEqual<short>(2, options->getAdaptiveC());
+		}
 	};
 }
\ No newline at end of file
@@ -1,6 +1,23 @@
 #include "CppUnitTest.h"
 #include "../src/ImageProcessingUtils/ImageProcessingUtils.h"
+#include "../src/ImageProcessingUtils/AutoThreshold.h"
+#include "../src/ImageProcessingUtils/HsvConverter.h"
+#include "../src/ImageProcessingUtils/Histogram.h"
+#include "../src/ImageProcessingUtils/Convolution.h"
+#include "../src/ImageProcessingUtils/Gradient.h"
+#include "../src/ImageProcessingUtils/Canny.h"
+#include "../src/ImageProcessingUtils/Clahe.h"
+#include "../src/ImageProcessingUtils/Morphology.h"
+#include "../src/ImageProcessingUtils/RowBands.h"
+#include "../src/ImageProcessingUtils/PointwiseChain.h"
+#include "../src/ImageProcessingUtils/ModelImage.h"
+#include "../src/ImageProcessingUtils/StageCache.h"
+#include "../src/ImageProcessingUtils/ProcessingGraph.h"
+#include "../src/ImageProcessingUtils/Kernels.h"
+#include "../src/ImageProcessingUtils/ToneMap.h"
+#include "../src/ImageProcessingUtils/VideoEqualizer.h"
 #include "TestUtils.hpp"
+#include <fstream>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 namespace DetectionAppTests
@@ -18,6 +35,21 @@ public:
 		Assert::IsTrue(RMS_error(output, reference) <= 0.05);
 	}
 
+	TEST_METHOD(BinaryThresholdGrayscaleInPlace_test)
+	{
+		cv::Mat input = cv::imread(test_resource("test_image.jpg"));
+		cv::Mat gray, reference;
+		cv::cvtColor(input, gray, cv::COLOR_BGR2GRAY);
+
+		ProcessingAlgorithms::binaryThresholding(input, reference, 100);
+		cv::cvtColor(reference, reference, cv::COLOR_BGR2GRAY);
+
+		// single-channel input is thresholded in place, without the round trip through BGR
+		ProcessingAlgorithms::binaryThresholding(gray, gray, 100);
+		Assert::AreEqual(1, gray.channels());
+		Assert::AreEqual(0, cv::countNonZero(gray != reference));
+	}
+
 	TEST_METHOD(HistogramEqualization_test)
 	{
 		cv::Mat reference = cv::imread(test_resource("histogram_equalization.png"));
@@ -28,6 +60,506 @@ public:
 		Assert::IsTrue(RMS_error(output, reference) <= 0.05);
 	}
 
+	TEST_METHOD(VideoEqualizer_test)
+	{
+		cv::Mat input = cv::imread(test_resource("test_image.jpg"));
+		cv::Mat gray, expected, actual, difference;
+		cv::cvtColor(input, gray, cv::COLOR_BGR2GRAY);
+
+		// counting every pixel gives the full histogram, and the first frame its plain equalization
+		const Histogram::Bins full = Histogram::compute(gray);
+		const std::vector<uint32_t> sampled = VideoEqualizer::sample(gray, 1);
+		Assert::IsTrue(std::equal(full.begin(), full.end(), sampled.begin()));
+
+		VideoEqualizer equalizer(1, 10);
+		PointwiseChain::Table table;
+		Histogram::equalizationLut(Histogram::cumulative(full), table.data());
+		PointwiseChain::apply(gray, table, expected);
+		equalizer.apply(gray, actual);
+		Assert::IsTrue(equalizer.rebuilt());
+		cv::absdiff(expected, actual, difference);
+		double largest = 0;
+		cv::minMaxLoc(difference, nullptr, &largest);
+		Assert::IsTrue(largest <= 1);
+
+		// once the running histogram has settled on the sampled one, a still scene keeps its table and a change of lighting rebuilds it
+		equalizer.configure(4, 10);
+		for (int frame = 0; frame < 20; frame++)
+			equalizer.apply(gray, actual);
+		Assert::IsFalse(equalizer.rebuilt());
+		cv::Mat brighter = gray + 80;
+		equalizer.apply(brighter, actual);
+		Assert::IsTrue(equalizer.rebuilt());
+
+		// colour frames are equalized on their value and stay in colour
+		VideoEqualizer color;
+		color.apply(input, actual);
+		Assert::AreEqual(CV_8UC3, actual.type());
+	}
+
+	TEST_METHOD(Clahe_test)
+	{
+		// on a size the grid divides, the tables are the ones of cv::CLAHE and the blend only differs on the rounding of halves
+		cv::Mat input = cv::imread(test_resource("test_image.jpg"));
+		cv::Mat gray;
+		cv::cvtColor(input, gray, cv::COLOR_BGR2GRAY);
+		gray = gray(cv::Rect(0, 0, gray.cols / 8 * 8, gray.rows / 8 * 8)).clone();
+
+		cv::Mat expected, actual, difference;
+		cv::createCLAHE(2.0, cv::Size(8, 8))->apply(gray, expected);
+		Clahe::apply(gray, actual, cv::Size(8, 8), 2.0);
+		cv::absdiff(expected, actual, difference);
+		double largest = 0;
+		cv::minMaxLoc(difference, nullptr, &largest);
+		Assert::IsTrue(largest <= 1);
+
+		// any size, in place, keeps the layout of the source
+		ProcessingAlgorithms::clahe(input, input, 5, 30);
+		Assert::AreEqual(CV_8UC3, input.type());
+		cv::Mat deep;
+		gray(cv::Rect(0, 0, 101, 67)).convertTo(deep, CV_16U, 257);
+		Clahe::apply(deep, deep, cv::Size(4, 3), 2.0);
+		Assert::AreEqual(CV_16UC1, deep.type());
+		Assert::AreEqual(101, deep.cols);
+
+		// the grid of a deep image is capped, so its tables stay small, and the graph rejects a finer one
+		cv::Mat capped, coarsest;
+		Clahe::apply(deep, capped, cv::Size(64, 64), 2.0);
+		Clahe::apply(deep, coarsest, cv::Size(Clahe::MAX_DEEP_TILES, Clahe::MAX_DEEP_TILES), 2.0);
+		Assert::AreEqual(0, cv::countNonZero(capped != coarsest));
+		Assert::ExpectException<std::runtime_error>([] { ProcessingGraph(std::vector<ProcessingGraph::Node>{ { CLAHE, { Clahe::MAX_DEEP_TILES + 1, 20 } } }); });
+	}
+
+	TEST_METHOD(AutoThreshold_test)
+	{
+		cv::Mat input = cv::imread(test_resource("test_image.jpg"));
+		cv::Mat gray, binary;
+		cv::cvtColor(input, gray, cv::COLOR_BGR2GRAY);
+		const Histogram::Bins histogram = Histogram::compute(gray);
+
+		// cv::threshold() whitens the pixels above its threshold, AutoThreshold the ones from its threshold on
+		const double otsu = cv::threshold(gray, binary, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+		Assert::IsTrue(std::abs(AutoThreshold::find(histogram, AutoThreshold::Otsu) - (otsu + 1)) <= 1);
+		Assert::AreEqual(static_cast<int>(cv::mean(gray)[0]) + 1, AutoThreshold::find(histogram, AutoThreshold::Mean));
+		Assert::AreEqual(0, AutoThreshold::find(histogram, AutoThreshold::Percentile, 0));
+
+		// two flat levels are split between them
+		cv::Mat levels(40, 40, CV_8UC1, cv::Scalar(50));
+		levels(cv::Rect(0, 0, 40, 10)).setTo(200);
+		const int li = AutoThreshold::find(Histogram::compute(levels), AutoThreshold::Li);
+		Assert::IsTrue(li > 50 && li <= 200);
+		AutoThreshold::apply(levels, levels, AutoThreshold::Percentile, 100);
+		Assert::AreEqual(0, cv::countNonZero(levels));
+
+		// the colour path converts once and returns BGR; the triangle method is triangleThresholding()
+		cv::Mat triangle, automatic;
+		ProcessingAlgorithms::triangleThresholding(input, triangle);
+		ProcessingAlgorithms::autoThresholding(input, automatic, AutoThreshold::Triangle, 0);
+		Assert::AreEqual(CV_8UC3, automatic.type());
+		Assert::AreEqual(0, cv::countNonZero(cv::Mat(triangle != automatic).reshape(1)));
+
+		// a still scene settles on its own histogram, a change of lighting is followed halfway
+		AutoThreshold temporal;
+		Assert::IsTrue(temporal.smooth(histogram, 50) == histogram);
+		Assert::IsTrue(temporal.smooth(histogram, 50) == histogram);
+		const Histogram::Bins brighter = Histogram::compute(gray + 40);
+		const Histogram::Bins blended = temporal.smooth(brighter, 50);
+		Assert::IsTrue(blended != brighter && blended != histogram);
+		temporal.reset();
+		Assert::IsTrue(temporal.smooth(brighter, 50) == brighter);
+	}
+
+	TEST_METHOD(HsvValueRemap_test)
+	{
+		cv::Mat input = cv::imread(test_resource("test_image.jpg"));
+		cv::Mat hsv, roundTrip, remapped;
+
+		uchar identity[256];
+		for (int i = 0; i < 256; i++)
+			identity[i] = static_cast<uchar>(i);
+
+		// the V-only path must give the same pixels as the full conversion to HSV and back
+		HsvConverter::bgrToHsv(input, hsv);
+		HsvConverter::hsvToBgr(hsv, roundTrip);
+		HsvConverter::remapValue(input, identity, remapped);
+		Assert::AreEqual(0, cv::countNonZero(cv::Mat(roundTrip != remapped).reshape(1)));
+	}
+
+	TEST_METHOD(HistogramBins_test)
+	{
+		cv::Mat input = cv::imread(test_resource("test_image.jpg"), cv::IMREAD_GRAYSCALE);
+		Histogram::Bins cdf = Histogram::cumulative(Histogram::compute(input));
+
+		uchar lut[Histogram::BINS];
+		Histogram::equalizationLut(cdf, lut);
+
+		Assert::AreEqual(static_cast<uint32_t>(input.total()), cdf[Histogram::BINS - 1]);
+		Assert::AreEqual(static_cast<uchar>(0), lut[0]);
+		Assert::AreEqual(static_cast<uchar>(255), lut[Histogram::BINS - 1]);
+		for (int i = 1; i < Histogram::BINS; i++)
+			Assert::IsTrue(lut[i - 1] <= lut[i]);
+	}
+
+	TEST_METHOD(BinomialConstantImage_test)
+	{
+		cv::Mat input(64, 48, CV_8UC3, cv::Scalar(10, 128, 250));
+		cv::Mat output;
+
+		// every pixel, including the borders, is a weighted mean of equal values
+		ProcessingAlgorithms::binomial(input, output, 9);
+		Assert::AreEqual(0, cv::countNonZero(cv::Mat(output != input).reshape(1)));
+	}
+
+	TEST_METHOD(ConvolutionIdentityKernel_test)
+	{
+		cv::Mat input = cv::imread(test_resource("test_image.jpg"));
+		cv::Mat expected, output;
+		input.convertTo(expected, CV_32F);
+
+		// radius 2 runs the specialized 3 channel path, radius 5 the runtime fallback
+		for (int radius : { 2, 5 })
+		{
+			std::vector<float> kernel((2 * radius + 1) * (2 * radius + 1), 0.0f);
+			kernel[kernel.size() / 2] = 1.0f;
+
+			Convolution::filter(input, output, kernel.data(), radius);
+			Assert::AreEqual(0.0, cv::norm(output, expected, cv::NORM_INF));
+		}
+	}
+
+	TEST_METHOD(SobelRequestedOutputs_test)
+	{
+		cv::Mat input = cv::imread(test_resource("test_image.jpg"));
+		cv::Mat plain, withOutputs, Gx, magnitude;
+
+		ProcessingAlgorithms::sobel(input, plain, 3);
+		ProcessingAlgorithms::sobel(input, withOutputs, 3, &Gx, nullptr, &magnitude);
+
+		Assert::AreEqual(CV_16SC1, Gx.type());
+		Assert::AreEqual(CV_32FC1, magnitude.type());
+		Assert::AreEqual(32, GradientEngine::scale(1));
+		// the 8-bit magnitude written directly by the sweep matches the one converted from the float output
+		Assert::AreEqual(0, cv::countNonZero(cv::Mat(plain != withOutputs).reshape(1)));
+	}
+
+	TEST_METHOD(CannyWeakChain_test)
+	{
+		// a one pixel wide horizontal ridge of weak magnitude, with a single strong pixel
+		cv::Mat magnitude = cv::Mat::zeros(20, 200, CV_32FC1);
+		cv::Mat direction(20, 200, CV_8UC1, cv::Scalar(GradientEngine::Vertical));
+		magnitude.row(10).setTo(30);
+		magnitude.at<float>(10, 150) = 100;
+
+		cv::Mat classes, edges;
+		CannyDetector::suppressNonMaxima(magnitude, direction, 50, 20, classes);
+		CannyDetector::trackEdges(classes, edges);
+
+		// the whole ridge but its two pixels at each border is followed from the strong pixel
+		Assert::AreEqual(196, cv::countNonZero(edges));
+
+		magnitude.at<float>(10, 150) = 30;
+		CannyDetector::suppressNonMaxima(magnitude, direction, 20, 50, classes);
+		CannyDetector::trackEdges(classes, edges);
+		Assert::AreEqual(0, cv::countNonZero(edges));
+	}
+
+	TEST_METHOD(MorphologyOpening_test)
+	{
+		// a bright square, which the opening keeps, and a bright dot, which it removes
+		cv::Mat input = cv::Mat::zeros(64, 64, CV_8UC1);
+		input(cv::Rect(10, 10, 12, 12)).setTo(200);
+		input.at<uchar>(40, 40) = 200;
+
+		cv::Mat opened, topHat;
+		Morphology::apply(input, opened, Morphology::Open, cv::Size(5, 5));
+		Morphology::apply(input, topHat, Morphology::TopHat, cv::Size(5, 5));
+
+		Assert::AreEqual(144, cv::countNonZero(opened));
+		Assert::AreEqual(0, (int)opened.at<uchar>(40, 40));
+		Assert::AreEqual(1, cv::countNonZero(topHat));
+		Assert::AreEqual(200, (int)topHat.at<uchar>(40, 40));
+	}
+
+	TEST_METHOD(RowBandsSplit_test)
+	{
+		RowBands::Traits traits;
+		traits.halo = 7;
+		traits.rowBytes = 1920 * 3;
+		traits.granularity = 16;
+
+		std::vector<cv::Range> bands = RowBands::split(1080, traits);
+
+		// the bands cover every row once, are multiples of the granularity and at least twice the halo tall
+		int next = 0;
+		for (const cv::Range& band : bands)
+		{
+			Assert::AreEqual(next, band.start);
+			Assert::IsTrue(band.end == 1080 || band.size() % 16 == 0);
+			Assert::IsTrue(band.end == 1080 || band.size() >= 14);
+			next = band.end;
+		}
+		Assert::AreEqual(1080, next);
+	}
+
+	TEST_METHOD(PointwiseChain_test)
+	{
+		cv::Mat input(16, 16, CV_8UC3);
+		for (int y = 0; y < input.rows; y++)
+			for (int x = 0; x < input.cols; x++)
+				input.at<cv::Vec3b>(y, x) = cv::Vec3b(uchar(16 * x), uchar(16 * y), uchar(8 * (x + y)));
+
+		cv::Mat expected;
+		ProcessingAlgorithms::binaryThresholding(input, expected, 60);
+		ProcessingAlgorithms::zeroThresholding(expected, expected, 100);
+		ProcessingAlgorithms::truncate(expected, expected, 150);
+
+		// the three thresholds are applied as one table, with the same result
+		ModelImage fused(input.clone());
+		PointwiseChain chain(fused);
+		chain.threshold(ThresholdingEngine::Binary, 60);
+		chain.threshold(ThresholdingEngine::ToZero, 100);
+		chain.threshold(ThresholdingEngine::Truncate, 150);
+		chain.flush();
+
+		Assert::IsTrue(fused.model() == ModelImage::Gray);
+		fused.convertTo(ModelImage::Bgr);
+		Assert::AreEqual(0, cv::countNonZero(cv::Mat(expected != fused.mat()).reshape(1)));
+	}
+
+	TEST_METHOD(ModelImageAccept_test)
+	{
+		cv::Mat input(8, 8, CV_8UC4, cv::Scalar(10, 20, 30, 255));
+		ModelImage image(input);
+		Assert::IsTrue(image.model() == ModelImage::Bgra);
+
+		// an accepted model is kept as it is, otherwise the image is converted to the closest one
+		image.accept(ModelImage::Bgra | ModelImage::Gray);
+		Assert::IsTrue(image.model() == ModelImage::Bgra);
+		Assert::IsTrue(image.mat().data == input.data);
+
+		image.accept(ModelImage::Gray | ModelImage::Bgr);
+		Assert::IsTrue(image.model() == ModelImage::Bgr);
+		Assert::AreEqual(CV_8UC3, image.mat().type());
+
+		image.accept(ModelImage::Gray);
+		Assert::AreEqual(CV_8UC1, image.mat().type());
+	}
+
+	TEST_METHOD(StageCacheEviction_test)
+	{
+		// room for two 1 KiB entries
+		StageCache cache(2048);
+		std::vector<cv::Mat> found;
+
+		cache.store(1, { cv::Mat(32, 32, CV_8UC1) });
+		cache.store(2, { cv::Mat(32, 32, CV_8UC1) });
+		Assert::IsTrue(cache.find(1, found));
+
+		// the least recently used entry makes room for the new one
+		cache.store(3, { cv::Mat(32, 32, CV_8UC1) });
+		Assert::IsTrue(cache.contains(1));
+		Assert::IsFalse(cache.contains(2));
+		Assert::IsTrue(cache.contains(3));
+		Assert::AreEqual(static_cast<size_t>(2048), cache.size());
+
+		cache.store(4, { cv::Mat(64, 64, CV_8UC1) });
+		Assert::IsFalse(cache.contains(4));
+	}
+
+	TEST_METHOD(StageCacheResume_test)
+	{
+		cv::Mat input = cv::imread(test_resource("test_image.jpg"));
+		FrameOptions options;
+		options.setGrayscaleHistogramEqualization(true);
+		options.setBinomial(1);
+		options.setCanny(1);
+
+		StageCache cache;
+		for (short threshold : { 40, 80, 80 })
+		{
+			cv::Mat cached = input.clone(), expected = input.clone();
+			ProcessingAlgorithms::applyingAlgorithms(cached, &options, threshold, 120, 3, &cache, 7);
+			ProcessingAlgorithms::applyingAlgorithms(expected, &options, threshold, 120, 3);
+
+			// resuming from the cached equalization, binomial and gradient gives the result of the full pipeline
+			Assert::AreEqual(0, cv::countNonZero(cv::Mat(cached != expected).reshape(1)));
+		}
+	}
+
+	TEST_METHOD(ProcessingGraph_test)
+	{
+		cv::Mat input = cv::imread(test_resource("test_image.jpg"));
+		FrameOptions options;
+		options.setGrayscaleHistogramEqualization(true);
+		options.setBinomial(1);
+		options.setCanny(1);
+
+		// the graph of the menu options, saved and loaded, gives the result of applyingAlgorithms
+		const std::string path = (std::filesystem::temp_directory_path() / "processing_graph_test.yaml").string();
+		ProcessingGraph::fromOptions(options, 60, 120, 3).serialize(path);
+		ProcessingGraph graph;
+		graph.deserialize(path);
+		Assert::AreEqual(size_t(3), graph.nodes().size());
+
+		cv::Mat loaded = input.clone(), expected = input.clone();
+		graph.run(loaded);
+		ProcessingAlgorithms::applyingAlgorithms(expected, &options, 60, 120, 3);
+		Assert::AreEqual(0, cv::countNonZero(cv::Mat(loaded != expected).reshape(1)));
+
+		// the graph a caller keeps for a video is only rebuilt when the options change, and gives the same result
+		ProcessingGraph kept;
+		Assert::IsTrue(kept.updateFromOptions(options, 60, 120, 3));
+		Assert::IsFalse(kept.updateFromOptions(options, 60, 120, 3));
+		Assert::IsTrue(kept.updateFromOptions(options, 60, 130, 3));
+		for (int run = 0; run < 2; run++)
+		{
+			cv::Mat reused = input.clone();
+			ProcessingAlgorithms::applyingAlgorithms(reused, &options, 60, 120, 3, nullptr, 0, nullptr, nullptr, &kept);
+			Assert::AreEqual(0, cv::countNonZero(cv::Mat(reused != expected).reshape(1)));
+		}
+
+		// an invalid stage is rejected, and a file with one leaves the graph unchanged
+		Assert::ExpectException<std::runtime_error>([] { ProcessingGraph(std::vector<ProcessingGraph::Node>{ { BINOMIAL, { 64 } } }); });
+		std::ofstream(path) << "%YAML:1.0\n---\ntype: PROCESSING_GRAPH\nstages:\n   - { stage: SOBEL, kernelSize: 3, threshold: 1 }\n";
+		Assert::ExpectException<std::runtime_error>([&] { graph.deserialize(path); });
+		Assert::AreEqual(size_t(3), graph.nodes().size());
+		std::filesystem::remove(path);
+	}
+
+	TEST_METHOD(KernelVariants_test)
+	{
+		// every variant the CPU can run gives the results of the baseline, on row lengths around the vector widths
+		const Kernels& baseline = Kernels::forLevel(CpuDispatch::Baseline);
+		const HsvConverter::Tables& tables = HsvConverter::tables();
+		cv::RNG rng(16);
+
+		for (int level = CpuDispatch::Sse42; level <= CpuDispatch::supported(); level++)
+		{
+			const Kernels& kernels = Kernels::forLevel(static_cast<CpuDispatch::Level>(level));
+			Assert::AreEqual(level, static_cast<int>(kernels.level));
+
+			for (int cols : { 7, 64, 97, 1001 })
+			{
+				cv::Mat a(1, 4 * cols + 64, CV_8UC1), b(a.size(), CV_8UC1), table(1, 256, CV_8UC1);
+				rng.fill(a, cv::RNG::UNIFORM, 0, 256);
+				rng.fill(b, cv::RNG::UNIFORM, 0, 256);
+				rng.fill(table, cv::RNG::UNIFORM, 0, 256);
+				cv::Mat expected(1, 12 * cols, CV_8UC1, cv::Scalar(0)), actual = expected.clone();
+
+				auto compare = [&](auto row) {
+					row(baseline, expected.ptr<uchar>());
+					row(kernels, actual.ptr<uchar>());
+					Assert::AreEqual(0, cv::countNonZero(expected != actual));
+				};
+
+				compare([&](const Kernels& k, uchar* out) { k.binaryRow(a.ptr<uchar>(), out, cols, 100); });
+				compare([&](const Kernels& k, uchar* out) { k.toZeroRow(a.ptr<uchar>(), out, cols, 100); });
+				compare([&](const Kernels& k, uchar* out) { k.truncateRow(a.ptr<uchar>(), out, cols, 100); });
+				compare([&](const Kernels& k, uchar* out) { k.lookupRow(a.ptr<uchar>(), table.ptr<uchar>(), out, cols); });
+				compare([&](const Kernels& k, uchar* out) { k.minRow(a.ptr<uchar>(), b.ptr<uchar>(), out, cols); });
+				compare([&](const Kernels& k, uchar* out) { k.maxRow(a.ptr<uchar>(), b.ptr<uchar>(), out, cols); });
+				compare([&](const Kernels& k, uchar* out) { k.differenceRow(a.ptr<uchar>(), b.ptr<uchar>(), out, cols); });
+				compare([&](const Kernels& k, uchar* out) { k.bgrToHsvRow(a.ptr<uchar>(), out, cols, 4, tables); });
+				compare([&](const Kernels& k, uchar* out) { k.remapValueRow(a.ptr<uchar>(), table.ptr<uchar>(), out, cols, 3, tables); });
+
+				// the CLAHE blend of two tiles across and two down
+				cv::Mat levels(2, 512, CV_32FC1), weights(1, cols, CV_32FC1);
+				rng.fill(levels, cv::RNG::UNIFORM, 0, 256);
+				levels.convertTo(levels, CV_32S);
+				levels.convertTo(levels, CV_32F);
+				rng.fill(weights, cv::RNG::UNIFORM, 0.0f, 1.0f);
+				std::vector<int> left(cols), right(cols);
+				for (int x = 0; x < cols; x++)
+				{
+					left[x] = x < cols / 2 ? 0 : 256;
+					right[x] = x < cols / 3 ? 0 : 256;
+				}
+				compare([&](const Kernels& k, uchar* out) {
+					k.claheRow(a.ptr<uchar>(), out, cols, levels.ptr<float>(0), levels.ptr<float>(1), left.data(), right.data(), weights.ptr<float>(), 0.3f);
+					});
+
+				// the column sums of adaptive thresholding
+				compare([&](const Kernels& k, uchar* out) {
+					std::vector<int> sums(cols, 300);
+					k.addColumns(sums.data(), a.ptr<uchar>(), cols);
+					k.subtractColumns(sums.data(), b.ptr<uchar>(), cols);
+					for (int x = 0; x < cols; x++)
+						out[x] = static_cast<uchar>(sums[x]);
+					});
+
+				// a 5 x 5 float kernel on three channels, compared bit for bit
+				cv::Mat source(5, 3 * (cols + 4), CV_32FC1), kernel(5, 5, CV_32FC1);
+				rng.fill(source, cv::RNG::UNIFORM, 0, 256);
+				rng.fill(kernel, cv::RNG::UNIFORM, -1, 1);
+				compare([&](const Kernels& k, uchar* out) {
+					const float* rows[5];
+					for (int y = 0; y < 5; y++)
+						rows[y] = source.ptr<float>(y) + 6;
+					k.filterRow(2, 3)(rows, kernel.ptr<float>(), reinterpret_cast<float*>(out), 3 * cols, 2, 3);
+					});
+
+				// a 5-tap pass of the 16-bit binomial filter
+				cv::Mat samples(5, cols, CV_16UC1);
+				rng.fill(samples, cv::RNG::UNIFORM, 0, 65536);
+				compare([&](const Kernels& k, uchar* out) {
+					const uint16_t* rows[5];
+					for (int y = 0; y < 5; y++)
+						rows[y] = samples.ptr<uint16_t>(y);
+					const uint16_t weights[5] = { 4096, 16384, 24576, 16384, 4096 };
+					k.weightedSum(5)(rows, weights, 5, reinterpret_cast<uint16_t*>(out), cols);
+					});
+
+				// both derivatives of a radius 2 gradient, with their magnitude and direction
+				cv::Mat pixels(5, cols + 68, CV_8UC1);
+				rng.fill(pixels, cv::RNG::UNIFORM, 0, 256);
+				compare([&](const Kernels& k, uchar* out) {
+					const uchar* rows[5];
+					for (int y = 0; y < 5; y++)
+						rows[y] = pixels.ptr<uchar>(y) + 2;
+					std::vector<int> sumX(cols), sumY(cols);
+					k.derivativeRow(2)(rows, sumX.data(), sumY.data(), cols, nullptr, nullptr, 2);
+					k.derivativeStore(sumX.data(), reinterpret_cast<short*>(out), cols, 4);
+					k.magnitudeRow(sumX.data(), sumY.data(), out + 2 * cols, cols, CV_8U);
+					k.directionRow(sumX.data(), sumY.data(), out + 3 * cols, cols);
+					});
+			}
+		}
+	}
+
+	TEST_METHOD(HighBitDepth_test)
+	{
+		// the 16-bit copy of an 8-bit image, v * 257, gives the 8-bit results scaled by 257, and maps back to it for display
+		cv::Mat gray, deep, floating;
+		cv::cvtColor(cv::imread(test_resource("test_image.jpg")), gray, cv::COLOR_BGR2GRAY);
+		gray.convertTo(deep, CV_16U, 257);
+		gray.convertTo(floating, CV_32F, 1.0 / 255);
+
+		cv::Mat binary8, binary16, expected;
+		ProcessingAlgorithms::binaryThresholding(gray, binary8, 100);
+		ProcessingAlgorithms::binaryThresholding(deep, binary16, 100);
+		binary8.convertTo(expected, CV_16U, 257);
+		Assert::AreEqual(CV_16UC1, binary16.type());
+		Assert::AreEqual(0, cv::countNonZero(binary16 != expected));
+
+		cv::Mat opened8, opened16;
+		Morphology::apply(gray, opened8, Morphology::Open, cv::Size(5, 5));
+		Morphology::apply(deep, opened16, Morphology::Open, cv::Size(5, 5));
+		opened8.convertTo(expected, CV_16U, 257);
+		Assert::AreEqual(0, cv::countNonZero(opened16 != expected));
+
+		cv::Mat display;
+		ToneMap::apply(deep, display);
+		Assert::AreEqual(CV_8UC1, display.type());
+		Assert::AreEqual(0, cv::countNonZero(display != gray));
+		ToneMap::apply(floating, display);
+		Assert::AreEqual(0, cv::countNonZero(display != gray));
+
+		// a 12-bit frame is brightened to the whole 8-bit range
+		cv::Mat twelveBit;
+		gray.convertTo(twelveBit, CV_16U, 16);
+		Assert::AreEqual(4095, ToneMap::whitePoint(twelveBit));
+	}
+
 	TEST_METHOD(AdaptiveThreshold_test)
 	{
 		cv::Mat reference = cv::imread(test_resource("adaptive_thresholding.png"));
@@ -24,5 +24,36 @@ public:
 		Assert::IsTrue(ConvertQImage2Mat(qimgIn, matOut));
 	}
 
+	TEST_METHOD(SharedFrame_test)
+	{
+		cv::Mat matIn = cv::imread(test_resource("test_image.jpg"));
+
+		// a 3-channel frame crosses to Qt in its own layout, without a copy, and keeps its pixels alive
+		QImage qimgOut = SharedFrame(matIn).image();
+		Assert::IsTrue(qimgOut.format() == QImage::Format_BGR888);
+		Assert::IsTrue(qimgOut.constBits() == matIn.data);
+		const cv::Vec3b pixel = matIn.at<cv::Vec3b>(0, 0);
+		matIn.release();
+		Assert::IsTrue(qimgOut.pixel(0, 0) == qRgb(pixel[2], pixel[1], pixel[0]));
+
+		// and comes back without a copy, the cv::Mat keeping the QImage alive
+		SharedFrame frame(qimgOut);
+		const uchar* shared = frame.mat().data;
+		Assert::IsTrue(shared == qimgOut.constBits());
+
+		// writing copies the pixels only while something else shares them
+		frame.writable().setTo(cv::Scalar::all(0));
+		Assert::IsTrue(frame.mat().data != shared);
+		Assert::IsTrue(qimgOut.pixel(0, 0) == qRgb(pixel[2], pixel[1], pixel[0]));
+		const uchar* owned = frame.mat().data;
+		frame.writable().setTo(cv::Scalar::all(255));
+		Assert::IsTrue(frame.mat().data == owned);
+
+		// a QImage handed out by the frame is not written into either
+		const QImage exported = frame.image();
+		frame.writable().setTo(cv::Scalar::all(0));
+		Assert::IsTrue(exported.pixel(0, 0) == qRgb(255, 255, 255));
+	}
+
 	};
 }
\ No newline at end of file
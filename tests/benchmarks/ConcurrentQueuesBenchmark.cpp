@@ -0,0 +1,81 @@
+#include "SharedFrame.h"
+#include "SpscRing.h"
+#include "MpmcQueue.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// the baseline: a deque behind a mutex, bounded like the lock-free queues so a fast producer waits in the same way
+class LockedDeque
+{
+public:
+	explicit LockedDeque(size_t capacity) : capacity(capacity) {}
+
+	bool tryPush(SharedFrame&& item)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (items.size() >= capacity)
+			return false;
+		items.push_back(std::move(item));
+		return true;
+	}
+
+	bool tryPop(SharedFrame& item)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (items.empty())
+			return false;
+		item = std::move(items.front());
+		items.pop_front();
+		return true;
+	}
+
+private:
+	std::mutex lock;
+	std::deque<SharedFrame> items;
+	size_t capacity;
+};
+
+// one producer and one consumer move count handles of a frame through the queue, and the rate is printed
+template<typename Queue>
+static void measure(const char* name, Queue& queue, int count, const SharedFrame& frame)
+{
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::thread producer([&queue, count, &frame] {
+		for (int i = 0; i < count; i++)
+		{
+			SharedFrame item = frame;
+			while (!queue.tryPush(std::move(item)))
+				std::this_thread::yield();
+		}
+		});
+	SharedFrame item;
+	for (int i = 0; i < count; )
+		if (queue.tryPop(item))
+			i++;
+		else
+			std::this_thread::yield();
+	producer.join();
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::printf("%-24s %6.2f million frames/s\n", name, count / seconds / 1e6);
+}
+
+int main(int argc, char* argv[])
+{
+	const int count = argc > 1 ? std::atoi(argv[1]) : 500000;
+	const size_t capacity = 256;
+	const SharedFrame frame(cv::Mat(480, 640, CV_8UC3));
+
+	LockedDeque locked(capacity);
+	measure("std::mutex + std::deque", locked, count, frame);
+	SpscRing<SharedFrame> ring(capacity);
+	measure("SpscRing", ring, count, frame);
+	MpmcQueue<SharedFrame> queue(capacity);
+	measure("MpmcQueue", queue, count, frame);
+	return 0;
+}